@@ -1,13 +1,10 @@
-QT       += core gui
+QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 # CONFIG += c++11
 CONFIG += c++17 console
 
-LIBS += -luser32
-
-
 # The following define makes your compiler emit warnings if you use
 # any Qt feature that has been marked deprecated (the exact warnings
 # depend on your compiler). Please consult the documentation of the
@@ -19,30 +16,93 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# 诊断构建：替换全局 operator new / delete 统计每个线程的堆分配次数，--alloc-check 需要它
+#DEFINES += MKC_ALLOC_COUNTER
+
 SOURCES += \
+    alloccounter.cpp \
+    blockcodec.cpp \
+    capturebackend.cpp \
+    capturefilter.cpp \
     captureengine.cpp \
+    compressedsink.cpp \
+    crc32c.cpp \
+    eventbus.cpp \
+    eventserializer.cpp \
     globalhotkeymanager.cpp \
     hotkeyconfigdialog.cpp \
+    journal.cpp \
+    journalsink.cpp \
+    latencyhistogram.cpp \
+    livestreamsink.cpp \
     main.cpp \
     mainwindow.cpp \
+    mmapsink.cpp \
+    mousepathsimplifier.cpp \
+    recentringsink.cpp \
     recorder.cpp \
+    recordformat.cpp \
+    recordingstats.cpp \
+    recordreader.cpp \
+    recordsink.cpp \
     replaycontrolwidget.cpp \
     replaymanager.cpp \
-    replayworker.cpp
+    replayworker.cpp \
+    segmentmanifest.cpp \
+    sinkfanout.cpp \
+    syntheticbackend.cpp
 
 HEADERS += \
+    alloccounter.h \
+    blockcodec.h \
+    capturebackend.h \
+    capturefilter.h \
     captureengine.h \
+    compressedsink.h \
+    crc32c.h \
+    eventbatch.h \
+    eventbus.h \
+    eventserializer.h \
     globalhotkeymanager.h \
     hotkeyconfigdialog.h \
+    inputcodes.h \
+    inputevent.h \
+    journal.h \
+    journalsink.h \
+    latencyhistogram.h \
+    livestreamsink.h \
     mainwindow.h \
+    mmapsink.h \
+    mousepathsimplifier.h \
+    recentringsink.h \
     recorder.h \
+    recordformat.h \
+    recordingstats.h \
+    recordreader.h \
+    recordsink.h \
     replaycontrolwidget.h \
     replaymanager.h \
-    replayworker.h
+    replayworker.h \
+    segmentmanifest.h \
+    sinkfanout.h \
+    spscring.h \
+    syntheticbackend.h
 
 FORMS += \
     mainwindow.ui
 
+# 捕获后端按平台选择：Windows 低层钩子 / Linux evdev
+win32 {
+    SOURCES += winhookbackend.cpp
+    HEADERS += winhookbackend.h
+    LIBS += -luser32 -ladvapi32
+}
+
+linux {
+    SOURCES += evdevbackend.cpp iouringsink.cpp
+    HEADERS += evdevbackend.h iouringsink.h
+}
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -0,0 +1,126 @@
+#include "alloccounter.h"
+
+#ifdef MKC_ALLOC_COUNTER
+#include <cstdlib>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+static thread_local quint64 t_allocations = 0;
+
+bool AllocCounter::available()
+{
+    return true;
+}
+
+quint64 AllocCounter::threadAllocations()
+{
+    return t_allocations;
+}
+
+static void* countedAlloc(std::size_t size)
+{
+    ++t_allocations;
+    return std::malloc(size ? size : 1);
+}
+
+// 超过默认对齐的类型（alignas(64) 等）走带 std::align_val_t 的重载，必须与 alignedFree 配对
+static void* countedAlignedAlloc(std::size_t size, std::align_val_t align)
+{
+    ++t_allocations;
+    const std::size_t alignment = static_cast<std::size_t>(align);
+#ifdef _MSC_VER
+    return _aligned_malloc(size ? size : 1, alignment);
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, size ? size : 1) != 0)
+        return nullptr;
+    return p;
+#endif
+}
+
+static void alignedFree(void* p)
+{
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size)
+{
+    if (void* p = countedAlloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (void* p = countedAlloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAlloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    if (void* p = countedAlignedAlloc(size, align))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    if (void* p = countedAlignedAlloc(size, align))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return countedAlignedAlloc(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return countedAlignedAlloc(size, align);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(p); }
+
+#else
+
+// 未启用时不替换全局 operator new / delete，计数恒为 0
+bool AllocCounter::available()
+{
+    return false;
+}
+
+quint64 AllocCounter::threadAllocations()
+{
+    return 0;
+}
+
+#endif // MKC_ALLOC_COUNTER
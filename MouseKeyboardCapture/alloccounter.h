@@ -0,0 +1,22 @@
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+#include <QtGlobal>
+
+/**
+ * @brief 堆分配计数（诊断用）
+ * 定义 MKC_ALLOC_COUNTER 编译时（见 .pro），alloccounter.cpp 替换全局的 operator new / delete
+ * （包括带对齐参数的重载，仍转给 malloc / free），每次分配只给当前线程的计数器加一，
+ * 用来验证热路径（例如 EventSerializer）在稳态下没有堆分配。默认不启用，不影响正常构建的分配器。
+ */
+namespace AllocCounter {
+
+// 本次构建是否启用了计数（MKC_ALLOC_COUNTER）
+bool available();
+
+// 当前线程到目前为止经过 operator new 的分配次数
+quint64 threadAllocations();
+
+} // namespace AllocCounter
+
+#endif // ALLOCCOUNTER_H
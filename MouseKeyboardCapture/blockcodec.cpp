@@ -0,0 +1,167 @@
+#include "blockcodec.h"
+#include <QFileInfo>
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace BlockCodec {
+
+static void putU32(char* p, quint32 v)
+{
+    for (int i = 0; i < 4; ++i)
+        p[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+static quint32 getU32(const char* p)
+{
+    quint32 v = 0;
+    for (int i = 0; i < 4; ++i)
+        v |= quint32(static_cast<quint8>(p[i])) << (8 * i);
+    return v;
+}
+
+bool parseConfig(const QString& spec, Config& config)
+{
+    const QStringList parts = spec.split(':');
+    const QString name = parts.value(0).trimmed().toLower();
+    if (name == "none") {
+        config.codec = Stored;
+        return parts.size() == 1;
+    }
+    if (name != "zlib" || parts.size() > 2)
+        return false;
+    config.codec = Zlib;
+    if (parts.size() == 2) {
+        bool ok = false;
+        const int level = parts.at(1).toInt(&ok);
+        if (!ok || level < 1 || level > 9)
+            return false;
+        config.level = level;
+    }
+    return true;
+}
+
+bool isCompressedPath(const QString& path)
+{
+    return QFileInfo(path).suffix().compare("mkrz", Qt::CaseInsensitive) == 0;
+}
+
+bool hasMagic(const QByteArray& data)
+{
+    return data.size() >= 4 && std::memcmp(data.constData(), kMagic, 4) == 0;
+}
+
+QByteArray fileHeader(const Config& config)
+{
+    char header[kFileHeaderBytes];
+    std::memcpy(header, kMagic, 4);
+    header[4] = static_cast<char>(kVersion);
+    header[5] = static_cast<char>(config.codec);
+    header[6] = static_cast<char>(config.level);
+    header[7] = 0;
+    putU32(header + 8, static_cast<quint32>(config.blockSize));
+    return QByteArray(header, kFileHeaderBytes);
+}
+
+QByteArray encodeBlock(const char* data, int size, Codec codec, int level)
+{
+    QByteArray payload;
+    if (codec == Zlib) {
+        payload = qCompress(reinterpret_cast<const uchar*>(data), size, level);
+        if (payload.size() >= size)
+            codec = Stored;
+    }
+    if (codec == Stored)
+        payload = QByteArray::fromRawData(data, size);
+
+    QByteArray block;
+    block.reserve(kBlockHeaderBytes + payload.size());
+    char header[kBlockHeaderBytes];
+    putU32(header, static_cast<quint32>(size));
+    putU32(header + 4, static_cast<quint32>(payload.size()));
+    header[8] = static_cast<char>(codec);
+    block.append(header, kBlockHeaderBytes);
+    block.append(payload.constData(), payload.size());
+    return block;
+}
+
+bool decode(const QByteArray& file, QByteArray& out, QString* error)
+{
+    auto fail = [error](const QString& why) {
+        if (error) *error = why;
+        return false;
+    };
+
+    if (!hasMagic(file) || file.size() < kFileHeaderBytes)
+        return fail("not a .mkrz record file");
+    if (static_cast<quint8>(file.at(4)) != kVersion)
+        return fail(QString("unsupported .mkrz version %1").arg(static_cast<quint8>(file.at(4))));
+
+    // 第一遍：顺序扫描块头，算出每块在输出中的位置
+    struct Block {
+        int offset;       // 在文件中的位置（块头之后）
+        int stored;
+        int raw;
+        quint8 codec;
+        qint64 outOffset;
+    };
+    std::vector<Block> blocks;
+    qint64 total = 0;
+    int pos = kFileHeaderBytes;
+    while (file.size() - pos >= kBlockHeaderBytes) {
+        const char* h = file.constData() + pos;
+        const quint32 raw = getU32(h);
+        const quint32 stored = getU32(h + 4);
+        const quint8 codec = static_cast<quint8>(h[8]);
+        // 写入端从不写空块：全零的块头是 MmapSink 崩溃后留下的预分配尾部，到此为止
+        if (raw == 0 && stored == 0)
+            break;
+        if (stored > static_cast<quint32>(file.size() - pos - kBlockHeaderBytes) || raw > 0x7FFFFFFFu)
+            break;   // 末尾不完整的块
+        if (codec != Stored && codec != Zlib)
+            return fail(QString("unknown .mkrz codec %1").arg(codec));
+        blocks.push_back(Block{ pos + kBlockHeaderBytes, static_cast<int>(stored), static_cast<int>(raw), codec, total });
+        total += raw;
+        pos += kBlockHeaderBytes + static_cast<int>(stored);
+    }
+    if (total > 0x7FFFFFFF)
+        return fail("record too large to load");
+
+    // 第二遍：各块写入输出中互不重叠的区域，多个线程按块号交错领取
+    out.resize(static_cast<int>(total));
+    char* dst = out.data();
+    std::atomic<std::size_t> next{0};
+    std::atomic<bool> corrupt{false};
+    auto work = [&]() {
+        for (std::size_t i = next.fetch_add(1); i < blocks.size(); i = next.fetch_add(1)) {
+            const Block& b = blocks[i];
+            const char* src = file.constData() + b.offset;
+            if (b.codec == Stored) {
+                if (b.stored != b.raw) { corrupt = true; continue; }
+                std::memcpy(dst + b.outOffset, src, static_cast<std::size_t>(b.raw));
+                continue;
+            }
+            const QByteArray raw = qUncompress(reinterpret_cast<const uchar*>(src), b.stored);
+            if (raw.size() != b.raw) { corrupt = true; continue; }
+            std::memcpy(dst + b.outOffset, raw.constData(), static_cast<std::size_t>(b.raw));
+        }
+    };
+
+    const int threads = std::max(1, std::min(QThread::idealThreadCount(), static_cast<int>(blocks.size())));
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; ++t)
+        pool.emplace_back(work);
+    work();
+    for (std::thread& t : pool)
+        t.join();
+
+    if (corrupt)
+        return fail("corrupt .mkrz block");
+    return true;
+}
+
+} // namespace BlockCodec
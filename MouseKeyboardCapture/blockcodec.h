@@ -0,0 +1,52 @@
+#ifndef BLOCKCODEC_H
+#define BLOCKCODEC_H
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * @brief 分块压缩容器（.mkrz）
+ *
+ * 内容是完整的 .mkr 字节流，按固定大小切块后各自压缩，块之间互不依赖：
+ *
+ *   文件头  4 字节魔数 "MKRZ" | 1 字节版本号 | 1 字节默认编解码器 | 1 字节压缩级别 | 1 字节保留 | u32 块大小
+ *   块      u32 原始长度 | u32 存储长度 | 1 字节编解码器 | 存储的数据
+ *
+ * 整数均为小端。每个块记录自己的编解码器，压缩线程忙不过来时块可以不压缩直接存储（Stored）。
+ * 读取时先顺序扫描块头，再并行解压；文件末尾不完整的块被忽略。写入端从不写空块，
+ * 原始长度和存储长度都为 0 的块头（崩溃后留下的零字节预分配区）视为数据结束。
+ */
+namespace BlockCodec {
+
+constexpr char kMagic[4] = { 'M', 'K', 'R', 'Z' };
+constexpr quint8 kVersion = 1;
+constexpr int kFileHeaderBytes = 12;
+constexpr int kBlockHeaderBytes = 9;
+
+enum Codec : quint8 {
+    Stored = 0,
+    Zlib = 1     // qCompress，级别 1（快）~ 9（压缩率高）
+};
+
+struct Config {
+    Codec codec = Zlib;
+    int level = 6;
+    int blockSize = 256 * 1024;   // 每块的原始字节数
+    int threads = 0;              // 压缩线程数，0 表示按 CPU 核数自动选择
+};
+
+// 解析 "none" / "zlib" / "zlib:<level>"
+bool parseConfig(const QString& spec, Config& config);
+bool isCompressedPath(const QString& path);   // .mkrz
+bool hasMagic(const QByteArray& data);
+
+QByteArray fileHeader(const Config& config);
+// 压缩一个块并加上块头；codec 为 Stored 时原样存储，压缩后不比原始数据小时也改为原样存储
+QByteArray encodeBlock(const char* data, int size, Codec codec, int level);
+
+// 解出全部块拼接成原始字节流（多线程并行解压）
+bool decode(const QByteArray& file, QByteArray& out, QString* error = nullptr);
+
+} // namespace BlockCodec
+
+#endif // BLOCKCODEC_H
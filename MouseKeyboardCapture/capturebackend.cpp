@@ -0,0 +1,61 @@
+#include "capturebackend.h"
+#include <QtGlobal>
+#include <QDebug>
+
+#if defined(Q_OS_WIN)
+#include "winhookbackend.h"
+#elif defined(Q_OS_LINUX)
+#include "evdevbackend.h"
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::unique_ptr<CaptureBackend> CaptureBackend::createDefault()
+{
+#if defined(Q_OS_WIN)
+    return std::unique_ptr<CaptureBackend>(new WinHookBackend());
+#elif defined(Q_OS_LINUX)
+    return std::unique_ptr<CaptureBackend>(new EvdevBackend());
+#else
+    return nullptr;
+#endif
+}
+
+// ======================== 捕获线程设置 ========================
+void CaptureBackend::applyThreadConfig() const
+{
+#if defined(Q_OS_WIN)
+    if (threadConfig_.highPriority && !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+        qWarning() << "CaptureBackend: SetThreadPriority failed:" << GetLastError();
+    if (threadConfig_.cpu >= 0) {
+        const DWORD_PTR mask = DWORD_PTR(1) << threadConfig_.cpu;
+        if (threadConfig_.cpu >= int(sizeof(DWORD_PTR) * 8) || !SetThreadAffinityMask(GetCurrentThread(), mask))
+            qWarning() << "CaptureBackend: cannot pin capture thread to CPU" << threadConfig_.cpu;
+    }
+#elif defined(Q_OS_LINUX)
+    if (threadConfig_.highPriority) {
+        // 实时调度需要 CAP_SYS_NICE；没有权限时退而求其次，把本线程的 nice 值调低
+        sched_param param{};
+        param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+        const int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (rc != 0) {
+            const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+            if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), -10) != 0)
+                qWarning() << "CaptureBackend: cannot raise capture thread priority:" << strerror(rc);
+        }
+    }
+    if (threadConfig_.cpu >= 0 && threadConfig_.cpu < CPU_SETSIZE) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(threadConfig_.cpu, &set);
+        const int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0)
+            qWarning() << "CaptureBackend: cannot pin capture thread to CPU" << threadConfig_.cpu << ":" << strerror(rc);
+    }
+#endif
+}
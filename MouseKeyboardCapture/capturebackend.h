@@ -0,0 +1,71 @@
+#ifndef CAPTUREBACKEND_H
+#define CAPTUREBACKEND_H
+
+#include <QString>
+#include <memory>
+#include <vector>
+#include "inputevent.h"
+
+class CaptureEngine;
+
+// 捕获到的输入设备（事件中的 deviceId 对应这里的 id）
+struct InputDeviceInfo {
+    DeviceId id = 0;
+    QString name;          // 设备名称（evdev: EVIOCGNAME）
+    QString path;          // 设备节点
+    bool connected = true; // 运行中被拔出的设备仍保留在列表中，编号不会被其它设备复用
+    bool injected = false; // 程序创建的虚拟设备（uinput 等），它的事件都带 EventFlag::Injected
+};
+
+/**
+ * @brief 捕获后端接口
+ *
+ * CaptureEngine 只负责队列、工作线程和批量分发，具体从哪里拿到输入事件由后端决定：
+ * Windows 上是低层钩子（WH_MOUSE_LL / WH_KEYBOARD_LL），Linux 上是 evdev。
+ *
+ * 约定：后端在 start() 之后只能由「一个」线程调用 CaptureEngine::enqueueMouseEvent /
+ * enqueueKeyEvent（引擎内部是单生产者队列）；stop() 返回后不得再入队。
+ *
+ * 每个后端都在自己专用的捕获线程上运行，不占用 GUI 线程；线程开始时调用 applyThreadConfig()
+ * 设置优先级和 CPU 亲和性，这个线程除了取事件、入队之外什么都不做。
+ */
+class CaptureBackend
+{
+public:
+    struct ThreadConfig {
+        bool highPriority = true;   // 提升捕获线程优先级（Windows: TIME_CRITICAL，Linux: SCHED_FIFO，失败时退回 nice）
+        int cpu = -1;               // 绑定到指定 CPU 核心，-1 表示不绑定
+    };
+
+    virtual ~CaptureBackend() = default;
+
+    // 仅在 start() 之前设置有效
+    void setThreadConfig(const ThreadConfig& config) { threadConfig_ = config; }
+    const ThreadConfig& threadConfig() const { return threadConfig_; }
+
+    // 相对运动模式：鼠标移动记录为设备原始位移（InputCode::RawMotion），滚轮记录为原始滚动量，
+    // 不再记录光标绝对坐标；按钮事件仍带绝对坐标。仅在 start() 之前设置有效
+    virtual bool supportsRelativeMotion() const { return false; }
+    void setRelativeMotion(bool enabled) { relativeMotion_ = enabled; }
+    bool relativeMotion() const { return relativeMotion_; }
+
+    virtual const char* name() const = 0;
+    virtual bool start(CaptureEngine& engine) = 0;
+    virtual void stop() = 0;
+
+    // 本次运行中出现过的所有设备（任意线程可调用）；不区分设备的后端返回空列表
+    virtual std::vector<InputDeviceInfo> devices() const { return {}; }
+
+    // 当前平台的默认后端（Windows: 低层钩子，Linux: evdev），不支持的平台返回 nullptr
+    static std::unique_ptr<CaptureBackend> createDefault();
+
+protected:
+    // 在后端的捕获线程内调用，按 threadConfig() 设置当前线程的优先级和亲和性；失败只打印警告
+    void applyThreadConfig() const;
+
+private:
+    ThreadConfig threadConfig_;
+    bool relativeMotion_ = false;
+};
+
+#endif // CAPTUREBACKEND_H
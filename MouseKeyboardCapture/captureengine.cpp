@@ -1,26 +1,55 @@
 #include "captureengine.h"
+#include "inputcodes.h"
 #include <QDebug>
 #include <QCoreApplication>
-#include <windowsx.h>
+#include <algorithm>
 
-#pragma comment(lib, "user32.lib")
+static bool isMove(const CapturedEvent& e)
+{
+    return e.category == InputCategory::Mouse && e.mouse.type == InputCode::MouseMove;
+}
+
+// 过载合并：绝对移动只保留最新位置；同类相对事件（位移、滚轮）累加，总位移和总滚动量不变
+static bool tryCoalesce(CapturedEvent& last, const CapturedEvent& e)
+{
+    if (last.category != InputCategory::Mouse || e.category != InputCategory::Mouse
+            || last.mouse.type != e.mouse.type || last.mouse.deviceId != e.mouse.deviceId
+            || last.mouse.flags != e.mouse.flags)
+        return false;
+    if (e.mouse.type == InputCode::MouseMove) {
+        last = e;
+        return true;
+    }
+    if (InputCode::isRelative(e.mouse.type)) {
+        last.mouse.x += e.mouse.x;
+        last.mouse.y += e.mouse.y;
+        last.mouse.timestampNs = e.mouse.timestampNs;
+        return true;
+    }
+    return false;
+}
 
 // ======================== 单例实现 ========================
 // 整个进程只有一个引擎，任何地方都能 instance() 拿到它
 CaptureEngine& CaptureEngine::instance()
 {
     // 单例对象 inst 依然在第一次调用 instance() 时被创建，靠“函数内静态变量”本身就能保证唯一实例；
-    // 钩子回调里再次 CaptureEngine::instance() 即可拿到同一个对象，
+    // 捕获后端持有引擎的引用即可入队，
     // 因此根本不需要、也不应该在构造函数里把 this 额外保存到另一个静态指针
     static CaptureEngine inst;
     return inst;
 }
 
 CaptureEngine::CaptureEngine()
-    : mouseHook_(nullptr),
-      keyboardHook_(nullptr),
-      running_(false)
-{}
+    : running_(false)
+{
+    // 因下游积压而睡眠时，由读取方在读走批次后唤醒，不再定时检查下游是否恢复
+    bus_.setReadNotify([this]() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waitingForBus_.load(std::memory_order_relaxed))
+            wakeWorker();
+    });
+}
 
 CaptureEngine::~CaptureEngine()
 {
@@ -28,23 +57,127 @@ CaptureEngine::~CaptureEngine()
 }
 
 // ======================== 启动与停止 ========================
+void CaptureEngine::setMouseSimplification(const MousePathSimplifier::Config& config)
+{
+    if (running_) {
+        qWarning() << "CaptureEngine: simplification settings apply on next start";
+    }
+    simplifierConfig_ = config;
+}
+
+void CaptureEngine::setOverloadConfig(const OverloadConfig& config)
+{
+    if (running_) {
+        qWarning() << "CaptureEngine: cannot change overload policy while running";
+        return;
+    }
+    overload_ = config;
+    if (overload_.maxLag == 0) overload_.maxLag = 1;
+    if (overload_.maxHeld == 0) overload_.maxHeld = 1;
+}
+
+const char* CaptureEngine::policyName(OverloadPolicy policy)
+{
+    switch (policy) {
+    case OverloadPolicy::CoalesceMoves:   return "coalesce";
+    case OverloadPolicy::DropOldestMoves: return "drop-oldest";
+    case OverloadPolicy::Block:           return "block";
+    }
+    return "unknown";
+}
+
+bool CaptureEngine::parsePolicy(const QString& name, OverloadPolicy& out)
+{
+    const QString n = name.trimmed().toLower();
+    if (n == "coalesce")         out = OverloadPolicy::CoalesceMoves;
+    else if (n == "drop-oldest") out = OverloadPolicy::DropOldestMoves;
+    else if (n == "block")       out = OverloadPolicy::Block;
+    else return false;
+    return true;
+}
+
+bool CaptureEngine::parseInjectedPolicy(const QString& name, InjectedPolicy& out)
+{
+    const QString n = name.trimmed().toLower();
+    if (n == "drop")     out = InjectedPolicy::Drop;
+    else if (n == "tag") out = InjectedPolicy::Tag;
+    else return false;
+    return true;
+}
+
+bool CaptureEngine::setCaptureFilter(const QStringList& rules, QString* error)
+{
+    if (running_) {
+        if (error) *error = "cannot change capture filter while running";
+        return false;
+    }
+    return filter_.parse(rules, error);
+}
+
+void CaptureEngine::setBackend(std::unique_ptr<CaptureBackend> backend)
+{
+    if (running_) {
+        qWarning() << "CaptureEngine: cannot switch backend while running";
+        return;
+    }
+    backend_ = std::move(backend);
+}
+
 bool CaptureEngine::start()
 {
     if (running_) return true;
 
-    HINSTANCE hInst = GetModuleHandle(nullptr);
-    mouseHook_ = SetWindowsHookEx(WH_MOUSE_LL, mouseProc, hInst, 0);
-    keyboardHook_ = SetWindowsHookEx(WH_KEYBOARD_LL, keyboardProc, hInst, 0);
-
-    if (!mouseHook_ || !keyboardHook_) {
-        qWarning() << "Failed to install hooks!";
+    if (!backend_)
+        backend_ = CaptureBackend::createDefault();
+    if (!backend_) {
+        qWarning() << "CaptureEngine: no capture backend on this platform";
         return false;
     }
 
+    // 每次启动重新统计
+    simplifier_.setConfig(simplifierConfig_);
+    simplifier_.reset();
+    movesCaptured_ = 0;
+    movesDelivered_ = 0;
+    filtered_ = 0;
+    filter_.resetHits();
+    delivered_ = 0;
+    droppedMouse_ = 0;
+    droppedKey_ = 0;
+    injectedMouse_ = 0;
+    injectedKey_ = 0;
+    injectedDropped_ = 0;
+    mouseHighWater_ = 0;
+    keyHighWater_ = 0;
+    held_.clear();
+    heldHighWater_ = 0;
+    coalescedMoves_ = 0;
+    droppedOldMoves_ = 0;
+    blockWaits_ = 0;
+    blockTimeouts_ = 0;
+    workerWakeups_ = 0;
+    captureToEnqueueHist_.reset();
+    enqueueHist_.reset();
+    dequeueDelayHist_.reset();
+    queueDepthHist_.reset();
+
+    // 先启动工作线程再启动后端，后端一开始产生的事件就有人消费；
+    // 后端在自己的捕获线程上取事件，调用 start() 的线程（通常是 GUI 线程）不参与钩子分发
     running_ = true;
     workerThread_ = std::thread(&CaptureEngine::workerLoop, this);
 
-    qDebug() << "CaptureEngine started.";
+    backend_->setThreadConfig(threadConfig_);
+    if (relativeMotion_ && !backend_->supportsRelativeMotion())
+        qWarning() << "CaptureEngine: backend" << backend_->name() << "has no relative motion mode, recording absolute positions";
+    backend_->setRelativeMotion(relativeMotion_ && backend_->supportsRelativeMotion());
+
+    if (!backend_->start(*this)) {
+        qWarning() << "CaptureEngine: backend" << backend_->name() << "failed to start";
+        stop();
+        return false;
+    }
+
+    qDebug() << "CaptureEngine started with backend" << backend_->name();
     return true;
 }
 
@@ -52,8 +185,17 @@ void CaptureEngine::stop()
 {
     // 确保引擎处于运行状态，避免重复停止
     if (!running_) return;
+
+    // 先停后端：stop() 返回后不再有生产者写入队列
+    if (backend_)
+        backend_->stop();
+
     // 设置 running_ = false，告知 workerLoop 循环应终止
-    running_ = false;
+    // 持锁修改再通知：工作线程的等待没有超时，不能错过这一次唤醒
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        running_ = false;
+    }
 
     // 调用 cv_.notify_all() 唤醒可能处于阻塞等待状态的 workerLoop 线程，使其立即检查 running_ 标志
     cv_.notify_all();
@@ -63,124 +205,286 @@ void CaptureEngine::stop()
     if (workerThread_.joinable())
         workerThread_.join();
 
-    // 卸载鼠标和键盘钩子（UnhookWindowsHookEx），并将钩子句柄置空，避免资源泄漏
-    if (mouseHook_)
-        UnhookWindowsHookEx(mouseHook_);
-    if (keyboardHook_)
-        UnhookWindowsHookEx(keyboardHook_);
-
-    mouseHook_ = nullptr;
-    keyboardHook_ = nullptr;
-
-    qDebug() << "CaptureEngine stopped.";
+    qDebug() << "CaptureEngine stopped. delivered:" << delivered_.load()
+             << "dropped mouse:" << droppedMouse_.load() << "dropped key:" << droppedKey_.load()
+             << "high-water mouse:" << mouseHighWater_.load() << "key:" << keyHighWater_.load()
+             << "moves captured:" << movesCaptured_.load() << "kept:" << movesDelivered_.load();
+    qDebug() << "CaptureEngine overload policy:" << policyName(overload_.policy)
+             << "held high-water:" << heldHighWater_.load()
+             << "coalesced moves:" << coalescedMoves_.load() << "dropped old moves:" << droppedOldMoves_.load()
+             << "block waits:" << blockWaits_.load() << "block timeouts:" << blockTimeouts_.load();
+    qDebug() << "CaptureEngine injected events: mouse" << injectedMouse_.load() << "key" << injectedKey_.load()
+             << "dropped" << injectedDropped_.load();
+    if (!filter_.isEmpty()) {
+        qDebug() << "CaptureEngine filtered:" << filtered_.load();
+        for (const CaptureFilter::RuleHits& h : filter_.hits())
+            qDebug().noquote() << QString("  %1  <- %2").arg(h.hits, 10).arg(h.rule);
+    }
+    for (const EventBus::SubscriberStats& sub : bus_.stats()) {
+        qDebug().noquote() << QString("CaptureEngine subscriber %1 (%2): read %3 events in %4 batches, "
+                                      "skipped %5, lag %6 high-water %7")
+                              .arg(sub.name).arg(sub.delivery == EventBus::Delivery::Lossless ? "lossless" : "lossy")
+                              .arg(sub.events).arg(sub.batches).arg(sub.skippedEvents)
+                              .arg(sub.lagEvents).arg(sub.lagHighWater);
+    }
+    qDebug().noquote() << metricsReport();
 }
 
-// ======================== 鼠标回调 ========================
-// 钩子线程只负责“最快地”把事件塞进队列；
-LRESULT CALLBACK CaptureEngine::mouseProc(int nCode, WPARAM wParam, LPARAM lParam)
+CaptureEngine::Stats CaptureEngine::stats() const
 {
-    if (nCode >= 0 && lParam) {
-        MSLLHOOKSTRUCT* pMouse = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
-        CaptureEngine& engine = CaptureEngine::instance();
-
-        // ====== 节流策略：减少高频WM_MOUSEMOVE ======
-        QPoint pos(pMouse->pt.x, pMouse->pt.y);
-        QDateTime now = QDateTime::currentDateTime();
-
-        if (wParam == WM_MOUSEMOVE) {
-            // 若移动距离小于3像素，或间隔小于5ms，则忽略
-            if ((pos - engine.lastMousePos_).manhattanLength() < 3 &&
-                engine.lastMouseTime_.msecsTo(now) < 5)
-                return CallNextHookEx(nullptr, nCode, wParam, lParam);
-
-            engine.lastMousePos_ = pos;
-            engine.lastMouseTime_ = now;
-        }
-
-        MouseEventData data{ pos, static_cast<DWORD>(wParam), now };
-        engine.enqueueMouseEvent(data);
-    }
-
-    return CallNextHookEx(nullptr, nCode, wParam, lParam);
+    Stats s;
+    s.delivered = delivered_.load(std::memory_order_relaxed);
+    s.droppedMouse = droppedMouse_.load(std::memory_order_relaxed);
+    s.droppedKey = droppedKey_.load(std::memory_order_relaxed);
+    s.mouseHighWater = mouseHighWater_.load(std::memory_order_relaxed);
+    s.keyHighWater = keyHighWater_.load(std::memory_order_relaxed);
+    s.movesCaptured = movesCaptured_.load(std::memory_order_relaxed);
+    s.movesDelivered = movesDelivered_.load(std::memory_order_relaxed);
+    s.filtered = filtered_.load(std::memory_order_relaxed);
+    s.injectedMouse = injectedMouse_.load(std::memory_order_relaxed);
+    s.injectedKey = injectedKey_.load(std::memory_order_relaxed);
+    s.injectedDropped = injectedDropped_.load(std::memory_order_relaxed);
+    s.busLag = bus_.lagEvents();
+    s.heldHighWater = heldHighWater_.load(std::memory_order_relaxed);
+    s.coalescedMoves = coalescedMoves_.load(std::memory_order_relaxed);
+    s.droppedOldMoves = droppedOldMoves_.load(std::memory_order_relaxed);
+    s.blockWaits = blockWaits_.load(std::memory_order_relaxed);
+    s.blockTimeouts = blockTimeouts_.load(std::memory_order_relaxed);
+    s.workerWakeups = workerWakeups_.load(std::memory_order_relaxed);
+    return s;
 }
 
-// ======================== 键盘回调 ========================
-LRESULT CALLBACK CaptureEngine::keyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
+CaptureEngine::Metrics CaptureEngine::metrics() const
 {
-    if (nCode >= 0 && lParam) {
-        KBDLLHOOKSTRUCT* pKey = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
-        CaptureEngine& engine = CaptureEngine::instance();
-
-        bool isDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
-        KeyEventData data{ pKey->vkCode, isDown, QDateTime::currentDateTime() };
-        engine.enqueueKeyEvent(data);
-    }
+    Metrics m;
+    m.captureToEnqueueNs = captureToEnqueueHist_.snapshot();
+    m.enqueueNs = enqueueHist_.snapshot();
+    m.dequeueDelayNs = dequeueDelayHist_.snapshot();
+    m.queueDepth = queueDepthHist_.snapshot();
+    return m;
+}
 
-    return CallNextHookEx(nullptr, nCode, wParam, lParam);
+QString CaptureEngine::metricsReport() const
+{
+    const Metrics m = metrics();
+    return QString("CaptureEngine metrics:\n"
+                   "  capture->enqueue  %1\n"
+                   "  enqueue (1/%2)    %3\n"
+                   "  dequeue delay     %4\n"
+                   "  queue depth       %5")
+            .arg(LatencyHistogram::format(m.captureToEnqueueNs, "ns"))
+            .arg(kEnqueueSampleEvery)
+            .arg(LatencyHistogram::format(m.enqueueNs, "ns"))
+            .arg(LatencyHistogram::format(m.dequeueDelayNs, "ns"))
+            .arg(LatencyHistogram::format(m.queueDepth, ""));
 }
 
 // ======================== 队列操作 ========================
+// 钩子线程是唯一的生产者，直接写入无锁环形队列，不加锁也不分配内存；
+// 队列满说明工作线程严重滞后，此时宁可丢弃事件也不能阻塞整个系统的输入（Block 策略只等待有限时间）
 void CaptureEngine::enqueueMouseEvent(const MouseEventData& data)
 {
-    {
-        std::lock_guard<std::mutex> lock(queueMutex_);
-        mouseQueue_.push(data);
+    if ((data.flags & EventFlag::Injected) && dropInjected(injectedMouse_))
+        return;
+    if (!pushInstrumented(mouseQueue_, data)
+            && !(overload_.policy == OverloadPolicy::Block && waitForSpace(mouseQueue_, data))) {
+        droppedMouse_.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
-    // 唤醒工作线程（无需等待 5 毫秒超时），提高事件处理的实时性
-    cv_.notify_one();
+    wakeWorker();
 }
 
 void CaptureEngine::enqueueKeyEvent(const KeyEventData& data)
 {
-    {
-        std::lock_guard<std::mutex> lock(queueMutex_);
-        keyQueue_.push(data);
+    if ((data.flags & EventFlag::Injected) && dropInjected(injectedKey_))
+        return;
+    if (!pushInstrumented(keyQueue_, data)
+            && !(overload_.policy == OverloadPolicy::Block && waitForSpace(keyQueue_, data))) {
+        droppedKey_.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
-    // 唤醒工作线程（可选，避免等待超时）
-    cv_.notify_one();
+    wakeWorker();
 }
 
 // ======================== 后台处理线程 ========================
-// 工作线程负责批量取出并用 emit 发信号；
+// 两个队列各自按时间有序，做一次二路归并，批次内的鼠标/键盘事件即按真实发生顺序排列
+std::vector<CapturedEvent> CaptureEngine::drainQueues()
+{
+    // 取数前的积压量即队列深度，记录高水位（只有工作线程写，无需 CAS）
+    const std::size_t mouseDepth = mouseQueue_.size();
+    const std::size_t keyDepth = keyQueue_.size();
+    if (mouseDepth > mouseHighWater_.load(std::memory_order_relaxed))
+        mouseHighWater_.store(mouseDepth, std::memory_order_relaxed);
+    if (keyDepth > keyHighWater_.load(std::memory_order_relaxed))
+        keyHighWater_.store(keyDepth, std::memory_order_relaxed);
+    queueDepthHist_.record(mouseDepth + keyDepth);
+
+    // 取数时刻只读一次时钟，整批事件共用
+    const qint64 now = captureTimestampNs();
+
+    std::vector<CapturedEvent> batch;
+    batch.reserve(std::min(mouseDepth + keyDepth, kMaxBatchSize));
+
+    while (batch.size() < kMaxBatchSize) {
+        const MouseEventData* mouse = mouseQueue_.front();
+        const KeyEventData* key = keyQueue_.front();
+        if (!mouse && !key)
+            break;
+
+        if (mouse && (!key || mouse->timestampNs <= key->timestampNs)) {
+            batch.push_back(CapturedEvent::fromMouse(*mouse));
+            mouseQueue_.popFront();
+        } else {
+            batch.push_back(CapturedEvent::fromKey(*key));
+            keyQueue_.popFront();
+        }
+        const qint64 ts = batch.back().timestampNs();
+        if (now > ts)
+            dequeueDelayHist_.record(static_cast<quint64>(now - ts));
+    }
+    return batch;
+}
+
+// 工作线程负责批量取出并发布到总线；
 void CaptureEngine::workerLoop()
 {
     // 循环以 running_ 为标志
     while (running_) {
-        // 条件变量 + 互斥锁实现阻塞等待，避免线程空转浪费 CPU,
-        // 首先锁定互斥锁 queueMutex_，确保对 mouseQueue_、keyQueue_、running_ 的访问是线程安全的
-        std::unique_lock<std::mutex> lock(queueMutex_);
-        // 阻塞当前工作线程，等待以下三种情况之一发生：1 mouseQueue_ 或 keyQueue_ 不为空（有新事件需要处理）；
-        // 2 running_ 被设为 false（线程需要退出）；3 超时（5 毫秒，避免永久阻塞）
-        cv_.wait_for(lock, std::chrono::milliseconds(5), [this] {
-            return !mouseQueue_.empty() || !keyQueue_.empty() || !running_;
-        });
-        // 等待期间，lock 会自动释放互斥锁，允许其他线程（如钩子回调线程）修改队列；当等待被唤醒或超时时，lock 会重新锁定互斥锁，确保后续操作的线程安全。
-
-
-        // 使用 while 而非 if，确保一次性处理队列中所有积压的事件
-        while (!mouseQueue_.empty()) {
-            // 取出队首事件
-            MouseEventData data = mouseQueue_.front();
-            // 移除事件
-            mouseQueue_.pop();
-            // 临时释放锁，避免发送信号时长期占用锁，若持有锁，会阻塞钩子线程向队列中添加新事件，导致事件积压。
-            lock.unlock();
-            // 异步发送信号给Qt主线程，避免了直接在工作线程中操作 UI 导致的线程安全问题（Qt UI 操作必须在主线程）
-            emit mouseEventCaptured(data);
-            // 重新锁定，准备处理下一个事件
-            lock.lock();
+        waitForWork();
+
+        // 出队不需要任何锁：工作线程是两个环形队列唯一的消费者。
+        // 使用 while 而非 if，确保一次性处理队列中所有积压的事件；每个批次只发布一次，
+        // 订阅者从总线取到的只是 EventBatch 内 shared_ptr 的副本，而不是逐个事件排队
+        while (canDrain()) {
+            std::vector<CapturedEvent> events = drainQueues();
+            if (events.empty())
+                break;
+            std::vector<CapturedEvent> simplified;
+            processBatch(events, simplified);
+            deliver(std::move(simplified));
         }
 
-        while (!keyQueue_.empty()) {
-            KeyEventData data = keyQueue_.front();
-            keyQueue_.pop();
-            lock.unlock();
-            emit keyEventCaptured(data);
-            lock.lock();
+        // 队列已空：光标停住一段时间后，把轨迹简化暂存的最后一个点发出去；
+        // 即使没有新事件，下游恢复后也会在这里把过载期间暂存的事件发出
+        std::vector<CapturedEvent> tail;
+        simplifier_.flushIfIdle(captureTimestampNs(), tail);
+        deliver(std::move(tail));
+    }
+
+    // stop() 先停后端再停工作线程，此时队列里剩下的事件不会再增加，全部发出后退出，
+    // 避免遗留到下一次 start()
+    std::vector<CapturedEvent> rest;
+    while (true) {
+        std::vector<CapturedEvent> events = drainQueues();
+        if (events.empty())
+            break;
+        processBatch(events, rest);
+    }
+    simplifier_.flush(rest);
+    deliver(std::move(rest), true);
+}
+
+// 有事可做：新事件且允许取数；或下游已恢复、有暂存的事件要发；或停止
+bool CaptureEngine::hasWork() const
+{
+    if (!running_)
+        return true;
+    if (canDrain() && (!mouseQueue_.empty() || !keyQueue_.empty()))
+        return true;
+    return !held_.empty() && !downstreamBusy();
+}
+
+void CaptureEngine::waitForWork()
+{
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    // 先公布「要睡了」，再检查条件：与 wakeWorker 的「先入队，再检查 sleeping_」构成对称的屏障
+    sleeping_.store(true, std::memory_order_relaxed);
+    waitingForBus_.store(!held_.empty() || !canDrain(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (!hasWork()) {
+        // 只有轨迹简化有暂存点时才需要定时醒来把它发出去，其余情况纯粹等事件
+        const qint64 deadline = simplifier_.idleDeadlineNs();
+        if (deadline > 0) {
+            const qint64 remain = deadline - captureTimestampNs();
+            if (remain > 0)
+                cv_.wait_for(lock, std::chrono::nanoseconds(remain), [this] { return hasWork(); });
+        } else {
+            cv_.wait(lock, [this] { return hasWork(); });
+        }
+        workerWakeups_.fetch_add(1, std::memory_order_relaxed);
+    }
+    sleeping_.store(false, std::memory_order_relaxed);
+    waitingForBus_.store(false, std::memory_order_relaxed);
+}
+
+void CaptureEngine::processBatch(std::vector<CapturedEvent>& events, std::vector<CapturedEvent>& out)
+{
+    // 先过滤再简化：被过滤掉的移动不应该影响简化后保留哪些点
+    if (const std::size_t removed = filter_.apply(events))
+        filtered_.fetch_add(removed, std::memory_order_relaxed);
+    simplifier_.process(events, out);
+}
+
+void CaptureEngine::deliver(std::vector<CapturedEvent>&& events, bool force)
+{
+    const MousePathSimplifier::Stats& s = simplifier_.stats();
+    movesCaptured_.store(s.inputMoves, std::memory_order_relaxed);
+    movesDelivered_.store(s.outputMoves, std::memory_order_relaxed);
+
+    // 下游过载：先暂存，等总线上的积压被读走再一起发布
+    if (!force && downstreamBusy()) {
+        hold(events);
+        return;
+    }
+    if (!held_.empty()) {
+        held_.insert(held_.end(), events.begin(), events.end());
+        events.swap(held_);
+        held_.clear();
+    }
+
+    if (events.empty())
+        return;
+    delivered_.fetch_add(events.size(), std::memory_order_relaxed);
+    // 发布到总线后立即返回：不经过 Qt 事件队列，界面线程忙也不会拖住录制
+    bus_.publish(EventBatch(std::move(events)));
+}
+
+void CaptureEngine::hold(const std::vector<CapturedEvent>& events)
+{
+    const bool coalesce = overload_.policy == OverloadPolicy::CoalesceMoves;
+    for (const CapturedEvent& e : events) {
+        // 只合并相邻的同类移动；中间夹着点击或按键时不合并，保证点击位置准确
+        if (coalesce && !held_.empty() && tryCoalesce(held_.back(), e)) {
+            coalescedMoves_.fetch_add(1, std::memory_order_relaxed);
+            continue;
         }
+        held_.push_back(e);
     }
+
+    // 一次丢掉一半容量的旧移动，避免每来一个事件都搬动整个数组
+    if (overload_.policy == OverloadPolicy::DropOldestMoves && held_.size() > overload_.maxHeld)
+        dropOldestMoves(held_.size() - overload_.maxHeld / 2);
+
+    if (held_.size() > heldHighWater_.load(std::memory_order_relaxed))
+        heldHighWater_.store(held_.size(), std::memory_order_relaxed);
 }
 
+// 只丢弃绝对移动：相对位移丢掉后回放的光标会永久偏移，与按键、按钮一样保留
+void CaptureEngine::dropOldestMoves(std::size_t count)
+{
+    std::size_t kept = 0;
+    std::size_t dropped = 0;
+    for (std::size_t i = 0; i < held_.size(); ++i) {
+        if (dropped < count && isMove(held_[i])) {
+            ++dropped;
+            continue;
+        }
+        held_[kept++] = held_[i];
+    }
+    held_.resize(kept);
+    droppedOldMoves_.fetch_add(dropped, std::memory_order_relaxed);
+}
 
 
 //#include "captureengine.h"
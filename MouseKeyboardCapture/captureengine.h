@@ -4,32 +4,19 @@
 #include <QObject>
 #include <QThread>
 #include <QMutex>
-#include <QPoint>
-#include <QDateTime>
-#include <queue>
 #include <mutex>
 #include <thread>
 #include <atomic>
+#include <memory>
 #include <condition_variable>
-#include <Windows.h>
-
-/**
- * @brief 鼠标事件数据结构
- */
-struct MouseEventData {
-    QPoint pos;        // 鼠标坐标
-    DWORD type;        // 消息类型（WM_MOUSEMOVE 等）
-    QDateTime time;    // 捕获时间
-};
-
-/**
- * @brief 键盘事件数据结构
- */
-struct KeyEventData {
-    DWORD vkCode;      // 虚拟键码
-    bool keyDown;      // true=按下，false=抬起
-    QDateTime time;
-};
+#include "spscring.h"
+#include "inputevent.h"
+#include "eventbatch.h"
+#include "eventbus.h"
+#include "capturebackend.h"
+#include "mousepathsimplifier.h"
+#include "latencyhistogram.h"
+#include "capturefilter.h"
 
 class CaptureEngine : public QObject
 {
@@ -37,41 +24,237 @@ class CaptureEngine : public QObject
 public:
     static CaptureEngine& instance();
 
-    bool start();       // 启动钩子
-    void stop();        // 停止钩子
+    bool start();       // 启动捕获后端和工作线程
+    void stop();        // 停止捕获后端和工作线程
+    bool isRunning() const { return running_; }
+
+    // 捕获结果发布到这条总线；界面、录制等订阅者各自订阅，在自己的线程里读取
+    EventBus& bus() { return bus_; }
+
+    // 替换捕获后端（仅在未运行时生效）；未设置时 start() 使用当前平台的默认后端
+    void setBackend(std::unique_ptr<CaptureBackend> backend);
+    const char* backendName() const { return backend_ ? backend_->name() : "none"; }
+    bool hasBackend() const { return backend_ != nullptr; }
+    // 事件中 deviceId 与设备名称的对应关系（停止后仍可查询，直到下一次 start()）
+    std::vector<InputDeviceInfo> devices() const { return backend_ ? backend_->devices() : std::vector<InputDeviceInfo>(); }
+
+    // 捕获线程的优先级和 CPU 亲和性（下一次 start() 生效），交给后端在它自己的捕获线程上设置
+    void setCaptureThreadConfig(const CaptureBackend::ThreadConfig& config) { threadConfig_ = config; }
+
+    // 相对运动模式（下一次 start() 生效）；后端不支持时退回绝对坐标并给出警告
+    void setRelativeMotion(bool enabled) { relativeMotion_ = enabled; }
+
+    // 捕获过滤规则（语法见 CaptureFilter），仅在未运行时可以修改；空列表表示不过滤
+    bool setCaptureFilter(const QStringList& rules, QString* error = nullptr);
+    std::vector<CaptureFilter::RuleHits> filterHits() const { return filter_.hits(); }
+
+    // 鼠标轨迹简化的误差范围（下一次 start() 生效），epsilonPx <= 0 时关闭简化
+    void setMouseSimplification(const MousePathSimplifier::Config& config);
+
+    // 下游跟不上时的过载策略。总线上 Lossless 订阅者（例如录制）的积压超过 maxLag 即视为过载，
+    // 此时工作线程不再发布新批次，按策略处理积压，内存占用始终有上限；Lossy 订阅者（例如界面）自行丢弃，不参与判断
+    enum class OverloadPolicy {
+        CoalesceMoves,    // 暂存事件，相邻的鼠标移动合并为最新位置
+        DropOldestMoves,  // 暂存事件，超过上限时丢弃最旧的绝对坐标移动；相对位移、按键和鼠标按钮永不丢弃
+        Block             // 停止取数，捕获线程在队列满时等待（有超时），超时后丢弃
+    };
+    struct OverloadConfig {
+        OverloadPolicy policy = OverloadPolicy::CoalesceMoves;
+        quint64 maxLag = 65536;        // Lossless 订阅者已发布、尚未读取的事件上限
+        std::size_t maxHeld = 65536;   // 过载期间工作线程暂存的事件上限
+        int blockTimeoutUs = 1000;     // Block 策略下捕获线程最长等待时间；钩子线程上不宜超过几毫秒
+    };
+    // 仅在未运行时生效
+    void setOverloadConfig(const OverloadConfig& config);
+    static const char* policyName(OverloadPolicy policy);
+    // 解析 "coalesce" / "drop-oldest" / "block"
+    static bool parsePolicy(const QString& name, OverloadPolicy& out);
 
-    // 鼠标事件入队列
+    // 注入事件（EventFlag::Injected，包括本程序回放发出的 SendInput）的处理方式，运行中也可以切换。
+    // 在捕获线程入队之前判断，丢弃的事件不占用队列，录制与回放同时进行时不会形成回路
+    enum class InjectedPolicy {
+        Drop,   // 丢弃（默认）
+        Tag     // 保留，事件带 Injected 标志，录制文件中写为 "injected": true
+    };
+    void setInjectedPolicy(InjectedPolicy policy) { dropInjected_.store(policy == InjectedPolicy::Drop, std::memory_order_relaxed); }
+    InjectedPolicy injectedPolicy() const { return dropInjected_.load(std::memory_order_relaxed) ? InjectedPolicy::Drop : InjectedPolicy::Tag; }
+    // 解析 "drop" / "tag"
+    static bool parseInjectedPolicy(const QString& name, InjectedPolicy& out);
+
+    // 鼠标事件入队列（仅后端的捕获线程调用，无锁，队列满时丢弃并计数）
     void enqueueMouseEvent(const MouseEventData& data);
-    // 键盘事件入队列
+    // 键盘事件入队列（仅后端的捕获线程调用，无锁，队列满时丢弃并计数）
     void enqueueKeyEvent(const KeyEventData& data);
 
-signals:
-    void mouseEventCaptured(const MouseEventData& data);
-    void keyEventCaptured(const KeyEventData& data);
+    // 运行统计（任意线程可读，数值为近似快照）
+    struct Stats {
+        quint64 delivered = 0;       // 已发布到总线的事件数
+        quint64 droppedMouse = 0;    // 因队列满而丢弃的事件数
+        quint64 droppedKey = 0;
+        quint64 mouseHighWater = 0;  // 工作线程取数时观察到的最大积压
+        quint64 keyHighWater = 0;
+        quint64 movesCaptured = 0;   // 采集到的鼠标移动数
+        quint64 movesDelivered = 0;  // 轨迹简化后保留的鼠标移动数
+        quint64 movesSaved() const { return movesCaptured - movesDelivered; }
+        quint64 filtered = 0;        // 被捕获过滤规则丢弃的事件数（各规则的命中数见 filterHits）
+        quint64 injectedMouse = 0;   // 识别出的注入事件（无论丢弃还是保留）
+        quint64 injectedKey = 0;
+        quint64 injectedDropped = 0; // 其中按 InjectedPolicy::Drop 丢弃的
+        quint64 busLag = 0;          // Lossless 订阅者中最大的积压（已发布、尚未读取）
+        quint64 heldHighWater = 0;   // 过载期间工作线程暂存的最大事件数
+        quint64 coalescedMoves = 0;  // CoalesceMoves：被合并掉的鼠标移动（相对位移和滚轮量会累加，不会丢失）
+        quint64 droppedOldMoves = 0; // DropOldestMoves：被丢弃的旧鼠标移动
+        quint64 blockWaits = 0;      // Block：入队时因队列满而等待的次数
+        quint64 blockTimeouts = 0;   // Block：等待超时被丢弃的事件（同时计入 dropped*）
+        quint64 workerWakeups = 0;   // 工作线程从等待中醒来的次数（空闲时应保持不变）
+    };
+    Stats stats() const;
+
+    // 常开的延迟/队列深度直方图，运行中可随时查询，stop() 时打印
+    struct Metrics {
+        LatencyHistogram::Snapshot captureToEnqueueNs;  // 捕获时刻 → 入队完成（钩子回调中我们占用的时间）
+        LatencyHistogram::Snapshot enqueueNs;           // 单次入队耗时（每 kEnqueueSampleEvery 个事件采样一次）
+        LatencyHistogram::Snapshot dequeueDelayNs;      // 捕获时刻 → 工作线程取出
+        LatencyHistogram::Snapshot queueDepth;          // 工作线程每次取数时两个队列的总积压
+    };
+    Metrics metrics() const;
+    QString metricsReport() const;
 
 private:
     CaptureEngine();
     ~CaptureEngine();
 
     void workerLoop(); // 后台处理线程函数
+    void waitForWork(); // 阻塞到有事可做，只有轨迹简化有暂存点时才带超时
+    bool hasWork() const;
+    // 唤醒工作线程：只有它正在（或即将）睡眠时才加锁通知，忙碌时入队不产生任何系统调用
+    void wakeWorker()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(queueMutex_);
+            cv_.notify_one();
+        }
+    }
+    std::vector<CapturedEvent> drainQueues(); // 按时间戳归并取出两个队列中的事件
+    // 过滤并简化一批事件，结果追加到 out
+    void processBatch(std::vector<CapturedEvent>& events, std::vector<CapturedEvent>& out);
+    // 发布一个批次并更新统计；下游过载时按策略暂存，force 用于停止时无条件发布
+    void deliver(std::vector<CapturedEvent>&& events, bool force = false);
+    void hold(const std::vector<CapturedEvent>& events); // 按过载策略暂存
+    void dropOldestMoves(std::size_t count);
+    bool downstreamBusy() const { return bus_.lagEvents() >= overload_.maxLag; }
+    // 是否可以继续从环形队列取数：Block 策略或暂存已满时停止取数，让压力传回捕获线程
+    bool canDrain() const
+    {
+        if (!downstreamBusy()) return true;
+        return overload_.policy != OverloadPolicy::Block && held_.size() < overload_.maxHeld;
+    }
+
+    // 统计注入事件，按策略需要丢弃时返回 true
+    bool dropInjected(std::atomic<quint64>& counter)
+    {
+        counter.fetch_add(1, std::memory_order_relaxed);
+        if (!dropInjected_.load(std::memory_order_relaxed))
+            return false;
+        injectedDropped_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
 
-    static LRESULT CALLBACK mouseProc(int nCode, WPARAM wParam, LPARAM lParam);
-    static LRESULT CALLBACK keyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
+    // 入队并记录延迟：每个事件只多读一次时钟，入队本身的耗时按采样统计，保证常开开销足够低
+    template <typename Ring, typename Event>
+    bool pushInstrumented(Ring& ring, const Event& e)
+    {
+        const bool sample = (++enqueueSampleCounter_ & (kEnqueueSampleEvery - 1)) == 0;
+        const qint64 before = sample ? captureTimestampNs() : 0;
+        const bool ok = ring.tryPush(e);
+        const qint64 after = captureTimestampNs();
+        if (sample)
+            enqueueHist_.record(static_cast<quint64>(after - before));
+        if (after > e.timestampNs)
+            captureToEnqueueHist_.record(static_cast<quint64>(after - e.timestampNs));
+        return ok;
+    }
+
+    // Block 策略：队列满时让出 CPU 等工作线程取数，超时返回 false
+    template <typename Ring, typename Event>
+    bool waitForSpace(Ring& ring, const Event& e)
+    {
+        blockWaits_.fetch_add(1, std::memory_order_relaxed);
+        wakeWorker();
+        const qint64 deadline = captureTimestampNs() + overload_.blockTimeoutUs * 1000LL;
+        do {
+            std::this_thread::yield();
+            if (ring.tryPush(e))
+                return true;
+        } while (captureTimestampNs() < deadline);
+        blockTimeouts_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
 
 private:
-    HHOOK mouseHook_;
-    HHOOK keyboardHook_;
+    std::unique_ptr<CaptureBackend> backend_;
+    CaptureBackend::ThreadConfig threadConfig_;
+    bool relativeMotion_ = false;
     std::atomic<bool> running_;
 
     std::thread workerThread_;
+    // 仅用于工作线程的阻塞等待。工作线程睡眠前置 sleeping_，入队方只在看到它时才加锁通知：
+    // 双方都是「先写自己的标志/数据，再全屏障，再读对方」，不会丢失唤醒，所以等待不需要超时兜底
     std::mutex queueMutex_;
     std::condition_variable cv_;
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> waitingForBus_{false};   // 睡眠原因是下游积压，总线上有订阅者读走批次时需要唤醒
+    std::atomic<quint64> workerWakeups_{0};
+
+    // 每个输入源一个无锁环形队列：后端捕获线程写，工作线程读
+    static constexpr std::size_t kMouseQueueCapacity = 8192;
+    static constexpr std::size_t kKeyQueueCapacity = 1024;
+    // 单个批次的事件上限，避免输入风暴时一个批次无限增长、迟迟不能发出
+    static constexpr std::size_t kMaxBatchSize = 4096;
+    SpscRing<MouseEventData, kMouseQueueCapacity> mouseQueue_;
+    SpscRing<KeyEventData, kKeyQueueCapacity> keyQueue_;
+
+    std::atomic<quint64> droppedMouse_{0};
+    std::atomic<quint64> droppedKey_{0};
+    // 注入事件：策略可在任意线程修改，计数只由后端捕获线程写入
+    std::atomic<bool> dropInjected_{true};
+    std::atomic<quint64> injectedMouse_{0};
+    std::atomic<quint64> injectedKey_{0};
+    std::atomic<quint64> injectedDropped_{0};
+    // 以下计数只由工作线程写入
+    std::atomic<quint64> delivered_{0};
+    std::atomic<quint64> mouseHighWater_{0};
+    std::atomic<quint64> keyHighWater_{0};
+    std::atomic<quint64> movesCaptured_{0};
+    std::atomic<quint64> movesDelivered_{0};
+
+    // 延迟直方图：前两个只由后端捕获线程写，后两个只由工作线程写
+    static constexpr quint32 kEnqueueSampleEvery = 16;
+    quint32 enqueueSampleCounter_ = 0;
+    LatencyHistogram captureToEnqueueHist_;
+    LatencyHistogram enqueueHist_;
+    LatencyHistogram dequeueDelayHist_;
+    LatencyHistogram queueDepthHist_;
+
+    EventBus bus_;
+
+    // 过载控制：配置只在未运行时修改
+    OverloadConfig overload_;
+    std::vector<CapturedEvent> held_;          // 过载期间暂存的事件，只由工作线程访问
+    std::atomic<quint64> heldHighWater_{0};
+    std::atomic<quint64> coalescedMoves_{0};
+    std::atomic<quint64> droppedOldMoves_{0};
+    std::atomic<quint64> blockWaits_{0};
+    std::atomic<quint64> blockTimeouts_{0};
 
-    std::queue<MouseEventData> mouseQueue_;
-    std::queue<KeyEventData> keyQueue_;
+    // 过滤在工作线程中执行，在轨迹简化之前
+    CaptureFilter filter_;
+    std::atomic<quint64> filtered_{0};
 
-    QPoint lastMousePos_;
-    QDateTime lastMouseTime_;
+    // 轨迹简化只在工作线程中运行
+    MousePathSimplifier simplifier_;
+    MousePathSimplifier::Config simplifierConfig_;
 };
 
 #endif // CAPTUREENGINE_H
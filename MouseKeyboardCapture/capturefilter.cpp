@@ -0,0 +1,318 @@
+#include "capturefilter.h"
+#include "inputcodes.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// 键盘事件统一占用最高位，鼠标消息 0x200~0x21E 占 0~30 位中的前一段，相对运动编码占 16~18 位
+static constexpr quint32 kKeyboardBit = 1u << 31;
+static constexpr int kRawBitBase = 16;
+
+// 规则里可用的类型名
+static const struct { const char* name; quint32 code; } kTypeNames[] = {
+    { "move",         InputCode::MouseMove },
+    { "left-down",    InputCode::LeftDown },
+    { "left-up",      InputCode::LeftUp },
+    { "right-down",   InputCode::RightDown },
+    { "right-up",     InputCode::RightUp },
+    { "middle-down",  InputCode::MiddleDown },
+    { "middle-up",    InputCode::MiddleUp },
+    { "wheel",        InputCode::Wheel },
+    { "xbutton-down", InputCode::XButtonDown },
+    { "xbutton-up",   InputCode::XButtonUp },
+    { "hwheel",       InputCode::HWheel },
+    { "raw-motion",   InputCode::RawMotion },
+    { "raw-wheel",    InputCode::RawWheel },
+    { "raw-hwheel",   InputCode::RawHWheel },
+};
+
+static quint32 mouseTypeBit(quint32 type)
+{
+    if (type >= InputCode::MouseMove && type < InputCode::MouseMove + kRawBitBase)
+        return 1u << (type - InputCode::MouseMove);
+    if (InputCode::isRelative(type))
+        return 1u << (kRawBitBase + (type - InputCode::RawMotion));
+    return 0;
+}
+
+static int lowestBit(quint64 v)
+{
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+#  if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanForward64(&idx, v);
+    return static_cast<int>(idx);
+#  else
+    if (_BitScanForward(&idx, static_cast<unsigned long>(v)))
+        return static_cast<int>(idx);
+    _BitScanForward(&idx, static_cast<unsigned long>(v >> 32));
+    return static_cast<int>(idx) + 32;
+#  endif
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+static bool parseNumber(const QString& text, qint64& out)
+{
+    bool ok = false;
+    out = text.startsWith("0x", Qt::CaseInsensitive) ? text.mid(2).toLongLong(&ok, 16) : text.toLongLong(&ok, 10);
+    return ok;
+}
+
+CaptureFilter::CaptureFilter()
+{
+    clear();
+}
+
+void CaptureFilter::clear()
+{
+    rules_.clear();
+    compile();
+    resetHits();
+}
+
+quint32 CaptureFilter::typeBit(const CapturedEvent& e)
+{
+    return e.category == InputCategory::Keyboard ? kKeyboardBit : mouseTypeBit(e.mouse.type);
+}
+
+// ======================== 解析 ========================
+bool CaptureFilter::parse(const QStringList& lines, QString* error)
+{
+    auto fail = [error](int line, const QString& why) {
+        if (error) *error = QString("filter line %1: %2").arg(line).arg(why);
+        return false;
+    };
+
+    std::vector<Rule> rules;
+
+    for (int n = 0; n < lines.size(); ++n) {
+        QString text = lines.at(n);
+        const int hash = text.indexOf('#');
+        if (hash >= 0) text.truncate(hash);
+        text = text.simplified();
+        if (text.isEmpty()) continue;
+
+        const QStringList words = text.split(' ');
+        if (words.value(0) != "drop" || words.size() < 2)
+            return fail(n + 1, "expected 'drop <what> [in x,y,w,h]'");
+        if (static_cast<int>(rules.size()) >= kMaxRules)
+            return fail(n + 1, QString("more than %1 rules").arg(kMaxRules));
+
+        Rule rule;
+        rule.text = text;
+        int next = 2;
+
+        if (words.at(1) == "key") {
+            // 键码列表：数字（十进制或 0x 十六进制）或单个字母/数字字符
+            for (const QString& k : words.value(2).split(',')) {
+                qint64 vk = 0;
+                if (k.size() == 1 && k.at(0).isLetterOrNumber())
+                    vk = k.at(0).toUpper().unicode();
+                else if (!parseNumber(k, vk) || vk < 0 || vk > 255)
+                    return fail(n + 1, QString("bad key code '%1'").arg(k));
+                rule.keys.push_back(static_cast<quint8>(vk));
+            }
+            next = 3;
+        } else if (words.at(1) == "keyboard") {
+            rule.typeMask = kKeyboardBit;
+        } else {
+            for (const QString& t : words.at(1).split(',')) {
+                quint32 bit = 0;
+                for (const auto& entry : kTypeNames) {
+                    if (t == entry.name) bit = mouseTypeBit(entry.code);
+                }
+                qint64 code = 0;
+                if (!bit && parseNumber(t, code))
+                    bit = mouseTypeBit(static_cast<quint32>(code));
+                if (!bit)
+                    return fail(n + 1, QString("unknown event type '%1'").arg(t));
+                rule.typeMask |= bit;
+            }
+        }
+
+        if (words.value(next) == "in") {
+            if (!rule.keys.empty() || rule.typeMask == kKeyboardBit)
+                return fail(n + 1, "keyboard events have no position, 'in' only applies to mouse types");
+            const QStringList rect = words.value(next + 1).split(',');
+            qint64 v[4];
+            for (int i = 0; i < 4; ++i) {
+                if (rect.size() != 4 || !parseNumber(rect.at(i).trimmed(), v[i]))
+                    return fail(n + 1, "region must be x,y,w,h");
+            }
+            if (v[2] <= 0 || v[3] <= 0)
+                return fail(n + 1, "region width and height must be positive");
+            rule.hasRegion = true;
+            rule.x0 = static_cast<qint32>(v[0]);
+            rule.y0 = static_cast<qint32>(v[1]);
+            rule.x1 = static_cast<qint32>(v[0] + v[2]);
+            rule.y1 = static_cast<qint32>(v[1] + v[3]);
+            next += 2;
+        }
+        if (next < words.size())
+            return fail(n + 1, QString("unexpected '%1'").arg(words.at(next)));
+
+        rules.push_back(rule);
+    }
+
+    rules_ = std::move(rules);
+    compile();
+    resetHits();
+    return true;
+}
+
+// ======================== 编译 ========================
+void CaptureFilter::compile()
+{
+    std::memset(keyBitmap_, 0, sizeof(keyBitmap_));
+    std::memset(keyRule_, 0, sizeof(keyRule_));
+    std::memset(typeRule_, 0, sizeof(typeRule_));
+    globalTypeMask_ = 0;
+    regionTypeMask_ = 0;
+    grid_.clear();
+    gridCols_ = gridRows_ = 0;
+
+    bool anyRegion = false;
+    qint32 minX = 0, minY = 0, maxX = 0, maxY = 0;
+    for (std::size_t r = 0; r < rules_.size(); ++r) {
+        const Rule& rule = rules_[r];
+        // 同一个键或类型被多条规则列出时，命中计入第一条
+        for (quint8 vk : rule.keys) {
+            const quint64 bit = quint64(1) << (vk & 63);
+            if (!(keyBitmap_[vk >> 6] & bit)) {
+                keyBitmap_[vk >> 6] |= bit;
+                keyRule_[vk] = static_cast<quint8>(r);
+            }
+        }
+        if (!rule.hasRegion) {
+            for (int b = 0; b < 32; ++b) {
+                const quint32 bit = 1u << b;
+                if ((rule.typeMask & bit) && !(globalTypeMask_ & bit))
+                    typeRule_[b] = static_cast<quint8>(r);
+            }
+            globalTypeMask_ |= rule.typeMask;
+            continue;
+        }
+        regionTypeMask_ |= rule.typeMask;
+        minX = anyRegion ? std::min(minX, rule.x0) : rule.x0;
+        minY = anyRegion ? std::min(minY, rule.y0) : rule.y0;
+        maxX = anyRegion ? std::max(maxX, rule.x1) : rule.x1;
+        maxY = anyRegion ? std::max(maxY, rule.y1) : rule.y1;
+        anyRegion = true;
+    }
+    if (!anyRegion)
+        return;
+
+    // 格子大小从 64 像素起，包围盒太大时加倍，网格最多 64K 个格子
+    cellShift_ = 6;
+    const qint64 width = qint64(maxX) - minX;
+    const qint64 height = qint64(maxY) - minY;
+    while (((width >> cellShift_) + 1) * ((height >> cellShift_) + 1) > 65536)
+        ++cellShift_;
+    gridX0_ = minX;
+    gridY0_ = minY;
+    gridCols_ = static_cast<int>(((width - 1) >> cellShift_) + 1);
+    gridRows_ = static_cast<int>(((height - 1) >> cellShift_) + 1);
+    grid_.assign(static_cast<std::size_t>(gridCols_) * gridRows_, 0);
+
+    for (std::size_t r = 0; r < rules_.size(); ++r) {
+        const Rule& rule = rules_[r];
+        if (!rule.hasRegion) continue;
+        const int c0 = static_cast<int>((qint64(rule.x0) - gridX0_) >> cellShift_);
+        const int c1 = static_cast<int>((qint64(rule.x1) - 1 - gridX0_) >> cellShift_);
+        const int r0 = static_cast<int>((qint64(rule.y0) - gridY0_) >> cellShift_);
+        const int r1 = static_cast<int>((qint64(rule.y1) - 1 - gridY0_) >> cellShift_);
+        for (int row = r0; row <= r1; ++row) {
+            for (int col = c0; col <= c1; ++col)
+                grid_[static_cast<std::size_t>(row) * gridCols_ + col] |= quint64(1) << r;
+        }
+    }
+}
+
+// ======================== 判断 ========================
+void CaptureFilter::hit(int rule)
+{
+    std::atomic<quint64>& counter = hits_[rule];
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+bool CaptureFilter::drop(const CapturedEvent& e)
+{
+    if (e.category == InputCategory::Keyboard && e.key.vkCode < 256) {
+        const quint32 vk = e.key.vkCode;
+        if (keyBitmap_[vk >> 6] & (quint64(1) << (vk & 63))) {
+            hit(keyRule_[vk]);
+            return true;
+        }
+    }
+
+    const quint32 bit = typeBit(e);
+    if (globalTypeMask_ & bit) {
+        hit(typeRule_[lowestBit(bit)]);
+        return true;
+    }
+    // 相对运动的 x/y 是位移而不是位置，不做区域判断
+    if (!(regionTypeMask_ & bit) || e.category != InputCategory::Mouse || InputCode::isRelative(e.mouse.type))
+        return false;
+
+    const qint64 dx = qint64(e.mouse.x) - gridX0_;
+    const qint64 dy = qint64(e.mouse.y) - gridY0_;
+    if (dx < 0 || dy < 0)
+        return false;
+    const qint64 col = dx >> cellShift_;
+    const qint64 row = dy >> cellShift_;
+    if (col >= gridCols_ || row >= gridRows_)
+        return false;
+
+    // 格子只给出候选规则，边缘格子里仍需精确判断矩形
+    quint64 candidates = grid_[static_cast<std::size_t>(row) * gridCols_ + col];
+    while (candidates) {
+        const int r = lowestBit(candidates);
+        candidates &= candidates - 1;
+        const Rule& rule = rules_[r];
+        if ((rule.typeMask & bit) && e.mouse.x >= rule.x0 && e.mouse.x < rule.x1
+                && e.mouse.y >= rule.y0 && e.mouse.y < rule.y1) {
+            hit(r);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t CaptureFilter::apply(std::vector<CapturedEvent>& events)
+{
+    if (rules_.empty())
+        return 0;
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        if (!drop(events[i]))
+            events[kept++] = events[i];
+    }
+    const std::size_t removed = events.size() - kept;
+    events.resize(kept);
+    return removed;
+}
+
+// ======================== 统计 ========================
+std::vector<CaptureFilter::RuleHits> CaptureFilter::hits() const
+{
+    std::vector<RuleHits> out;
+    out.reserve(rules_.size());
+    for (std::size_t r = 0; r < rules_.size(); ++r) {
+        RuleHits h;
+        h.rule = rules_[r].text;
+        h.hits = hits_[r].load(std::memory_order_relaxed);
+        out.push_back(h);
+    }
+    return out;
+}
+
+void CaptureFilter::resetHits()
+{
+    for (std::atomic<quint64>& h : hits_)
+        h.store(0, std::memory_order_relaxed);
+}
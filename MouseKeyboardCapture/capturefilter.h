@@ -0,0 +1,87 @@
+#ifndef CAPTUREFILTER_H
+#define CAPTUREFILTER_H
+
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <vector>
+#include "inputevent.h"
+
+/**
+ * @brief 捕获过滤规则（在 CaptureEngine 工作线程中执行，事件到达界面和录制之前就被丢弃）
+ *
+ * 规则是声明式的文本，每行一条，# 开头为注释：
+ *   drop key 0x5B,0x5C,A          丢弃指定虚拟键码（数字或单个字母/数字字符）
+ *   drop keyboard                 丢弃所有键盘事件
+ *   drop move,wheel               丢弃指定类型的鼠标事件（类型名见 capturefilter.cpp，也可以写数值）
+ *   drop move in 0,1040,1920,40   只丢弃落在矩形 x,y,w,h 内的指定类型事件（例如状态栏上的移动）
+ *
+ * 解析后编译成扁平查找表，每个事件的判断与规则数量无关：
+ * - 键码规则：256 位位图，命中后再查一张 256 字节的表找到对应规则计数；
+ * - 类型规则：按事件类型映射到一个 32 位掩码中的位；
+ * - 区域规则：覆盖所有矩形的包围盒按 2^n 像素划分网格，每格记录与它相交的规则位集，
+ *   事件只检查所在格子的候选规则。相对位移事件没有坐标，不参与区域判断。
+ *
+ * 每条规则有独立的命中计数，由工作线程写、任意线程读（近似快照）。
+ */
+class CaptureFilter
+{
+public:
+    static constexpr int kMaxRules = 64;
+
+    struct RuleHits {
+        QString rule;
+        quint64 hits = 0;
+    };
+
+    CaptureFilter();
+    CaptureFilter(const CaptureFilter&) = delete;
+    CaptureFilter& operator=(const CaptureFilter&) = delete;
+
+    // 解析并编译规则；失败时保持原有规则不变，error 给出行号和原因
+    bool parse(const QStringList& lines, QString* error = nullptr);
+    void clear();
+    bool isEmpty() const { return rules_.empty(); }
+
+    // 判断单个事件是否丢弃，命中时累加对应规则的计数（仅工作线程调用）
+    bool drop(const CapturedEvent& e);
+    // 原地移除被丢弃的事件，返回移除的数量
+    std::size_t apply(std::vector<CapturedEvent>& events);
+
+    std::vector<RuleHits> hits() const;
+    void resetHits();
+
+private:
+    struct Rule {
+        QString text;
+        std::vector<quint8> keys; // 键码规则的键集合
+        quint32 typeMask = 0;     // 类型规则涉及的类型位（typeBit）
+        bool hasRegion = false;
+        qint32 x0 = 0, y0 = 0;    // 区域为半开区间 [x0, x1) × [y0, y1)
+        qint32 x1 = 0, y1 = 0;
+    };
+
+    static quint32 typeBit(const CapturedEvent& e);
+    void compile();
+    void hit(int rule);
+
+private:
+    std::vector<Rule> rules_;
+
+    // ---- 编译结果 ----
+    quint64 keyBitmap_[4];
+    quint8 keyRule_[256];          // 每个键码由哪条规则丢弃（用于计数）
+    quint32 globalTypeMask_ = 0;   // 不限区域的类型规则
+    quint8 typeRule_[32];
+    quint32 regionTypeMask_ = 0;   // 所有区域规则涉及的类型，不相关的事件直接跳过网格
+    qint32 gridX0_ = 0;
+    qint32 gridY0_ = 0;
+    int gridCols_ = 0;
+    int gridRows_ = 0;
+    int cellShift_ = 6;
+    std::vector<quint64> grid_;    // 每格一个规则位集（第 i 位对应 rules_[i]）
+
+    std::atomic<quint64> hits_[kMaxRules];
+};
+
+#endif // CAPTUREFILTER_H
@@ -0,0 +1,146 @@
+#include "compressedsink.h"
+#include <QThread>
+#include <QDebug>
+#include <algorithm>
+
+CompressedSink::CompressedSink(std::unique_ptr<RecordSink> next, const BlockCodec::Config& config)
+    : next_(std::move(next)), config_(config)
+{
+    config_.blockSize = std::max(config_.blockSize, 4096);
+}
+
+CompressedSink::~CompressedSink()
+{
+    stopWorkers();
+}
+
+bool CompressedSink::open()
+{
+    if (!next_->open())
+        return false;
+    const QByteArray header = BlockCodec::fileHeader(config_);
+    if (!next_->write(header.constData(), header.size()))
+        return false;
+
+    // 默认最多 4 个压缩线程，并留一个核给捕获和写入线程
+    int threads = 0;
+    if (config_.codec != BlockCodec::Stored)
+        threads = config_.threads > 0 ? config_.threads : std::max(1, std::min(4, QThread::idealThreadCount() - 1));
+    for (int i = 0; i < threads; ++i)
+        workers_.emplace_back(&CompressedSink::workerLoop, this);
+    return true;
+}
+
+bool CompressedSink::write(const char* data, qint64 size)
+{
+    while (size > 0) {
+        if (!current_) {
+            current_.reset(new Block);
+            current_->raw.reserve(config_.blockSize);
+        }
+        const int room = config_.blockSize - current_->raw.size();
+        const int n = static_cast<int>(std::min<qint64>(room, size));
+        current_->raw.append(data, n);
+        data += n;
+        size -= n;
+        if (current_->raw.size() >= config_.blockSize)
+            submit();
+    }
+    return writeFinished(false);
+}
+
+void CompressedSink::submit()
+{
+    if (!current_ || current_->raw.isEmpty())
+        return;
+    Block* block = current_.get();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.blocks;
+    stats_.rawBytes += static_cast<quint64>(block->raw.size());
+    // 线程池跟不上（或不压缩）时直接存储，写入线程不等待
+    if (workers_.empty() || queue_.size() >= 2 * workers_.size()) {
+        block->encoded = BlockCodec::encodeBlock(block->raw.constData(), block->raw.size(), BlockCodec::Stored, 0);
+        block->raw = QByteArray();
+        block->done = true;
+        ++stats_.storedBlocks;
+    } else {
+        queue_.push_back(block);
+        workCv_.notify_one();
+    }
+    inFlight_.push_back(std::move(current_));
+}
+
+void CompressedSink::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        workCv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty())
+            return;
+        Block* block = queue_.front();
+        queue_.pop_front();
+
+        lock.unlock();
+        QByteArray encoded = BlockCodec::encodeBlock(block->raw.constData(), block->raw.size(), config_.codec, config_.level);
+        lock.lock();
+
+        // encodeBlock 在压缩无收益时会改为原样存储，块头第 9 字节记录实际使用的编解码器
+        if (static_cast<quint8>(encoded.at(BlockCodec::kBlockHeaderBytes - 1)) == BlockCodec::Stored)
+            ++stats_.storedBlocks;
+        block->encoded = std::move(encoded);
+        block->raw = QByteArray();
+        block->done = true;
+        doneCv_.notify_all();
+    }
+}
+
+// 按顺序写出队首已完成的块；wait 为 true 时等到全部在途的块写完
+bool CompressedSink::writeFinished(bool wait)
+{
+    for (;;) {
+        std::unique_ptr<Block> block;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (wait)
+                doneCv_.wait(lock, [this] { return inFlight_.empty() || inFlight_.front()->done; });
+            if (inFlight_.empty() || !inFlight_.front()->done)
+                return !failed_;
+            block = std::move(inFlight_.front());
+            inFlight_.pop_front();
+            stats_.writtenBytes += static_cast<quint64>(block->encoded.size());
+        }
+        if (!failed_ && !next_->write(block->encoded.constData(), block->encoded.size()))
+            failed_ = true;
+    }
+}
+
+void CompressedSink::close()
+{
+    submit();
+    writeFinished(true);
+    stopWorkers();
+    next_->close();
+
+    const Stats s = stats();
+    qDebug().noquote() << QString("CompressedSink: %1 blocks (%2 stored), %3 -> %4 bytes")
+                          .arg(s.blocks).arg(s.storedBlocks).arg(s.rawBytes).arg(s.writtenBytes);
+}
+
+void CompressedSink::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        workCv_.notify_all();
+    }
+    for (std::thread& t : workers_)
+        t.join();
+    workers_.clear();
+}
+
+CompressedSink::Stats CompressedSink::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,70 @@
+#ifndef COMPRESSEDSINK_H
+#define COMPRESSEDSINK_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "blockcodec.h"
+#include "recordsink.h"
+
+/**
+ * @brief 分块压缩后写入下一级 sink（.mkrz，格式见 BlockCodec）
+ *
+ * write() 只把数据拷进当前块；块满后交给压缩线程池，写入线程不等待压缩。
+ * 压缩好的块按块号顺序在写入线程上写给下一级 sink（每次 write() 和 close() 时检查）。
+ *
+ * 压缩永远不会反过来拖慢捕获：在途的块超过线程数的两倍时，新满的块不压缩、直接按 Stored 存储，
+ * 录制线程始终以拷贝内存的速度消费事件。close() 等待所有块压缩完成并写出后才关闭下一级 sink。
+ */
+class CompressedSink : public RecordSink
+{
+public:
+    struct Stats {
+        quint64 blocks = 0;
+        quint64 storedBlocks = 0;   // 因压缩线程忙或数据不可压缩而原样存储的块
+        quint64 rawBytes = 0;
+        quint64 writtenBytes = 0;
+    };
+
+    CompressedSink(std::unique_ptr<RecordSink> next, const BlockCodec::Config& config);
+    ~CompressedSink() override;
+
+    bool open() override;
+    bool write(const char* data, qint64 size) override;
+    void close() override;
+    QString name() const override { return next_->name(); }
+
+    Stats stats() const;
+
+private:
+    struct Block {
+        QByteArray raw;
+        QByteArray encoded;   // 带块头的压缩结果
+        bool done = false;
+    };
+
+    void submit();                // 把当前块交给线程池（或直接存储）
+    bool writeFinished(bool wait);
+    void workerLoop();
+    void stopWorkers();
+
+private:
+    std::unique_ptr<RecordSink> next_;
+    BlockCodec::Config config_;
+    std::unique_ptr<Block> current_;
+    bool failed_ = false;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workCv_;   // 有新块待压缩 / 停止
+    std::condition_variable doneCv_;   // 有块压缩完成
+    std::deque<std::unique_ptr<Block>> inFlight_;   // 按块号排列，队首最先写出
+    std::deque<Block*> queue_;                      // 待压缩
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+    Stats stats_;
+};
+
+#endif // COMPRESSEDSINK_H
@@ -0,0 +1,146 @@
+#include "crc32c.h"
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <nmmintrin.h>
+#define CRC32C_X86 1
+#define CRC32C_TARGET_SSE42
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <nmmintrin.h>
+#define CRC32C_X86 1
+#define CRC32C_TARGET_SSE42 __attribute__((target("sse4.2")))
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_ARM 1
+#endif
+
+namespace Crc32c {
+
+namespace {
+
+// 反射多项式 0x82F63B78 的查表法，8 张表一次处理 8 字节
+struct Tables {
+    quint32 t[8][256];
+    Tables()
+    {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            t[0][i] = c;
+        }
+        for (quint32 i = 0; i < 256; ++i)
+            for (int k = 1; k < 8; ++k)
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+    }
+};
+
+quint32 extendSoftware(quint32 crc, const char* data, std::size_t size)
+{
+    static const Tables tables;
+    const auto& t = tables.t;
+    const quint8* p = reinterpret_cast<const quint8*>(data);
+    crc = ~crc;
+    while (size >= 8) {
+        const quint32 lo = crc ^ (quint32(p[0]) | quint32(p[1]) << 8 | quint32(p[2]) << 16 | quint32(p[3]) << 24);
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+            ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+        p += 8;
+        size -= 8;
+    }
+    while (size--)
+        crc = t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+#if defined(CRC32C_X86)
+bool cpuHasSse42()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    unsigned int a, b, c, d;
+    return __get_cpuid(1, &a, &b, &c, &d) && (c & bit_SSE4_2) != 0;
+#endif
+}
+
+CRC32C_TARGET_SSE42 quint32 extendHardware(quint32 crc, const char* data, std::size_t size)
+{
+    const char* p = data;
+    crc = ~crc;
+#if defined(_M_X64) || defined(__x86_64__)
+    quint64 c64 = crc;
+    while (size >= 8) {
+        quint64 v;
+        std::memcpy(&v, p, 8);
+        c64 = _mm_crc32_u64(c64, v);
+        p += 8;
+        size -= 8;
+    }
+    crc = static_cast<quint32>(c64);
+#endif
+    while (size >= 4) {
+        quint32 v;
+        std::memcpy(&v, p, 4);
+        crc = _mm_crc32_u32(crc, v);
+        p += 4;
+        size -= 4;
+    }
+    while (size--)
+        crc = _mm_crc32_u8(crc, static_cast<quint8>(*p++));
+    return ~crc;
+}
+#elif defined(CRC32C_ARM)
+quint32 extendHardware(quint32 crc, const char* data, std::size_t size)
+{
+    const char* p = data;
+    crc = ~crc;
+    while (size >= 8) {
+        quint64 v;
+        std::memcpy(&v, p, 8);
+        crc = __crc32cd(crc, v);
+        p += 8;
+        size -= 8;
+    }
+    while (size--)
+        crc = __crc32cb(crc, static_cast<quint8>(*p++));
+    return ~crc;
+}
+#endif
+
+using ExtendFn = quint32 (*)(quint32, const char*, std::size_t);
+
+ExtendFn selectImplementation()
+{
+#if defined(CRC32C_X86)
+    if (cpuHasSse42())
+        return extendHardware;
+#elif defined(CRC32C_ARM)
+    return extendHardware;
+#endif
+    return extendSoftware;
+}
+
+ExtendFn implementation()
+{
+    static const ExtendFn fn = selectImplementation();
+    return fn;
+}
+
+} // namespace
+
+quint32 extend(quint32 crc, const char* data, std::size_t size)
+{
+    return implementation()(crc, data, size);
+}
+
+bool isHardwareAccelerated()
+{
+    return implementation() != extendSoftware;
+}
+
+} // namespace Crc32c
@@ -0,0 +1,24 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <QtGlobal>
+#include <cstddef>
+
+/**
+ * @brief CRC32C（Castagnoli 多项式 0x1EDC6F41，与 iSCSI / ext4 / RocksDB 相同）
+ *
+ * x86 上 CPU 支持 SSE4.2 时用 crc32 指令，ARMv8 编译时启用了 CRC 扩展时用 __crc32c* 内建函数，
+ * 其它情况用查表法。首次调用时检测一次 CPU，之后直接走选好的实现。
+ */
+namespace Crc32c {
+
+// crc 为之前数据的结果，可以分段累加：extend(extend(0, a), b) == extend(0, a + b)
+quint32 extend(quint32 crc, const char* data, std::size_t size);
+inline quint32 value(const char* data, std::size_t size) { return extend(0, data, size); }
+
+// 当前使用的是否为硬件指令（用于日志）
+bool isHardwareAccelerated();
+
+} // namespace Crc32c
+
+#endif // CRC32C_H
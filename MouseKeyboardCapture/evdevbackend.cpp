@@ -0,0 +1,541 @@
+#include "evdevbackend.h"
+#include "captureengine.h"
+#include "inputcodes.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QDebug>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <climits>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+
+// 一次 read 最多读取的事件数；内核按整条 input_event 返回，批量读可以显著减少系统调用次数
+static constexpr int kReadBatch = 128;
+
+// ======================== 键码翻译 ========================
+// Linux KEY_* → Windows 虚拟键码，未覆盖的按键返回 0（丢弃）
+static quint32 linuxKeyToVk(unsigned code)
+{
+    // 字母键按键盘物理排列编号，不连续，用三段查表
+    static const char kRowQ[] = "QWERTYUIOP";   // KEY_Q(16) .. KEY_P(25)
+    static const char kRowA[] = "ASDFGHJKL";    // KEY_A(30) .. KEY_L(38)
+    static const char kRowZ[] = "ZXCVBNM";      // KEY_Z(44) .. KEY_M(50)
+    if (code >= KEY_Q && code <= KEY_P) return static_cast<quint32>(kRowQ[code - KEY_Q]);
+    if (code >= KEY_A && code <= KEY_L) return static_cast<quint32>(kRowA[code - KEY_A]);
+    if (code >= KEY_Z && code <= KEY_M) return static_cast<quint32>(kRowZ[code - KEY_Z]);
+
+    if (code >= KEY_1 && code <= KEY_9) return '1' + (code - KEY_1);
+    if (code == KEY_0) return '0';
+    if (code >= KEY_F1 && code <= KEY_F10) return 0x70 + (code - KEY_F1);   // VK_F1..VK_F10
+
+    switch (code) {
+    case KEY_F11:        return 0x7A;
+    case KEY_F12:        return 0x7B;
+    case KEY_ESC:        return 0x1B;
+    case KEY_TAB:        return 0x09;
+    case KEY_CAPSLOCK:   return 0x14;
+    case KEY_LEFTSHIFT:  return 0xA0;
+    case KEY_RIGHTSHIFT: return 0xA1;
+    case KEY_LEFTCTRL:   return 0xA2;
+    case KEY_RIGHTCTRL:  return 0xA3;
+    case KEY_LEFTALT:    return 0xA4;
+    case KEY_RIGHTALT:   return 0xA5;
+    case KEY_LEFTMETA:   return 0x5B;
+    case KEY_RIGHTMETA:  return 0x5C;
+    case KEY_COMPOSE:    return 0x5D;
+    case KEY_SPACE:      return 0x20;
+    case KEY_ENTER:      return 0x0D;
+    case KEY_KPENTER:    return 0x0D;
+    case KEY_BACKSPACE:  return 0x08;
+    case KEY_LEFT:       return 0x25;
+    case KEY_UP:         return 0x26;
+    case KEY_RIGHT:      return 0x27;
+    case KEY_DOWN:       return 0x28;
+    case KEY_PAGEUP:     return 0x21;
+    case KEY_PAGEDOWN:   return 0x22;
+    case KEY_END:        return 0x23;
+    case KEY_HOME:       return 0x24;
+    case KEY_INSERT:     return 0x2D;
+    case KEY_DELETE:     return 0x2E;
+    case KEY_SYSRQ:      return 0x2C;
+    case KEY_PAUSE:      return 0x13;
+    case KEY_NUMLOCK:    return 0x90;
+    case KEY_SCROLLLOCK: return 0x91;
+    case KEY_KP0:        return 0x60;
+    case KEY_KP1:        return 0x61;
+    case KEY_KP2:        return 0x62;
+    case KEY_KP3:        return 0x63;
+    case KEY_KP4:        return 0x64;
+    case KEY_KP5:        return 0x65;
+    case KEY_KP6:        return 0x66;
+    case KEY_KP7:        return 0x67;
+    case KEY_KP8:        return 0x68;
+    case KEY_KP9:        return 0x69;
+    case KEY_KPASTERISK: return 0x6A;
+    case KEY_KPPLUS:     return 0x6B;
+    case KEY_KPMINUS:    return 0x6D;
+    case KEY_KPDOT:      return 0x6E;
+    case KEY_KPSLASH:    return 0x6F;
+    case KEY_SEMICOLON:  return 0xBA;
+    case KEY_EQUAL:      return 0xBB;
+    case KEY_COMMA:      return 0xBC;
+    case KEY_MINUS:      return 0xBD;
+    case KEY_DOT:        return 0xBE;
+    case KEY_SLASH:      return 0xBF;
+    case KEY_GRAVE:      return 0xC0;
+    case KEY_LEFTBRACE:  return 0xDB;
+    case KEY_BACKSLASH:  return 0xDC;
+    case KEY_RIGHTBRACE: return 0xDD;
+    case KEY_APOSTROPHE: return 0xDE;
+    case KEY_102ND:      return 0xE2;
+    default:             return 0;
+    }
+}
+
+// 鼠标按键 → WM_* 消息值，非鼠标按键返回 0
+static quint32 linuxButtonToMessage(unsigned code, bool down)
+{
+    switch (code) {
+    case BTN_LEFT:   return down ? InputCode::LeftDown : InputCode::LeftUp;
+    case BTN_RIGHT:  return down ? InputCode::RightDown : InputCode::RightUp;
+    case BTN_MIDDLE: return down ? InputCode::MiddleDown : InputCode::MiddleUp;
+    case BTN_SIDE:
+    case BTN_EXTRA:  return down ? InputCode::XButtonDown : InputCode::XButtonUp;
+    default:         return 0;
+    }
+}
+
+// 内核时间戳 → 纳秒；EVIOCSCLOCKID 成功后它与 steady_clock 同为 CLOCK_MONOTONIC
+static qint64 eventTimestampNs(const input_event& ev)
+{
+    return static_cast<qint64>(ev.input_event_sec) * 1000000000LL
+         + static_cast<qint64>(ev.input_event_usec) * 1000LL;
+}
+
+// 绝对坐标 → 屏幕像素：设备范围 [min, max] 线性映射到 [origin, origin + extent - 1]；
+// 范围或屏幕未知时原样返回
+static qint32 scaleAbsolute(qint32 value, qint32 min, qint32 max, int origin, int extent)
+{
+    if (max <= min || extent <= 0)
+        return value;
+    const qint64 clamped = std::min<qint64>(std::max<qint64>(value, min), max);
+    return origin + static_cast<qint32>((clamped - min) * (extent - 1) / (static_cast<qint64>(max) - min));
+}
+
+// 程序创建的虚拟设备：uinput 设备在 sysfs 中挂在 /sys/devices/virtual/input 下；
+// 有些注入工具会伪造总线类型，所以两个条件任一满足即可
+static bool isVirtualDevice(int fd, const QString& path)
+{
+    input_id id{};
+    if (ioctl(fd, EVIOCGID, &id) >= 0 && id.bustype == BUS_VIRTUAL)
+        return true;
+
+    const QByteArray sysPath = "/sys/class/input/" + QFileInfo(path).fileName().toLocal8Bit();
+    char resolved[PATH_MAX];
+    if (!realpath(sysPath.constData(), resolved))
+        return false;
+    return std::strstr(resolved, "/devices/virtual/") != nullptr;
+}
+
+// ======================== 启动与停止 ========================
+EvdevBackend::~EvdevBackend()
+{
+    stop();
+}
+
+bool EvdevBackend::start(CaptureEngine& engine)
+{
+    if (thread_.joinable()) return true;
+
+    engine_ = &engine;
+    {
+        std::lock_guard<std::mutex> lock(knownMutex_);
+        known_.clear();
+    }
+    // QScreen 只能在 GUI 线程上访问，这里取一次，之后读线程（包括热插拔打开的设备）都用这个区域
+    const QScreen* screen = qGuiApp ? QGuiApplication::primaryScreen() : nullptr;
+    screen_ = screen ? screen->geometry() : QRect();
+    if (screen_.isEmpty())
+        qWarning() << "EvdevBackend: no screen geometry, absolute devices are recorded in device units";
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        qWarning() << "EvdevBackend: epoll/eventfd failed:" << strerror(errno);
+        stop();
+        return false;
+    }
+
+    epoll_event wakeEv{};
+    wakeEv.events = EPOLLIN;
+    wakeEv.data.fd = wakeFd_;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &wakeEv);
+
+    QStringList paths = devicePaths_;
+    if (paths.isEmpty()) {
+        // 先开始监视再扫描，扫描期间新出现的设备也不会漏掉（重复打开由 openDevice 过滤）
+        inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd_ >= 0 && inotify_add_watch(inotifyFd_, "/dev/input", IN_CREATE | IN_ATTRIB) >= 0) {
+            epoll_event notifyEv{};
+            notifyEv.events = EPOLLIN;
+            notifyEv.data.fd = inotifyFd_;
+            epoll_ctl(epollFd_, EPOLL_CTL_ADD, inotifyFd_, &notifyEv);
+        } else {
+            qWarning() << "EvdevBackend: inotify on /dev/input failed, hotplug disabled:" << strerror(errno);
+            if (inotifyFd_ >= 0) close(inotifyFd_);
+            inotifyFd_ = -1;
+        }
+
+        const QDir dir("/dev/input");
+        for (const QString& name : dir.entryList(QStringList() << "event*", QDir::System))
+            paths << dir.absoluteFilePath(name);
+    }
+    for (const QString& path : paths)
+        openDevice(path);
+
+    if (devices_.empty()) {
+        qWarning() << "EvdevBackend: no readable input device (need root or the 'input' group)";
+        stop();
+        return false;
+    }
+
+    thread_ = std::thread(&EvdevBackend::readLoop, this);
+    return true;
+}
+
+void EvdevBackend::stop()
+{
+    if (thread_.joinable()) {
+        const quint64 one = 1;
+        if (write(wakeFd_, &one, sizeof(one)) < 0)
+            qWarning() << "EvdevBackend: wake write failed:" << strerror(errno);
+        thread_.join();
+    }
+
+    closeDevices();
+    if (inotifyFd_ >= 0) close(inotifyFd_);
+    if (wakeFd_ >= 0) close(wakeFd_);
+    if (epollFd_ >= 0) close(epollFd_);
+    inotifyFd_ = -1;
+    wakeFd_ = -1;
+    epollFd_ = -1;
+    engine_ = nullptr;
+}
+
+std::vector<InputDeviceInfo> EvdevBackend::devices() const
+{
+    std::lock_guard<std::mutex> lock(knownMutex_);
+    return known_;
+}
+
+// 同一个设备节点、同一个名称重新出现时（拔出后再插上）沿用原来的编号，录制文件里仍是同一台设备
+DeviceId EvdevBackend::registerDevice(const QString& path, const QString& name, bool injected, bool* firstSeen)
+{
+    std::lock_guard<std::mutex> lock(knownMutex_);
+    for (InputDeviceInfo& info : known_) {
+        if (info.path == path && info.name == name) {
+            info.connected = true;
+            if (firstSeen) *firstSeen = false;
+            return info.id;
+        }
+    }
+    if (firstSeen) *firstSeen = true;
+    InputDeviceInfo info;
+    info.id = static_cast<DeviceId>(known_.size() + 1);
+    info.name = name;
+    info.path = path;
+    info.injected = injected;
+    known_.push_back(info);
+    return info.id;
+}
+
+bool EvdevBackend::openDevice(const QString& path)
+{
+    for (const Device& dev : devices_) {
+        if (dev.path == path)
+            return true;
+    }
+
+    const int fd = open(path.toLocal8Bit().constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    // 只关心能产生按键、相对位移或绝对坐标的设备（键盘、鼠标、触控板、数位板）
+    unsigned long evBits = 0;
+    if (ioctl(fd, EVIOCGBIT(0, sizeof(evBits)), &evBits) < 0 ||
+        !(evBits & ((1UL << EV_KEY) | (1UL << EV_REL) | (1UL << EV_ABS)))) {
+        close(fd);
+        return false;
+    }
+
+    // 让内核用单调时钟给事件打时间戳，与 captureTimestampNs 可直接比较；
+    // 切换失败时内核时间戳是 CLOCK_REALTIME，与其他设备无法归并，改为读到事件时重新取时间
+    int clockId = CLOCK_MONOTONIC;
+    const bool restamp = ioctl(fd, EVIOCSCLOCKID, &clockId) < 0;
+    if (restamp)
+        qWarning() << "EvdevBackend: EVIOCSCLOCKID failed on" << path << "- using read-time timestamps";
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        close(fd);
+        return false;
+    }
+
+    char name[256] = {};
+    if (ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name) < 0)
+        name[0] = '\0';
+
+    Device dev;
+    dev.fd = fd;
+    dev.path = path;
+    dev.restamp = restamp;
+    if (evBits & (1UL << EV_ABS)) {
+        input_absinfo abs{};
+        if (ioctl(fd, EVIOCGABS(ABS_X), &abs) >= 0) {
+            dev.absMinX = abs.minimum;
+            dev.absMaxX = abs.maximum;
+        }
+        if (ioctl(fd, EVIOCGABS(ABS_Y), &abs) >= 0) {
+            dev.absMinY = abs.minimum;
+            dev.absMaxY = abs.maximum;
+        }
+    }
+#ifdef REL_WHEEL_HI_RES
+    unsigned long relBits = 0;
+    if (ioctl(fd, EVIOCGBIT(EV_REL, sizeof(relBits)), &relBits) >= 0)
+        dev.hiResWheel = (relBits & (1UL << REL_WHEEL_HI_RES)) != 0;
+#endif
+    if (isVirtualDevice(fd, path))
+        dev.flags = EventFlag::Injected;
+    bool firstSeen = false;
+    dev.id = registerDevice(path, QString::fromLocal8Bit(name), dev.flags != 0, &firstSeen);
+    devices_.push_back(dev);
+    qDebug() << "EvdevBackend: reading" << path << "as device" << dev.id << name
+             << (dev.flags ? "(virtual, events tagged as injected)" : "");
+    // 虚拟设备在默认的 Drop 策略下什么也录不到，每个设备提示一次（拔插重连不再重复）
+    if (dev.flags && firstSeen && engine_->injectedPolicy() == CaptureEngine::InjectedPolicy::Drop)
+        qWarning() << "EvdevBackend:" << path << "is a virtual device, its events are dropped (use --injected tag to keep them)";
+    return true;
+}
+
+void EvdevBackend::removeDevice(std::size_t index)
+{
+    Device& dev = devices_[index];
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, dev.fd, nullptr);
+    close(dev.fd);
+    {
+        std::lock_guard<std::mutex> lock(knownMutex_);
+        for (InputDeviceInfo& info : known_) {
+            if (info.id == dev.id)
+                info.connected = false;
+        }
+    }
+    devices_.erase(devices_.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+void EvdevBackend::closeDevices()
+{
+    for (Device& dev : devices_) {
+        if (dev.fd >= 0) close(dev.fd);
+    }
+    devices_.clear();
+}
+
+// ======================== 读线程 ========================
+void EvdevBackend::readLoop()
+{
+    applyThreadConfig();
+
+    epoll_event ready[16];
+    while (true) {
+        const int n = epoll_wait(epollFd_, ready, 16, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            qWarning() << "EvdevBackend: epoll_wait failed:" << strerror(errno);
+            return;
+        }
+
+        bool stopping = false;
+        for (int i = 0; i < n; ++i) {
+            const int fd = ready[i].data.fd;
+            if (fd == wakeFd_) {
+                stopping = true;
+                continue;
+            }
+            if (fd == inotifyFd_) {
+                readHotplug();
+                continue;
+            }
+            for (std::size_t d = 0; d < devices_.size(); ++d) {
+                if (devices_[d].fd == fd) {
+                    if (!readDevice(devices_[d]))
+                        removeDevice(d);
+                    break;
+                }
+            }
+        }
+        // 所有就绪设备都读完后再统一入队，保证跨设备的事件按时间先后进入引擎
+        flushPending();
+        if (stopping)
+            return;
+    }
+}
+
+void EvdevBackend::flushPending()
+{
+    if (pending_.empty())
+        return;
+    // 单个设备的事件本来就按时间排列；只有多个设备交错时才需要排序，stable_sort 保留同一时刻的原始顺序
+    const auto byTime = [](const CapturedEvent& a, const CapturedEvent& b) {
+        return a.timestampNs() < b.timestampNs();
+    };
+    if (!std::is_sorted(pending_.begin(), pending_.end(), byTime))
+        std::stable_sort(pending_.begin(), pending_.end(), byTime);
+
+    for (const CapturedEvent& e : pending_) {
+        if (e.category == InputCategory::Mouse)
+            engine_->enqueueMouseEvent(e.mouse);
+        else
+            engine_->enqueueKeyEvent(e.key);
+    }
+    pending_.clear();
+}
+
+// /dev/input 下出现新的 event* 节点：udev 设置好权限前打开可能失败，收到 IN_ATTRIB 时会再试一次
+void EvdevBackend::readHotplug()
+{
+    alignas(inotify_event) char buf[4096];
+    while (true) {
+        const ssize_t bytes = read(inotifyFd_, buf, sizeof(buf));
+        if (bytes <= 0)
+            return;
+        for (ssize_t off = 0; off < bytes; ) {
+            const inotify_event* ev = reinterpret_cast<const inotify_event*>(buf + off);
+            off += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+            if (ev->len == 0 || std::strncmp(ev->name, "event", 5) != 0)
+                continue;
+            openDevice(QString("/dev/input/") + QString::fromLocal8Bit(ev->name));
+        }
+    }
+}
+
+bool EvdevBackend::readDevice(Device& dev)
+{
+    input_event buf[kReadBatch];
+    while (true) {
+        const ssize_t bytes = read(dev.fd, buf, sizeof(buf));
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN) {
+                // 设备被拔出（ENODEV）等错误：由调用方移除，其余设备照常工作
+                qWarning() << "EvdevBackend: lost device" << dev.id << dev.path << strerror(errno);
+                return false;
+            }
+            return true;
+        }
+        handleEvents(dev, buf, static_cast<int>(bytes / static_cast<ssize_t>(sizeof(input_event))));
+        if (bytes < static_cast<ssize_t>(sizeof(buf)))
+            return true;   // 已读空，回到 epoll 等待
+    }
+}
+
+// 相对运动模式下的滚轮：优先使用高精度值（已是 1/120 格），没有时把低精度的格数换算成同一单位
+static quint32 relativeWheelType(unsigned code, bool hiResDevice, qint32& value)
+{
+    switch (code) {
+#ifdef REL_WHEEL_HI_RES
+    case REL_WHEEL_HI_RES:  return InputCode::RawWheel;
+    case REL_HWHEEL_HI_RES: return InputCode::RawHWheel;
+#endif
+    case REL_WHEEL:
+    case REL_HWHEEL:
+        if (hiResDevice)
+            return 0;
+        value *= InputCode::WheelDelta;
+        return code == REL_WHEEL ? InputCode::RawWheel : InputCode::RawHWheel;
+    default:
+        return 0;
+    }
+}
+
+void EvdevBackend::handleEvents(Device& dev, const input_event* events, int count)
+{
+    const bool relative = relativeMotion();
+    for (int i = 0; i < count; ++i) {
+        const input_event& ev = events[i];
+        const qint64 ts = dev.restamp ? captureTimestampNs() : eventTimestampNs(ev);
+
+        switch (ev.type) {
+        case EV_REL:
+            // 相对运动模式仍然累加虚拟光标，按钮事件需要一个位置
+            if (ev.code == REL_X) {
+                cursorX_ += ev.value;
+                if (relative) dev.dx += ev.value;
+                else dev.motionPending = true;
+            } else if (ev.code == REL_Y) {
+                cursorY_ += ev.value;
+                if (relative) dev.dy += ev.value;
+                else dev.motionPending = true;
+            } else if (relative) {
+                qint32 amount = ev.value;
+                if (const quint32 type = relativeWheelType(ev.code, dev.hiResWheel, amount))
+                    pending_.push_back(CapturedEvent::fromMouse(MouseEventData{ amount, 0, type, dev.flags, dev.id, ts }));
+            } else if (ev.code == REL_WHEEL || ev.code == REL_HWHEEL) {
+                const quint32 type = (ev.code == REL_WHEEL) ? InputCode::Wheel : InputCode::HWheel;
+                pending_.push_back(CapturedEvent::fromMouse(MouseEventData{ cursorX_, cursorY_, type, dev.flags, dev.id, ts }));
+            }
+            break;
+
+        case EV_ABS:
+            // 数位板/触摸屏给出的是设备坐标，换算成屏幕像素，鼠标之后的相对位移从这里继续累加
+            if (ev.code == ABS_X) {
+                cursorX_ = scaleAbsolute(ev.value, dev.absMinX, dev.absMaxX, screen_.x(), screen_.width());
+                dev.motionPending = true;
+            } else if (ev.code == ABS_Y) {
+                cursorY_ = scaleAbsolute(ev.value, dev.absMinY, dev.absMaxY, screen_.y(), screen_.height());
+                dev.motionPending = true;
+            }
+            break;
+
+        case EV_KEY: {
+            // value: 0=抬起 1=按下 2=自动重复（与 Windows 钩子一样按「按下」处理）
+            const bool down = ev.value != 0;
+            if (const quint32 msg = linuxButtonToMessage(ev.code, down)) {
+                pending_.push_back(CapturedEvent::fromMouse(MouseEventData{ cursorX_, cursorY_, msg, dev.flags, dev.id, ts }));
+            } else if (const quint32 vk = linuxKeyToVk(ev.code)) {
+                pending_.push_back(CapturedEvent::fromKey(KeyEventData{ vk, down, dev.flags, dev.id, ts }));
+            }
+            break;
+        }
+
+        case EV_SYN:
+            // 一帧结束：同一帧内的 X/Y 位移合并成一个移动事件
+            if (ev.code == SYN_REPORT && (dev.dx != 0 || dev.dy != 0)) {
+                pending_.push_back(CapturedEvent::fromMouse(MouseEventData{ dev.dx, dev.dy, InputCode::RawMotion, dev.flags, dev.id, ts }));
+                dev.dx = 0;
+                dev.dy = 0;
+            }
+            if (ev.code == SYN_REPORT && dev.motionPending) {
+                pending_.push_back(CapturedEvent::fromMouse(MouseEventData{ cursorX_, cursorY_, InputCode::MouseMove, dev.flags, dev.id, ts }));
+                dev.motionPending = false;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef EVDEVBACKEND_H
+#define EVDEVBACKEND_H
+
+#include <QRect>
+#include <QString>
+#include <QStringList>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "capturebackend.h"
+
+struct input_event;
+
+/**
+ * @brief Linux evdev 捕获后端
+ *
+ * - 直接读取 /dev/input/event*（需要 root 或 input 组权限），不依赖 X11/Wayland；
+ * - 一个读线程用 epoll 同时等待所有设备（多个键盘、鼠标、数位板），不为每个设备单独开线程，
+ *   每次 read 批量读取多个 input_event；
+ * - 每个设备分配一个 DeviceId 写入事件；同一次唤醒从多个设备读到的事件按内核时间戳归并后再入队；
+ * - 自动扫描模式下用 inotify 监视 /dev/input，录制中途插入的设备立即开始读取，拔出的设备自动移除；
+ * - 时间戳使用内核写入的 input_event::time（通过 EVIOCSCLOCKID 切换为 CLOCK_MONOTONIC，
+ *   与 captureTimestampNs 的 steady_clock 同源），而不是读到事件时再取时间；个别设备切换时钟失败时，
+ *   该设备的事件退回到读取时用 captureTimestampNs 打时间戳，保证所有事件在同一时间轴上；
+ * - evdev 的鼠标只有相对位移，这里把所有鼠标的位移累加成一个虚拟光标坐标；数位板、触摸屏的绝对坐标
+ *   按设备的 ABS_X / ABS_Y 范围换算到主屏幕像素后写入同一个光标，与鼠标在同一坐标系中；
+ *   相对运动模式下不做累加，直接记录每帧的原始位移和（高精度）滚轮量；
+ * - 按键翻译成 Windows 虚拟键码，鼠标按键翻译成 WM_* 消息值，录制文件与 Windows 端通用。
+ *
+ * - uinput 等程序创建的虚拟设备（sysfs 中位于 /sys/devices/virtual 下，或总线类型为 BUS_VIRTUAL）
+ *   产生的事件标记为 EventFlag::Injected，由引擎按 InjectedPolicy 丢弃或保留；默认策略 Drop 下
+ *   这些设备什么也录不到（首次打开时会打印一次警告），用 uinput 测试时需要 --injected tag。
+ *
+ * 通过 setDevicePaths 可以只读取指定设备，例如测试时用 uinput 创建的虚拟设备
+ * （命令行 --evdev-devices 或配置项 capture/evdevDevices）；这样指定设备且未显式配置注入策略时，
+ * 注入策略默认改为 Tag，否则上述虚拟设备的事件会被全部丢弃。
+ */
+class EvdevBackend : public CaptureBackend
+{
+public:
+    EvdevBackend() = default;
+    ~EvdevBackend() override;
+
+    const char* name() const override { return "evdev"; }
+    bool supportsRelativeMotion() const override { return true; }
+
+    // 指定要读取的设备节点；为空（默认）时扫描 /dev/input/event*
+    void setDevicePaths(const QStringList& paths) { devicePaths_ = paths; }
+
+    bool start(CaptureEngine& engine) override;
+    void stop() override;
+    std::vector<InputDeviceInfo> devices() const override;
+
+private:
+    struct Device {
+        int fd = -1;
+        DeviceId id = 0;
+        EventFlags flags = 0;         // 虚拟设备为 EventFlag::Injected，写入该设备的每个事件
+        QString path;
+        bool motionPending = false;   // 本帧有尚未发出的位移，SYN_REPORT 时合并成一个移动事件
+        qint32 dx = 0;                // 相对运动模式下本帧累计的原始位移
+        qint32 dy = 0;
+        bool hiResWheel = false;      // 设备上报 REL_WHEEL_HI_RES，此时忽略低精度的 REL_WHEEL 避免重复计数
+        bool restamp = false;         // EVIOCSCLOCKID 失败，内核时间戳不是单调时钟，改用读到时的 captureTimestampNs
+        qint32 absMinX = 0;           // 绝对坐标设备的 ABS_X / ABS_Y 取值范围（EVIOCGABS），用于换算到屏幕像素
+        qint32 absMaxX = 0;
+        qint32 absMinY = 0;
+        qint32 absMaxY = 0;
+    };
+
+    bool openDevice(const QString& path);
+    void removeDevice(std::size_t index);
+    void closeDevices();
+    DeviceId registerDevice(const QString& path, const QString& name, bool injected, bool* firstSeen = nullptr);
+    void readLoop();
+    void readHotplug();
+    bool readDevice(Device& dev);   // 返回 false 表示设备已失效（被拔出等）
+    void handleEvents(Device& dev, const input_event* events, int count);
+    void flushPending();
+
+private:
+    CaptureEngine* engine_ = nullptr;
+    QStringList devicePaths_;
+    std::vector<Device> devices_;
+
+    int epollFd_ = -1;
+    int wakeFd_ = -1;      // eventfd，stop() 写入后读线程立即退出
+    int inotifyFd_ = -1;   // 监视 /dev/input 的设备增减，仅自动扫描模式下启用
+    std::thread thread_;
+
+    // 一次 epoll 唤醒读到的所有事件，按时间戳排序后统一入队（只由读线程访问，容量复用）
+    std::vector<CapturedEvent> pending_;
+
+    // 本次运行出现过的设备；读线程写，devices() 可在任意线程读
+    mutable std::mutex knownMutex_;
+    std::vector<InputDeviceInfo> known_;
+
+    // 虚拟光标：累加所有设备的相对位移，SYN_REPORT 时发出一次移动事件
+    qint32 cursorX_ = 0;
+    qint32 cursorY_ = 0;
+    // 绝对坐标映射到的屏幕区域，start() 时在调用线程（GUI 线程）取主屏幕；取不到时为空，按设备坐标记录
+    QRect screen_;
+};
+
+#endif // EVDEVBACKEND_H
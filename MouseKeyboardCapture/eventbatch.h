@@ -0,0 +1,34 @@
+#ifndef EVENTBATCH_H
+#define EVENTBATCH_H
+
+#include <memory>
+#include <vector>
+#include "inputevent.h"
+
+/**
+ * @brief 一批捕获事件（共享、只读）
+ *
+ * CaptureEngine 工作线程一次取空队列后打包成一个 EventBatch 发布到 EventBus；
+ * 每个订阅者取到的只是一个 shared_ptr 的副本，所有订阅者读同一块缓冲区，
+ * 最后一个持有者释放时才回收内存。
+ */
+class EventBatch
+{
+public:
+    EventBatch() = default;
+    explicit EventBatch(std::vector<CapturedEvent>&& events)
+        : events_(std::make_shared<const std::vector<CapturedEvent>>(std::move(events)))
+    {}
+
+    const CapturedEvent* begin() const { return events_ ? events_->data() : nullptr; }
+    const CapturedEvent* end() const { return events_ ? events_->data() + events_->size() : nullptr; }
+
+    std::size_t size() const { return events_ ? events_->size() : 0; }
+    bool isEmpty() const { return size() == 0; }
+    const CapturedEvent& at(std::size_t i) const { return (*events_)[i]; }
+
+private:
+    std::shared_ptr<const std::vector<CapturedEvent>> events_;
+};
+
+#endif // EVENTBATCH_H
@@ -0,0 +1,243 @@
+#include "eventbus.h"
+#include <algorithm>
+
+// ======================== EventBus ========================
+EventBus::~EventBus()
+{
+    // 进程退出时订阅对象可能比总线活得久：先把它们关闭并断开，之后只能读完各自剩余的批次
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!subs_.empty()) {
+        EventSubscription* sub = subs_.back();
+        sub->closeLocked();
+        sub->bus_ = nullptr;
+    }
+}
+
+std::shared_ptr<EventSubscription> EventBus::subscribe(const QString& name, Delivery delivery, quint64 maxLagEvents)
+{
+    auto sub = std::make_shared<EventSubscription>(this, name, delivery, maxLagEvents);
+    std::lock_guard<std::mutex> lock(mutex_);
+    sub->nextSeq_ = headSeq();
+    sub->consumedEvents_ = publishedEvents_;
+    subs_.push_back(sub.get());
+    return sub;
+}
+
+void EventBus::publish(const EventBatch& batch)
+{
+    if (batch.isEmpty())
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    publishedEvents_ += batch.size();
+    slots_.push_back(Slot{ batch, publishedEvents_ });
+    const quint64 head = headSeq();
+
+    for (EventSubscription* sub : subs_) {
+        // Lossy 订阅者积压过多：跳过最旧的批次，最新的一个总是保留
+        if (sub->stats_.delivery == Delivery::Lossy && sub->maxLagEvents_ > 0) {
+            while (publishedEvents_ - sub->consumedEvents_ > sub->maxLagEvents_ && sub->nextSeq_ + 1 < head) {
+                const Slot& skipped = slots_[static_cast<std::size_t>(sub->nextSeq_ - baseSeq_)];
+                ++sub->stats_.skippedBatches;
+                sub->stats_.skippedEvents += skipped.batch.size();
+                sub->consumedEvents_ = skipped.endEvents;
+                ++sub->nextSeq_;
+            }
+        }
+        const quint64 lag = publishedEvents_ - sub->consumedEvents_;
+        if (lag > sub->stats_.lagHighWater)
+            sub->stats_.lagHighWater = lag;
+
+        sub->cv_.notify_one();
+        if (sub->notify_ && !sub->notified_) {
+            sub->notified_ = true;
+            sub->notify_();
+        }
+    }
+    trim();
+    updateLag();
+}
+
+void EventBus::trim()
+{
+    quint64 minSeq = headSeq();
+    for (const EventSubscription* sub : subs_)
+        minSeq = std::min(minSeq, sub->nextSeq_);
+    while (baseSeq_ < minSeq) {
+        slots_.pop_front();
+        ++baseSeq_;
+    }
+}
+
+void EventBus::updateLag()
+{
+    quint64 lag = 0;
+    for (const EventSubscription* sub : subs_) {
+        if (sub->stats_.delivery == Delivery::Lossless)
+            lag = std::max(lag, publishedEvents_ - sub->consumedEvents_);
+    }
+    lagEvents_.store(lag, std::memory_order_relaxed);
+}
+
+void EventBus::setReadNotify(std::function<void()> notify)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    readNotify_ = std::move(notify);
+}
+
+quint64 EventBus::publishedEvents() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return publishedEvents_;
+}
+
+std::vector<EventBus::SubscriberStats> EventBus::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<SubscriberStats> out;
+    out.reserve(subs_.size());
+    for (const EventSubscription* sub : subs_) {
+        SubscriberStats s = sub->stats_;
+        s.lagEvents = publishedEvents_ - sub->consumedEvents_;
+        out.push_back(s);
+    }
+    return out;
+}
+
+// ======================== EventSubscription ========================
+EventSubscription::EventSubscription(EventBus* bus, const QString& name, EventBus::Delivery delivery, quint64 maxLagEvents)
+    : bus_(bus), maxLagEvents_(maxLagEvents)
+{
+    stats_.name = name;
+    stats_.delivery = delivery;
+}
+
+EventSubscription::~EventSubscription()
+{
+    close();
+}
+
+bool EventSubscription::hasUnread() const
+{
+    return !remaining_.empty() || (bus_ && !closed_ && nextSeq_ < bus_->headSeq());
+}
+
+void EventSubscription::take(std::vector<EventBatch>& out)
+{
+    if (!remaining_.empty()) {
+        stats_.batches += remaining_.size();
+        stats_.events += remainingEvents_;
+        out.insert(out.end(), remaining_.begin(), remaining_.end());
+        remaining_.clear();
+        remainingEvents_ = 0;
+    }
+    if (!bus_ || closed_)
+        return;
+
+    const quint64 head = bus_->headSeq();
+    for (; nextSeq_ < head; ++nextSeq_) {
+        const EventBus::Slot& slot = bus_->slots_[static_cast<std::size_t>(nextSeq_ - bus_->baseSeq_)];
+        out.push_back(slot.batch);
+        ++stats_.batches;
+        stats_.events += slot.batch.size();
+        consumedEvents_ = slot.endEvents;
+    }
+    notified_ = false;
+    bus_->trim();
+    bus_->updateLag();
+    if (bus_->readNotify_)
+        bus_->readNotify_();
+}
+
+bool EventSubscription::poll(std::vector<EventBatch>& out)
+{
+    if (!bus_) {
+        const bool any = !remaining_.empty();
+        take(out);
+        return any;
+    }
+    std::lock_guard<std::mutex> lock(bus_->mutex_);
+    if (!hasUnread()) {
+        notified_ = false;
+        return false;
+    }
+    take(out);
+    return true;
+}
+
+bool EventSubscription::wait(std::vector<EventBatch>& out)
+{
+    if (!bus_)
+        return poll(out);
+    std::unique_lock<std::mutex> lock(bus_->mutex_);
+    cv_.wait(lock, [this] { return closed_ || hasUnread(); });
+    if (!hasUnread())
+        return false;
+    take(out);
+    return true;
+}
+
+bool EventSubscription::wait(std::vector<EventBatch>& out, std::chrono::steady_clock::time_point deadline)
+{
+    if (!bus_)
+        return poll(out);
+    std::unique_lock<std::mutex> lock(bus_->mutex_);
+    cv_.wait_until(lock, deadline, [this] { return closed_ || hasUnread(); });
+    if (!hasUnread())
+        return !closed_;
+    take(out);
+    return true;
+}
+
+void EventSubscription::setNotify(std::function<void()> notify)
+{
+    if (!bus_) return;
+    std::lock_guard<std::mutex> lock(bus_->mutex_);
+    notify_ = std::move(notify);
+    notified_ = false;
+}
+
+void EventSubscription::close()
+{
+    if (!bus_) return;
+    std::lock_guard<std::mutex> lock(bus_->mutex_);
+    closeLocked();
+}
+
+void EventSubscription::closeLocked()
+{
+    if (closed_)
+        return;
+    // 未读的批次移到自己名下，之后总线可以不再为它保留
+    const quint64 head = bus_->headSeq();
+    for (; nextSeq_ < head; ++nextSeq_) {
+        const EventBus::Slot& slot = bus_->slots_[static_cast<std::size_t>(nextSeq_ - bus_->baseSeq_)];
+        remaining_.push_back(slot.batch);
+        remainingEvents_ += slot.batch.size();
+        consumedEvents_ = slot.endEvents;
+    }
+    closed_ = true;
+    notify_ = nullptr;
+    bus_->subs_.erase(std::remove(bus_->subs_.begin(), bus_->subs_.end(), this), bus_->subs_.end());
+    bus_->trim();
+    bus_->updateLag();
+    if (bus_->readNotify_)
+        bus_->readNotify_();
+    cv_.notify_all();
+}
+
+bool EventSubscription::isClosed() const
+{
+    if (!bus_) return true;
+    std::lock_guard<std::mutex> lock(bus_->mutex_);
+    return closed_;
+}
+
+EventBus::SubscriberStats EventSubscription::stats() const
+{
+    if (!bus_) return stats_;
+    std::lock_guard<std::mutex> lock(bus_->mutex_);
+    EventBus::SubscriberStats s = stats_;
+    s.lagEvents = closed_ ? remainingEvents_ : bus_->publishedEvents_ - consumedEvents_;
+    return s;
+}
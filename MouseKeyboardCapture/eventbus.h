@@ -0,0 +1,143 @@
+#ifndef EVENTBUS_H
+#define EVENTBUS_H
+
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "eventbatch.h"
+
+class EventSubscription;
+
+/**
+ * @brief 进程内事件总线（一个发布者，多个订阅者）
+ *
+ * CaptureEngine 工作线程把每个批次发布一次，总线按序号保存共享的 EventBatch；
+ * 每个订阅者（界面、录制、统计、网络……）有自己的游标，在自己的线程里读取同一块只读缓冲区，
+ * 不经过 Qt 事件队列，也不会因为某个订阅者慢而复制事件。
+ *
+ * 背压按订阅者各自处理：
+ * - Lossless：不丢批次。它的积压计入 lagEvents()，CaptureEngine 据此判断下游过载并按 OverloadPolicy 处理；
+ * - Lossy：积压超过 maxLagEvents 时跳过最旧的批次并计数，不影响发布端和其它订阅者（例如界面日志）。
+ * 所有订阅者都读过的批次立即从总线移除，最后一个持有者释放后内存回收。
+ */
+class EventBus
+{
+public:
+    enum class Delivery {
+        Lossless,
+        Lossy
+    };
+
+    struct SubscriberStats {
+        QString name;
+        Delivery delivery = Delivery::Lossless;
+        quint64 batches = 0;          // 已读取的批次
+        quint64 events = 0;           // 已读取的事件
+        quint64 skippedBatches = 0;   // Lossy：因积压被跳过的批次
+        quint64 skippedEvents = 0;
+        quint64 lagEvents = 0;        // 当前积压（已发布、尚未读取）
+        quint64 lagHighWater = 0;
+    };
+
+    EventBus() = default;
+    ~EventBus();
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    // 订阅从此刻起发布的批次；Lossy 订阅需要给出 maxLagEvents（0 表示不限制，但仍不计入 lagEvents）。
+    // 返回的订阅对象析构时自动注销
+    std::shared_ptr<EventSubscription> subscribe(const QString& name, Delivery delivery, quint64 maxLagEvents = 0);
+
+    // 发布一个批次（只由 CaptureEngine 工作线程调用），空批次直接忽略
+    void publish(const EventBatch& batch);
+
+    // Lossless 订阅者中最大的积压事件数，无锁读取，供发布端判断是否过载
+    quint64 lagEvents() const { return lagEvents_.load(std::memory_order_relaxed); }
+    // 任一订阅者读走批次（或注销）后调用，供发布端在积压下降时醒来；在读取方线程上、持有总线的锁时调用，不能阻塞
+    void setReadNotify(std::function<void()> notify);
+    quint64 publishedEvents() const;
+    std::vector<SubscriberStats> stats() const;
+
+private:
+    friend class EventSubscription;
+
+    struct Slot {
+        EventBatch batch;
+        quint64 endEvents;   // 发布到这个批次为止的累计事件数，用来按事件数计算积压
+    };
+
+    quint64 headSeq() const { return baseSeq_ + slots_.size(); }
+    void trim();        // 移除所有订阅者都已读过的批次（调用方持有 mutex_）
+    void updateLag();   // 重新计算 lagEvents_（调用方持有 mutex_）
+
+private:
+    mutable std::mutex mutex_;
+    std::deque<Slot> slots_;
+    quint64 baseSeq_ = 0;            // slots_.front() 的序号
+    quint64 publishedEvents_ = 0;
+    std::vector<EventSubscription*> subs_;
+    std::atomic<quint64> lagEvents_{0};
+    std::function<void()> readNotify_;
+};
+
+/**
+ * @brief 一个订阅者在总线上的游标
+ *
+ * 读取方法只能由订阅者自己的一个线程调用。两种读取方式：
+ * - 专用线程（例如 RecorderWorker）循环调用 wait()；
+ * - Qt 对象用 setNotify() 注册通知，在回调里把读取调度回自己的线程，再调用 poll()。
+ *   通知只在「已读完 → 有未读」时发一次，读取前再来多少批次都不会重复通知。
+ */
+class EventSubscription
+{
+public:
+    EventSubscription(EventBus* bus, const QString& name, EventBus::Delivery delivery, quint64 maxLagEvents);
+    ~EventSubscription();
+    EventSubscription(const EventSubscription&) = delete;
+    EventSubscription& operator=(const EventSubscription&) = delete;
+
+    // 取出所有未读批次追加到 out，没有未读批次时返回 false
+    bool poll(std::vector<EventBatch>& out);
+    // 阻塞到有未读批次或订阅被关闭；关闭后仍先返回剩余批次，全部取完后返回 false
+    bool wait(std::vector<EventBatch>& out);
+    // 同上，但最多等到 deadline：超时时 out 不变、返回 true，只有关闭且取完时才返回 false
+    bool wait(std::vector<EventBatch>& out, std::chrono::steady_clock::time_point deadline);
+
+    // 有新批次时在发布线程上调用（持有总线的锁，close() 返回后保证不会再被调用），回调里不能阻塞
+    void setNotify(std::function<void()> notify);
+
+    // 停止接收新批次并从总线注销，已发布的批次仍可读完；可以在任意线程调用
+    void close();
+    bool isClosed() const;
+
+    EventBus::SubscriberStats stats() const;
+
+private:
+    friend class EventBus;
+
+    // 以下只在持有 bus_->mutex_ 时访问
+    bool hasUnread() const;
+    void take(std::vector<EventBatch>& out);
+    void closeLocked();
+
+private:
+    EventBus* bus_;                  // 总线先于订阅对象销毁时置空
+    EventBus::SubscriberStats stats_;
+    quint64 maxLagEvents_;
+    quint64 nextSeq_ = 0;            // 下一个要读的批次序号
+    quint64 consumedEvents_ = 0;     // 已读（或跳过）到的累计事件数
+    bool closed_ = false;
+    bool notified_ = false;          // 已通知、订阅者尚未读完
+    std::function<void()> notify_;
+    std::vector<EventBatch> remaining_;   // 关闭时尚未读取的批次，从总线移出后由这里保存
+    quint64 remainingEvents_ = 0;
+    std::condition_variable cv_;
+};
+
+#endif // EVENTBUS_H
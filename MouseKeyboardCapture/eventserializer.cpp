@@ -0,0 +1,184 @@
+#include "eventserializer.h"
+#include "blockcodec.h"
+#include "inputcodes.h"
+#include "journal.h"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cstring>
+
+// JSON 按平台换行（与以前用文本模式写文件的结果相同），文件以二进制方式打开，一个批次只需一次写入
+#ifdef Q_OS_WIN
+#define LINE_END "\r\n"
+#else
+#define LINE_END "\n"
+#endif
+
+// 使用捕获时刻的时间戳（而不是写入的时刻）计算相对时间，
+// 这样队列和写入线程的延迟不会混入录制的时序；录制开始前已入队的事件记为 0
+static qint64 relativeTimestampUs(qint64 captureNs, qint64 startNs)
+{
+    return captureNs > startNs ? (captureNs - startNs) / 1000 : 0;
+}
+
+// 把字符串字面量（不含结尾的 0）拷到 p，返回写入后的位置
+template <std::size_t N>
+static char* put(char* p, const char (&text)[N])
+{
+    std::memcpy(p, text, N - 1);
+    return p + N - 1;
+}
+
+static char* putInt(char* p, qint64 v)
+{
+    char digits[20];
+    int n = 0;
+    // 先转成无符号再取反，最小负数也不会溢出
+    quint64 u = static_cast<quint64>(v);
+    if (v < 0) {
+        *p++ = '-';
+        u = 0 - u;
+    }
+    do {
+        digits[n++] = static_cast<char>('0' + u % 10);
+        u /= 10;
+    } while (u);
+    while (n)
+        *p++ = digits[--n];
+    return p;
+}
+
+static QJsonArray devicesToJson(const std::vector<InputDeviceInfo>& devices)
+{
+    QJsonArray array;
+    for (const InputDeviceInfo& d : devices) {
+        QJsonObject json;
+        json["id"] = d.id;
+        json["name"] = d.name;
+        json["path"] = d.path;
+        if (d.injected)
+            json["injected"] = true;
+        array.append(json);
+    }
+    return array;
+}
+
+EventSerializer::Format EventSerializer::formatForPath(const QString& path)
+{
+    // .mkrz / .mkj 的内容也是 .mkr 字节流，分别由 CompressedSink 分块压缩、由 JournalSink 分帧校验
+    return RecordFormat::isBinaryPath(path) || BlockCodec::isCompressedPath(path) || Journal::isJournalPath(path)
+               ? Format::Binary : Format::Json;
+}
+
+EventSerializer::EventSerializer(Format format, qint64 startNs)
+    : format_(format), startNs_(startNs), binary_(startNs)
+{
+}
+
+void EventSerializer::appendHeader(QByteArray& out)
+{
+    const QString startTime = QDateTime::currentDateTime().toString(Qt::ISODate);
+    if (format_ == Format::Binary) {
+        QJsonObject meta;
+        meta["record_start_time"] = startTime;
+        meta["time_unit"] = "us";
+        binary_.appendHeader(out, meta);
+        return;
+    }
+    out.append("{" LINE_END "  \"record_start_time\": \"");
+    out.append(startTime.toUtf8());
+    out.append("\"," LINE_END "  \"events\": [" LINE_END);
+}
+
+void EventSerializer::appendEvent(QByteArray& out, const CapturedEvent& e)
+{
+    if (format_ == Format::Binary) {
+        binary_.appendEvent(out, e);
+        return;
+    }
+    char rec[kMaxEventBytes];
+    out.append(rec, encodeJson(rec, e));
+}
+
+// 字段按键名排序输出（与 QJsonObject 一致）：
+// 鼠标 category, [delta], device, [dx, dy], injected, timestamp_us, type, [x, y]
+// 键盘 category, device, injected, keyDown, timestamp_us, vkCode
+// 相对运动只写位移或滚动量；device 只在后端能区分设备时写，injected 只在 InjectedPolicy::Tag 下出现
+int EventSerializer::encodeJson(char* rec, const CapturedEvent& e)
+{
+    char* p = rec;
+    if (!first_)
+        p = put(p, "," LINE_END);
+    first_ = false;
+
+    if (e.category == InputCategory::Mouse) {
+        const MouseEventData& m = e.mouse;
+        const bool motion = (m.type == InputCode::RawMotion);
+        const bool relative = InputCode::isRelative(m.type);
+        p = put(p, "{\"category\":\"mouse\"");
+        if (relative && !motion) {
+            p = put(p, ",\"delta\":");
+            p = putInt(p, m.x);
+        }
+        if (m.deviceId != 0) {
+            p = put(p, ",\"device\":");
+            p = putInt(p, m.deviceId);
+        }
+        if (motion) {
+            p = put(p, ",\"dx\":");
+            p = putInt(p, m.x);
+            p = put(p, ",\"dy\":");
+            p = putInt(p, m.y);
+        }
+        if (m.flags & EventFlag::Injected)
+            p = put(p, ",\"injected\":true");
+        p = put(p, ",\"timestamp_us\":");
+        p = putInt(p, relativeTimestampUs(m.timestampNs, startNs_));
+        p = put(p, ",\"type\":");
+        p = putInt(p, static_cast<qint32>(m.type));
+        if (!relative) {
+            p = put(p, ",\"x\":");
+            p = putInt(p, m.x);
+            p = put(p, ",\"y\":");
+            p = putInt(p, m.y);
+        }
+    } else {
+        const KeyEventData& k = e.key;
+        p = put(p, "{\"category\":\"keyboard\"");
+        if (k.deviceId != 0) {
+            p = put(p, ",\"device\":");
+            p = putInt(p, k.deviceId);
+        }
+        if (k.flags & EventFlag::Injected)
+            p = put(p, ",\"injected\":true");
+        p = k.keyDown ? put(p, ",\"keyDown\":true") : put(p, ",\"keyDown\":false");
+        p = put(p, ",\"timestamp_us\":");
+        p = putInt(p, relativeTimestampUs(k.timestampNs, startNs_));
+        p = put(p, ",\"vkCode\":");
+        p = putInt(p, static_cast<qint32>(k.vkCode));
+    }
+    *p++ = '}';
+    return static_cast<int>(p - rec);
+}
+
+void EventSerializer::appendSync(QByteArray& out)
+{
+    if (format_ == Format::Binary)
+        binary_.appendSync(out);
+}
+
+void EventSerializer::appendFooter(QByteArray& out, const std::vector<InputDeviceInfo>& devices)
+{
+    if (format_ == Format::Binary) {
+        for (const InputDeviceInfo& d : devices)
+            binary_.appendDevice(out, d);
+        return;
+    }
+    out.append(LINE_END "  ]");
+    if (!devices.empty()) {
+        out.append("," LINE_END "  \"devices\": ");
+        out.append(QJsonDocument(devicesToJson(devices)).toJson(QJsonDocument::Compact));
+    }
+    out.append(LINE_END "}" LINE_END);
+}
@@ -0,0 +1,57 @@
+#ifndef EVENTSERIALIZER_H
+#define EVENTSERIALIZER_H
+
+#include <QByteArray>
+#include <QString>
+#include <vector>
+#include "capturebackend.h"
+#include "inputevent.h"
+#include "recordformat.h"
+
+/**
+ * @brief 录制文件序列化（JSON 或 .mkr 二进制），只由一个写入线程使用
+ *
+ * 事件直接从 POD 编码，不经过 QJsonObject / QJsonDocument：
+ * 每个事件先写进栈上的定长缓冲，再追加到调用方的输出缓冲。
+ * 输出缓冲用 QByteArray::reserve() 预留容量、写出后用 resize(0) 清空（保留容量），
+ * 稳态下序列化一个事件不做任何堆分配。
+ *
+ * JSON 的字段顺序和数字格式与之前 QJsonDocument::Compact 的输出逐字节相同，已有的工具和回放照常读取。
+ * 文件头、文件尾（设备表）每次录制只写一次，仍用 Qt 的 JSON 类生成。
+ */
+class EventSerializer
+{
+public:
+    enum class Format {
+        Json,
+        Binary
+    };
+
+    // 一个事件序列化后的最大字节数（含 JSON 的分隔符），输出缓冲至少预留这么多余量
+    static constexpr int kMaxEventBytes = 192;
+
+    // 按扩展名选择格式：.mkr / .mkrz / .mkj 为二进制，其它为 JSON
+    static Format formatForPath(const QString& path);
+
+    // startNs：录制开始时刻（captureTimestampNs），事件时间戳相对它计算
+    EventSerializer(Format format, qint64 startNs);
+
+    Format format() const { return format_; }
+
+    void appendHeader(QByteArray& out);
+    void appendEvent(QByteArray& out, const CapturedEvent& e);
+    void appendFooter(QByteArray& out, const std::vector<InputDeviceInfo>& devices);
+    // 二进制格式：写一条 RecordFormat::Sync 记录，之后的数据可以单独解码；JSON 不写
+    void appendSync(QByteArray& out);
+
+private:
+    int encodeJson(char* p, const CapturedEvent& e);
+
+private:
+    Format format_;
+    qint64 startNs_;
+    RecordFormat::Encoder binary_;
+    bool first_ = true;   // JSON：第一个事件前不写分隔符
+};
+
+#endif // EVENTSERIALIZER_H
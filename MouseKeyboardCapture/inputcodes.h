@@ -0,0 +1,37 @@
+#ifndef INPUTCODES_H
+#define INPUTCODES_H
+
+#include <QtGlobal>
+
+/**
+ * @brief 录制文件中使用的事件类型编码
+ * 鼠标类型沿用 Windows 消息值（WM_MOUSEMOVE 等），键盘使用 Windows 虚拟键码，
+ * 这样无论在哪个平台上捕获，录制文件的内容和回放逻辑都保持一致。
+ */
+namespace InputCode {
+
+constexpr quint32 MouseMove      = 0x0200;  // WM_MOUSEMOVE
+constexpr quint32 LeftDown       = 0x0201;  // WM_LBUTTONDOWN
+constexpr quint32 LeftUp         = 0x0202;  // WM_LBUTTONUP
+constexpr quint32 RightDown      = 0x0204;  // WM_RBUTTONDOWN
+constexpr quint32 RightUp        = 0x0205;  // WM_RBUTTONUP
+constexpr quint32 MiddleDown     = 0x0207;  // WM_MBUTTONDOWN
+constexpr quint32 MiddleUp       = 0x0208;  // WM_MBUTTONUP
+constexpr quint32 Wheel          = 0x020A;  // WM_MOUSEWHEEL
+constexpr quint32 XButtonDown    = 0x020B;  // WM_XBUTTONDOWN
+constexpr quint32 XButtonUp      = 0x020C;  // WM_XBUTTONUP
+constexpr quint32 HWheel         = 0x020E;  // WM_MOUSEHWHEEL
+
+// 相对运动模式使用的私有编码，不对应任何 WM_* 消息：
+// RawMotion 的 x/y 是设备上报的原始位移（未经指针加速，不受屏幕边界限制），
+// RawWheel / RawHWheel 的 x 是滚动量，单位为 1/WheelDelta 格（与 Windows 的 WHEEL_DELTA、Linux 的高精度滚轮一致）
+constexpr quint32 RawMotion      = 0x10000;
+constexpr quint32 RawWheel       = 0x10001;
+constexpr quint32 RawHWheel      = 0x10002;
+constexpr qint32  WheelDelta     = 120;
+
+inline bool isRelative(quint32 type) { return type >= RawMotion && type <= RawHWheel; }
+
+} // namespace InputCode
+
+#endif // INPUTCODES_H
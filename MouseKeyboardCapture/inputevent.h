@@ -0,0 +1,119 @@
+#ifndef INPUTEVENT_H
+#define INPUTEVENT_H
+
+#include <QtGlobal>
+#include <chrono>
+#include <type_traits>
+
+/**
+ * @brief 捕获时间戳（纳秒）
+ * 使用单调时钟 steady_clock（Windows 上为 QueryPerformanceCounter），
+ * 不受系统时间调整和时区影响，开销远小于 QDateTime::currentDateTime()。
+ * 只有差值有意义，不能当作墙上时间显示。
+ */
+inline qint64 captureTimestampNs()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 输入设备编号
+ * 由捕获后端在本次运行内分配（从 1 开始），0 表示后端无法区分设备（例如 Windows 低层钩子）。
+ * 编号与设备名称、路径的对应关系见 CaptureBackend::devices()。
+ */
+using DeviceId = quint16;
+
+/**
+ * @brief 事件标志位
+ * Injected：事件不是来自物理设备，而是由程序注入的（SendInput、uinput 等），
+ * 包括本程序回放时发出的事件。录制和回放同时进行时据此避免把回放结果再录进去。
+ */
+using EventFlags = quint8;
+namespace EventFlag {
+constexpr EventFlags Injected = 0x01;
+}
+
+/**
+ * @brief 鼠标事件数据结构（POD，可直接放入无锁队列）
+ */
+struct MouseEventData {
+    qint32 x;              // 鼠标坐标
+    qint32 y;
+    quint32 type;          // 消息类型（WM_MOUSEMOVE 等）
+    EventFlags flags;      // EventFlag::*
+    DeviceId deviceId;     // 产生事件的设备（标志位和设备编号放在时间戳前的对齐空隙里，不增加结构体大小）
+    qint64 timestampNs;    // 捕获时间（captureTimestampNs）
+};
+
+/**
+ * @brief 键盘事件数据结构（POD）
+ */
+struct KeyEventData {
+    quint32 vkCode;        // 虚拟键码
+    bool keyDown;          // true=按下，false=抬起
+    EventFlags flags;      // EventFlag::*
+    DeviceId deviceId;     // 产生事件的设备
+    qint64 timestampNs;    // 捕获时间（captureTimestampNs）
+};
+
+enum class InputCategory : quint8 {
+    Mouse,
+    Keyboard
+};
+
+/**
+ * @brief 统一的捕获事件（带类别标签的联合体，仍为 POD）
+ * 鼠标和键盘事件按捕获时间归并到同一个批次中，录制文件中的顺序即为真实发生顺序。
+ */
+struct CapturedEvent {
+    InputCategory category;
+    union {
+        MouseEventData mouse;
+        KeyEventData key;
+    };
+
+    qint64 timestampNs() const
+    {
+        return category == InputCategory::Mouse ? mouse.timestampNs : key.timestampNs;
+    }
+
+    DeviceId deviceId() const
+    {
+        return category == InputCategory::Mouse ? mouse.deviceId : key.deviceId;
+    }
+
+    EventFlags flags() const
+    {
+        return category == InputCategory::Mouse ? mouse.flags : key.flags;
+    }
+
+    bool isInjected() const { return (flags() & EventFlag::Injected) != 0; }
+
+    static CapturedEvent fromMouse(const MouseEventData& m)
+    {
+        CapturedEvent e;
+        e.category = InputCategory::Mouse;
+        e.mouse = m;
+        return e;
+    }
+
+    static CapturedEvent fromKey(const KeyEventData& k)
+    {
+        CapturedEvent e;
+        e.category = InputCategory::Keyboard;
+        e.key = k;
+        return e;
+    }
+};
+
+static_assert(std::is_trivial<MouseEventData>::value && std::is_standard_layout<MouseEventData>::value,
+              "MouseEventData must stay POD");
+static_assert(std::is_trivial<KeyEventData>::value && std::is_standard_layout<KeyEventData>::value,
+              "KeyEventData must stay POD");
+static_assert(sizeof(MouseEventData) == 24 && sizeof(KeyEventData) == 16,
+              "device and flag tagging must not grow the queued event structs");
+static_assert(std::is_trivially_copyable<CapturedEvent>::value,
+              "CapturedEvent must stay trivially copyable");
+
+#endif // INPUTEVENT_H
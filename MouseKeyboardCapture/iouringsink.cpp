@@ -0,0 +1,398 @@
+#include "iouringsink.h"
+#include <QDebug>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr unsigned kRingEntries = 64;    // 同时在途的请求上限（完成队列为它的两倍，不会溢出）
+
+int ioUringSetup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned count)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+} // namespace
+
+bool IoUringSink::isAvailable()
+{
+    static const bool available = []() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        const int fd = ioUringSetup(4, &params);
+        if (fd < 0) {
+            qDebug() << "IoUringSink: io_uring unavailable:" << std::strerror(errno);
+            return false;
+        }
+        ::close(fd);
+        return true;
+    }();
+    return available;
+}
+
+IoUringSink::IoUringSink(const QString& path, int bufferCount, int bufferBytes)
+    : file_(path)
+    , bufferCount_(std::max(2, bufferCount))
+    , bufferBytes_(std::max(64 * 1024, bufferBytes))
+{
+}
+
+IoUringSink::~IoUringSink()
+{
+    close();
+}
+
+bool IoUringSink::setupRing()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFd_ = ioUringSetup(kRingEntries, &params);
+    if (ringFd_ < 0)
+        return false;
+
+    sqRingBytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingBytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMmap)
+        sqRingBytes_ = cqRingBytes_ = std::max(sqRingBytes_, cqRingBytes_);
+
+    sqRing_ = ::mmap(nullptr, sqRingBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        sqRing_ = nullptr;
+        return false;
+    }
+    if (singleMmap) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = ::mmap(nullptr, cqRingBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            cqRing_ = nullptr;
+            return false;
+        }
+    }
+    sqesBytes_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqesBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+        return false;
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqEntries_ = params.sq_entries;
+    char* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    cqEntries_ = params.cq_entries;
+    return true;
+}
+
+void IoUringSink::teardownRing()
+{
+    if (sqes_)
+        ::munmap(sqes_, sqesBytes_);
+    if (cqRing_ && cqRing_ != sqRing_)
+        ::munmap(cqRing_, cqRingBytes_);
+    if (sqRing_)
+        ::munmap(sqRing_, sqRingBytes_);
+    if (ringFd_ >= 0)
+        ::close(ringFd_);   // 关闭 fd 同时注销已注册的缓冲
+    sqes_ = nullptr;
+    sqRing_ = cqRing_ = nullptr;
+    ringFd_ = -1;
+}
+
+bool IoUringSink::open()
+{
+    if (!file_.open(QIODevice::WriteOnly | QIODevice::Unbuffered))
+        return false;
+    if (!setupRing()) {
+        qWarning() << "IoUringSink: io_uring setup failed:" << std::strerror(errno);
+        teardownRing();
+        file_.close();
+        return false;
+    }
+
+    // 页对齐的缓冲池，启动时一次分配
+    buffers_.assign(static_cast<std::size_t>(bufferCount_), Buffer());
+    iovecs_.resize(buffers_.size());
+    for (std::size_t i = 0; i < buffers_.size(); ++i) {
+        void* p = nullptr;
+        if (::posix_memalign(&p, 4096, static_cast<std::size_t>(bufferBytes_)) != 0) {
+            close();
+            return false;
+        }
+        buffers_[i].data = static_cast<char*>(p);
+        iovecs_[i].iov_base = p;
+        iovecs_[i].iov_len = static_cast<std::size_t>(bufferBytes_);
+    }
+    stats_ = Stats();
+    stats_.registeredBuffers =
+        ioUringRegister(ringFd_, IORING_REGISTER_BUFFERS, iovecs_.data(), static_cast<unsigned>(iovecs_.size())) == 0;
+    if (!stats_.registeredBuffers)
+        qDebug() << "IoUringSink: buffer registration failed, using WRITEV:" << std::strerror(errno);
+
+    ops_.assign(kRingEntries, Op());
+    opIovecs_.assign(kRingEntries, iovec());
+    freeOps_.clear();
+    for (int i = static_cast<int>(kRingEntries) - 1; i >= 0; --i)
+        freeOps_.push_back(i);
+    current_ = -1;
+    offset_ = 0;
+    inFlight_ = 0;
+    failed_ = false;
+    return true;
+}
+
+int IoUringSink::allocOp()
+{
+    while (freeOps_.empty()) {
+        if (!waitForCompletion())
+            return -1;
+    }
+    const int op = freeOps_.back();
+    freeOps_.pop_back();
+    return op;
+}
+
+bool IoUringSink::prepareAndSubmit(int index)
+{
+    const Op& op = ops_[static_cast<std::size_t>(index)];
+    // 只有一个提交者（持有 mutex_），请求数不超过队列长度，提交队列总有空位
+    const unsigned tail = *sqTail_;
+    const unsigned slot = tail & sqMask_;
+    io_uring_sqe* sqe = &sqes_[slot];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = file_.handle();
+    sqe->user_data = static_cast<quint64>(index);
+    if (op.isSync) {
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        sqe->flags = IOSQE_IO_DRAIN;   // 等之前提交的写入全部完成后再执行
+    } else if (stats_.registeredBuffers) {
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->addr = reinterpret_cast<quint64>(buffers_[static_cast<std::size_t>(op.buffer)].data + op.offsetInBuffer);
+        sqe->len = static_cast<unsigned>(op.length);
+        sqe->off = static_cast<quint64>(op.fileOffset);
+        sqe->buf_index = static_cast<quint16>(op.buffer);
+    } else {
+        // WRITEV 的 iovec 在完成前必须一直有效：每个请求用 opIovecs_ 中自己的那一项
+        iovec& iov = opIovecs_[static_cast<std::size_t>(index)];
+        iov.iov_base = buffers_[static_cast<std::size_t>(op.buffer)].data + op.offsetInBuffer;
+        iov.iov_len = static_cast<std::size_t>(op.length);
+        sqe->opcode = IORING_OP_WRITEV;
+        sqe->addr = reinterpret_cast<quint64>(&iov);
+        sqe->len = 1;
+        sqe->off = static_cast<quint64>(op.fileOffset);
+    }
+    sqArray_[slot] = slot;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+
+    int ret;
+    do {
+        ret = ioUringEnter(ringFd_, 1, 0, 0);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+        qWarning() << "IoUringSink: submit failed:" << std::strerror(errno);
+        return false;
+    }
+    ++inFlight_;
+    stats_.inFlightHighWater = std::max<quint64>(stats_.inFlightHighWater, static_cast<quint64>(inFlight_));
+    return true;
+}
+
+bool IoUringSink::submitWrite(int buffer, int offsetInBuffer, int length, qint64 fileOffset)
+{
+    const int index = allocOp();
+    if (index < 0)
+        return false;
+    Op& op = ops_[static_cast<std::size_t>(index)];
+    op = Op();
+    op.active = true;
+    op.buffer = buffer;
+    op.offsetInBuffer = offsetInBuffer;
+    op.length = length;
+    op.fileOffset = fileOffset;
+    ++buffers_[static_cast<std::size_t>(buffer)].pending;
+    ++stats_.writes;
+    return prepareAndSubmit(index);
+}
+
+bool IoUringSink::submitSync()
+{
+    const int index = allocOp();
+    if (index < 0)
+        return false;
+    Op& op = ops_[static_cast<std::size_t>(index)];
+    op = Op();
+    op.active = true;
+    op.isSync = true;
+    ++stats_.syncs;
+    return prepareAndSubmit(index);
+}
+
+void IoUringSink::reap()
+{
+    unsigned head = *cqHead_;
+    const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const io_uring_cqe& cqe = cqes_[head & cqMask_];
+        const int index = static_cast<int>(cqe.user_data);
+        const int res = cqe.res;
+        ++head;
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+
+        Op& op = ops_[static_cast<std::size_t>(index)];
+        --inFlight_;
+        if (res < 0) {
+            if (!failed_)
+                qWarning() << "IoUringSink:" << (op.isSync ? "fdatasync" : "write") << "failed:" << std::strerror(-res);
+            failed_ = true;
+        } else if (!op.isSync && res < op.length) {
+            // 短写：把剩下的部分重新提交（复用同一个请求项，缓冲的在途计数不变）
+            op.offsetInBuffer += res;
+            op.length -= res;
+            op.fileOffset += res;
+            if (prepareAndSubmit(index))
+                continue;
+            failed_ = true;
+        }
+
+        if (!op.isSync) {
+            Buffer& b = buffers_[static_cast<std::size_t>(op.buffer)];
+            --b.pending;
+            releaseIfIdle(op.buffer);
+        }
+        op.active = false;
+        freeOps_.push_back(index);
+    }
+}
+
+bool IoUringSink::waitForCompletion()
+{
+    if (inFlight_ == 0)
+        return false;
+    int ret;
+    do {
+        ret = ioUringEnter(ringFd_, 0, 1, IORING_ENTER_GETEVENTS);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0) {
+        qWarning() << "IoUringSink: wait failed:" << std::strerror(errno);
+        failed_ = true;
+        return false;
+    }
+    reap();
+    return true;
+}
+
+void IoUringSink::releaseIfIdle(int buffer)
+{
+    Buffer& b = buffers_[static_cast<std::size_t>(buffer)];
+    if (buffer != current_ && b.pending == 0) {
+        b.inUse = false;
+        b.fill = 0;
+    }
+}
+
+int IoUringSink::acquireBuffer()
+{
+    for (;;) {
+        for (std::size_t i = 0; i < buffers_.size(); ++i) {
+            if (!buffers_[i].inUse) {
+                buffers_[i].inUse = true;
+                buffers_[i].fill = 0;
+                return static_cast<int>(i);
+            }
+        }
+        // 所有缓冲都在途：磁盘跟不上，只能等一个请求完成
+        ++stats_.stalls;
+        if (!waitForCompletion())
+            return -1;
+    }
+}
+
+bool IoUringSink::write(const char* data, qint64 size)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ringFd_ < 0)
+        return false;
+    reap();
+    while (size > 0 && !failed_) {
+        if (current_ < 0 || buffers_[static_cast<std::size_t>(current_)].fill == bufferBytes_) {
+            const int previous = current_;
+            current_ = -1;
+            if (previous >= 0)
+                releaseIfIdle(previous);
+            current_ = acquireBuffer();
+            if (current_ < 0)
+                return false;
+        }
+        Buffer& b = buffers_[static_cast<std::size_t>(current_)];
+        const int n = static_cast<int>(std::min<qint64>(size, bufferBytes_ - b.fill));
+        std::memcpy(b.data + b.fill, data, static_cast<std::size_t>(n));
+        if (!submitWrite(current_, b.fill, n, offset_))
+            failed_ = true;
+        b.fill += n;
+        offset_ += n;
+        stats_.bytes += static_cast<quint64>(n);
+        data += n;
+        size -= n;
+    }
+    return !failed_;
+}
+
+bool IoUringSink::sync()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ringFd_ < 0)
+        return false;
+    reap();
+    if (!failed_ && !submitSync())
+        failed_ = true;
+    return !failed_;
+}
+
+void IoUringSink::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ringFd_ >= 0) {
+        while (inFlight_ > 0 && waitForCompletion()) {}
+    }
+    teardownRing();
+    for (Buffer& b : buffers_)
+        std::free(b.data);
+    buffers_.clear();
+    if (!file_.isOpen())
+        return;
+    file_.close();
+    qDebug().noquote() << QString("IoUringSink: %1 writes, %2 bytes, %3 syncs, %4 stalls, in-flight high-water %5, %6")
+                          .arg(stats_.writes).arg(stats_.bytes).arg(stats_.syncs).arg(stats_.stalls)
+                          .arg(stats_.inFlightHighWater)
+                          .arg(stats_.registeredBuffers ? "registered buffers" : "writev");
+}
+
+IoUringSink::Stats IoUringSink::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
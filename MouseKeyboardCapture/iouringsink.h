@@ -0,0 +1,118 @@
+#ifndef IOURINGSINK_H
+#define IOURINGSINK_H
+
+#include <QFile>
+#include <sys/uio.h>
+#include <mutex>
+#include <vector>
+#include "recordsink.h"
+
+/**
+ * @brief Linux io_uring 异步写入（record/writer = uring）
+ *
+ * 直接使用 io_uring 系统调用（不依赖 liburing）。write() 只把批次拷进缓冲池中当前缓冲的空闲部分，
+ * 提交一个按文件偏移写入的请求后立即返回，不等待磁盘；慢速磁盘（网络家目录、VDI）只会让在途的请求变多，
+ * 录制线程的读取循环不受影响。
+ *
+ * - 缓冲池：bufferCount 个 bufferBytes 大小的缓冲，启动时注册给内核（IORING_REGISTER_BUFFERS，用 WRITE_FIXED 写），
+ *   注册失败（如 RLIMIT_MEMLOCK 太小）时改用普通的 WRITEV。连续的小批次依次写进同一个缓冲，
+ *   缓冲写满且其中的请求全部完成后回到池中复用。所有缓冲都在途时 write() 才会等待（计入 Stats::stalls）。
+ * - sync()：提交一个带 IOSQE_IO_DRAIN 的 fdatasync，在之前的写入全部完成后执行，调用方不等待；
+ *   失败在之后的 write() / sync() 返回 false。close() 等待所有在途请求完成。
+ * - 请求可能乱序完成，崩溃时文件中间可能留下尚未写入的空洞；.mkj 读取时在空洞处停止。
+ *
+ * isAvailable() 探测内核是否支持（内核 5.1 以下、seccomp 禁用或 sysctl kernel.io_uring_disabled 时不可用），
+ * 不可用时 RecorderWorker 改用同步的 FileSink。
+ */
+class IoUringSink : public RecordSink
+{
+public:
+    struct Stats {
+        quint64 writes = 0;          // 提交的写请求
+        quint64 bytes = 0;
+        quint64 syncs = 0;
+        quint64 stalls = 0;          // 缓冲池耗尽、write() 等待完成的次数
+        quint64 inFlightHighWater = 0;
+        bool registeredBuffers = false;
+    };
+
+    static bool isAvailable();
+
+    explicit IoUringSink(const QString& path, int bufferCount = 16, int bufferBytes = 1024 * 1024);
+    ~IoUringSink() override;
+
+    bool open() override;
+    bool write(const char* data, qint64 size) override;
+    bool sync() override;
+    void close() override;
+    QString name() const override { return file_.fileName(); }
+
+    Stats stats() const;
+
+private:
+    struct Buffer {
+        char* data = nullptr;
+        int fill = 0;        // 已写入的字节数
+        int pending = 0;     // 在途的写请求数
+        bool inUse = false;  // 当前缓冲或尚有在途请求
+    };
+    // 一个在途请求；user_data 为它在 ops_ 中的下标
+    struct Op {
+        bool active = false;
+        bool isSync = false;
+        int buffer = -1;
+        int offsetInBuffer = 0;
+        int length = 0;
+        qint64 fileOffset = 0;
+    };
+
+    bool setupRing();
+    void teardownRing();
+    bool submitWrite(int buffer, int offsetInBuffer, int length, qint64 fileOffset);
+    bool submitSync();
+    bool prepareAndSubmit(int op);
+    int allocOp();
+    void reap();                       // 处理已完成的请求，不等待
+    bool waitForCompletion();          // 至少等到一个请求完成
+    int acquireBuffer();               // 取一个空闲缓冲，没有时等待
+    void releaseIfIdle(int buffer);
+
+private:
+    QFile file_;
+    int bufferCount_;
+    int bufferBytes_;
+    std::vector<Buffer> buffers_;
+    std::vector<struct iovec> iovecs_;
+    std::vector<Op> ops_;
+    std::vector<struct iovec> opIovecs_;   // 未注册缓冲时 WRITEV 用，与 ops_ 一一对应
+    std::vector<int> freeOps_;
+    int current_ = -1;         // 正在填充的缓冲
+    qint64 offset_ = 0;        // 下一次写入的文件偏移
+    int inFlight_ = 0;
+    bool failed_ = false;
+
+    // 环形队列（mmap 到内核的共享内存）
+    int ringFd_ = -1;
+    void* sqRing_ = nullptr;
+    std::size_t sqRingBytes_ = 0;
+    void* cqRing_ = nullptr;
+    std::size_t cqRingBytes_ = 0;
+    struct io_uring_sqe* sqes_ = nullptr;
+    std::size_t sqesBytes_ = 0;
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqEntries_ = 0;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    struct io_uring_cqe* cqes_ = nullptr;
+    unsigned cqEntries_ = 0;
+
+    // write() 在录制线程、sync() 可能在 JournalSink 的线程上，提交和收割都持有这个锁
+    mutable std::mutex mutex_;
+    Stats stats_;
+};
+
+#endif // IOURINGSINK_H
@@ -0,0 +1,123 @@
+#include "journal.h"
+#include "crc32c.h"
+#include <QFileInfo>
+#include <QStringList>
+#include <cstring>
+
+namespace Journal {
+
+static void putU32(char* p, quint32 v)
+{
+    for (int i = 0; i < 4; ++i)
+        p[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+static quint32 getU32(const char* p)
+{
+    quint32 v = 0;
+    for (int i = 0; i < 4; ++i)
+        v |= quint32(static_cast<quint8>(p[i])) << (8 * i);
+    return v;
+}
+
+bool parseConfig(const QString& spec, Config& config)
+{
+    const QStringList parts = spec.split(':');
+    const QString name = parts.value(0).trimmed().toLower();
+    if (name == "none" || name == "batch") {
+        config.fsync = name == "none" ? FsyncPolicy::None : FsyncPolicy::EveryBatch;
+        return parts.size() == 1;
+    }
+    if (name != "interval" || parts.size() > 2)
+        return false;
+    config.fsync = FsyncPolicy::Interval;
+    if (parts.size() == 2) {
+        bool ok = false;
+        const int ms = parts.at(1).toInt(&ok);
+        if (!ok || ms <= 0)
+            return false;
+        config.intervalMs = ms;
+    }
+    return true;
+}
+
+bool isJournalPath(const QString& path)
+{
+    return QFileInfo(path).suffix().compare("mkj", Qt::CaseInsensitive) == 0;
+}
+
+bool hasMagic(const QByteArray& data)
+{
+    return data.size() >= 4 && std::memcmp(data.constData(), kMagic, 4) == 0;
+}
+
+QByteArray fileHeader()
+{
+    char header[kFileHeaderBytes] = {};
+    std::memcpy(header, kMagic, 4);
+    header[4] = static_cast<char>(kVersion);
+    return QByteArray(header, kFileHeaderBytes);
+}
+
+void writeFrameHeader(char* header, quint32 sequence, const char* payload, quint32 size)
+{
+    putU32(header + 4, sequence);
+    putU32(header + 8, size);
+    quint32 crc = Crc32c::value(header + 4, 8);
+    crc = Crc32c::extend(crc, payload, size);
+    putU32(header, crc);
+}
+
+bool recover(const QByteArray& file, QByteArray& out, RecoverInfo* info, QString* error)
+{
+    RecoverInfo result;
+    if (!hasMagic(file) || file.size() < kFileHeaderBytes) {
+        if (error) *error = "not a .mkj record file";
+        return false;
+    }
+    if (static_cast<quint8>(file.at(4)) != kVersion) {
+        if (error) *error = QString("unsupported .mkj version %1").arg(static_cast<quint8>(file.at(4)));
+        return false;
+    }
+
+    out.resize(0);
+    out.reserve(file.size());
+    const char* base = file.constData();
+    qint64 pos = kFileHeaderBytes;
+    quint32 expected = 1;
+    while (pos < file.size()) {
+        if (file.size() - pos < kFrameHeaderBytes) {
+            result.stopReason = "truncated frame header";
+            break;
+        }
+        const char* h = base + pos;
+        const quint32 sequence = getU32(h + 4);
+        const quint32 size = getU32(h + 8);
+        if (size > static_cast<quint64>(file.size() - pos - kFrameHeaderBytes)) {
+            result.stopReason = "truncated frame";
+            break;
+        }
+        // 序号检查放在 CRC 之后：CRC 不符时序号本身也不可信
+        quint32 crc = Crc32c::value(h + 4, 8);
+        crc = Crc32c::extend(crc, h + kFrameHeaderBytes, size);
+        if (crc != getU32(h)) {
+            result.stopReason = QString("checksum mismatch in frame %1").arg(expected);
+            break;
+        }
+        if (sequence != expected) {
+            result.stopReason = QString("sequence gap: expected %1, found %2").arg(expected).arg(sequence);
+            break;
+        }
+        out.append(h + kFrameHeaderBytes, static_cast<int>(size));
+        pos += kFrameHeaderBytes + size;
+        ++expected;
+        ++result.frames;
+    }
+    result.goodBytes = pos;
+    result.discardedBytes = file.size() - pos;
+    if (info)
+        *info = result;
+    return true;
+}
+
+} // namespace Journal
@@ -0,0 +1,59 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * @brief 防崩溃的追加式日志容器（.mkj）
+ *
+ * 内容是 .mkr 字节流，RecorderWorker 每写出一个批次就追加一帧：
+ *
+ *   文件头  4 字节魔数 "MKRJ" | 1 字节版本号 | 3 字节保留
+ *   帧      u32 CRC32C | u32 序号 | u32 长度 | 数据
+ *
+ * 整数均为小端。CRC32C 覆盖序号、长度和数据；序号从 1 开始逐帧加一。
+ * 文件在任何时刻被截断（崩溃、断电、直接关掉控制台窗口）都能读出：
+ * 打开时从头校验，遇到第一个 CRC 不符、序号不连续或不完整的帧就停下，之前的帧全部可用。
+ * 写到哪一步才算落盘由 fsync 策略决定（见 JournalSink）。
+ */
+namespace Journal {
+
+constexpr char kMagic[4] = { 'M', 'K', 'R', 'J' };
+constexpr quint8 kVersion = 1;
+constexpr int kFileHeaderBytes = 8;
+constexpr int kFrameHeaderBytes = 12;
+
+enum class FsyncPolicy {
+    None,         // 只交给操作系统，断电可能丢失最近几秒
+    Interval,     // 后台线程每 intervalMs 刷一次（默认）
+    EveryBatch    // 每个批次写完立即刷，最安全也最慢
+};
+
+struct Config {
+    FsyncPolicy fsync = FsyncPolicy::Interval;
+    int intervalMs = 1000;
+};
+
+struct RecoverInfo {
+    quint64 frames = 0;
+    qint64 goodBytes = 0;        // 文件中可用部分的长度（含文件头）
+    qint64 discardedBytes = 0;   // 最后一个完好的帧之后被丢弃的字节
+    QString stopReason;          // 为空表示文件完整
+};
+
+// 解析 "none" / "batch" / "interval" / "interval:<ms>"
+bool parseConfig(const QString& spec, Config& config);
+bool isJournalPath(const QString& path);   // .mkj
+bool hasMagic(const QByteArray& data);
+
+QByteArray fileHeader();
+// 填写一帧的帧头（kFrameHeaderBytes 字节），数据紧跟在帧头之后
+void writeFrameHeader(char* header, quint32 sequence, const char* payload, quint32 size);
+
+// 校验并拼接全部完好的帧；文件头本身无效时返回 false
+bool recover(const QByteArray& file, QByteArray& out, RecoverInfo* info = nullptr, QString* error = nullptr);
+
+} // namespace Journal
+
+#endif // JOURNAL_H
@@ -0,0 +1,131 @@
+#include "journalsink.h"
+#include "crc32c.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+
+JournalSink::JournalSink(std::unique_ptr<RecordSink> next, const Journal::Config& config)
+    : next_(std::move(next)), config_(config)
+{
+    config_.intervalMs = std::max(config_.intervalMs, 1);
+}
+
+JournalSink::~JournalSink()
+{
+    stopSyncThread();
+}
+
+bool JournalSink::open()
+{
+    if (!next_->open())
+        return false;
+    const QByteArray header = Journal::fileHeader();
+    if (!next_->write(header.constData(), header.size()))
+        return false;
+    sequence_ = 0;
+    stopping_ = false;
+    if (config_.fsync == Journal::FsyncPolicy::Interval)
+        syncThread_ = std::thread(&JournalSink::syncLoop, this);
+    return true;
+}
+
+bool JournalSink::write(const char* data, qint64 size)
+{
+    if (size <= 0)
+        return true;
+    if (size > 0x7FFFFFFF - Journal::kFrameHeaderBytes)
+        return false;
+
+    // 帧头和数据一次写出，中途崩溃时留下的半帧在打开时被 CRC 或长度检查丢弃
+    const int frameBytes = Journal::kFrameHeaderBytes + static_cast<int>(size);
+    if (frame_.capacity() < frameBytes)
+        frame_.reserve(frameBytes);
+    frame_.resize(frameBytes);
+    char* p = frame_.data();
+    std::memcpy(p + Journal::kFrameHeaderBytes, data, static_cast<std::size_t>(size));
+    Journal::writeFrameHeader(p, ++sequence_, p + Journal::kFrameHeaderBytes, static_cast<quint32>(size));
+    if (!next_->write(p, frameBytes))
+        return false;
+
+    bool wakeSyncThread = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.frames;
+        wakeSyncThread = !dirty_;
+        dirty_ = true;
+    }
+    // 只在“无待刷 → 有待刷”时叫醒后台线程，之后的批次由它等满间隔后一并刷出
+    if (wakeSyncThread && config_.fsync == Journal::FsyncPolicy::Interval)
+        cv_.notify_one();
+    if (config_.fsync == Journal::FsyncPolicy::EveryBatch)
+        return sync();
+    return true;
+}
+
+bool JournalSink::sync()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dirty_ = false;
+    }
+    const bool ok = next_->sync();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.syncs;
+    if (!ok)
+        ++stats_.failedSyncs;
+    return ok;
+}
+
+void JournalSink::syncLoop()
+{
+    const std::chrono::milliseconds interval(config_.intervalMs);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        // 没有待刷数据时不设超时，空闲录制中这个线程不会醒来
+        cv_.wait(lock, [this] { return stopping_ || dirty_; });
+        if (stopping_)
+            break;
+        ++stats_.syncThreadWakeups;
+        // 有新写入后再等一个间隔，把这段时间内的批次合并成一次 sync
+        if (cv_.wait_for(lock, interval, [this] { return stopping_; }))
+            break;
+        ++stats_.syncThreadWakeups;
+        if (!dirty_)
+            continue;
+        lock.unlock();
+        // 与写入线程上的 write() 并发：fsync / FlushFileBuffers 对同一个文件句柄可以并发调用
+        sync();
+        lock.lock();
+    }
+}
+
+void JournalSink::stopSyncThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        cv_.notify_all();
+    }
+    if (syncThread_.joinable())
+        syncThread_.join();
+}
+
+void JournalSink::close()
+{
+    stopSyncThread();
+    if (config_.fsync != Journal::FsyncPolicy::None)
+        sync();
+    next_->close();
+
+    const Stats s = stats();
+    qDebug().noquote() << QString("JournalSink: %1 frames, %2 syncs (%3 failed), CRC32C %4")
+                          .arg(s.frames).arg(s.syncs).arg(s.failedSyncs)
+                          .arg(Crc32c::isHardwareAccelerated() ? "hardware" : "software");
+}
+
+JournalSink::Stats JournalSink::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
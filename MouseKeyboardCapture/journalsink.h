@@ -0,0 +1,60 @@
+#ifndef JOURNALSINK_H
+#define JOURNALSINK_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "journal.h"
+#include "recordsink.h"
+
+/**
+ * @brief 把每个批次包成一帧（CRC32C + 序号）写入下一级 sink（.mkj，格式见 Journal）
+ *
+ * 每次 write() 正好追加一帧，帧头和数据拼在一块缓冲里一次写出。何时调用下一级的 sync()
+ * 由 Journal::FsyncPolicy 决定：
+ *   None        从不主动刷，只在 close() 时交给操作系统
+ *   Interval    后台线程在有新写入后再等 intervalMs 刷一次（期间的批次合并成一次 sync），
+ *               没有待刷数据时不定时醒来；写入线程不等待磁盘
+ *   EveryBatch  每帧写完在写入线程上立即刷，批次越小代价越高（配合 record/maxLatencyMs 调整）
+ */
+class JournalSink : public RecordSink
+{
+public:
+    struct Stats {
+        quint64 frames = 0;
+        quint64 syncs = 0;
+        quint64 failedSyncs = 0;
+        quint64 syncThreadWakeups = 0;   // Interval 后台线程醒来的次数，空闲时应保持不变
+    };
+
+    JournalSink(std::unique_ptr<RecordSink> next, const Journal::Config& config);
+    ~JournalSink() override;
+
+    bool open() override;
+    bool write(const char* data, qint64 size) override;
+    bool sync() override;
+    void close() override;
+    QString name() const override { return next_->name(); }
+
+    Stats stats() const;
+
+private:
+    void syncLoop();
+    void stopSyncThread();
+
+private:
+    std::unique_ptr<RecordSink> next_;
+    Journal::Config config_;
+    QByteArray frame_;        // 帧头 + 数据，容量复用
+    quint32 sequence_ = 0;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    bool dirty_ = false;      // 上次 sync 之后是否有新写入
+    std::thread syncThread_;
+    Stats stats_;
+};
+
+#endif // JOURNALSINK_H
@@ -0,0 +1,45 @@
+#include "latencyhistogram.h"
+
+quint64 LatencyHistogram::Snapshot::percentile(double p) const
+{
+    if (total == 0) return 0;
+    const quint64 target = static_cast<quint64>(p * static_cast<double>(total - 1)) + 1;
+    quint64 seen = 0;
+    for (int b = 0; b < kBuckets; ++b) {
+        seen += counts[b];
+        if (seen >= target) {
+            const quint64 upper = b == 0 ? 0 : ((quint64(1) << b) - 1);
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    Snapshot s;
+    for (int b = 0; b < kBuckets; ++b) {
+        s.counts[b] = counts_[b].load(std::memory_order_relaxed);
+        s.total += s.counts[b];
+    }
+    s.max = max_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<quint64>& c : counts_)
+        c.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+QString LatencyHistogram::format(const Snapshot& s, const char* unit)
+{
+    return QString("n=%1 p50<=%2%6 p99<=%3%6 p99.9<=%4%6 max=%5%6")
+            .arg(s.total)
+            .arg(s.percentile(0.50))
+            .arg(s.percentile(0.99))
+            .arg(s.percentile(0.999))
+            .arg(s.max)
+            .arg(QString::fromLatin1(unit));
+}
@@ -0,0 +1,80 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QString>
+#include <atomic>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief 对数分桶直方图（常开的低开销统计）
+ *
+ * 第 b 个桶统计 [2^(b-1), 2^b) 范围内的数值（第 0 个桶只统计 0），64 个桶覆盖全部 64 位数值。
+ * record() 只做一次最高位查找和一次计数累加，不加锁、不分配内存。
+ *
+ * 约定每个直方图只有「一个」线程写入（钩子线程或工作线程），所以累加用 relaxed 的 load + store，
+ * 避免带 lock 前缀的原子加法；读取端（任意线程）拿到的是近似快照，对统计来说足够。
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int kBuckets = 64;
+
+    struct Snapshot {
+        quint64 counts[kBuckets];
+        quint64 total = 0;
+        quint64 max = 0;
+
+        // 返回 p（0~1）分位所在桶的上界，近似值（误差在 2 倍以内）
+        quint64 percentile(double p) const;
+    };
+
+    void record(quint64 value)
+    {
+        std::atomic<quint64>& bucket = counts_[bucketOf(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed))
+            max_.store(value, std::memory_order_relaxed);
+    }
+
+    Snapshot snapshot() const;
+    void reset();
+
+    // 单行摘要，例如 "n=1200 p50<=512 p99<=4096 p99.9<=8192 max=6100"
+    static QString format(const Snapshot& s, const char* unit);
+
+    static int bucketOf(quint64 value)
+    {
+        if (value == 0) return 0;
+        const int bit = highestBit(value) + 1;
+        return bit < kBuckets ? bit : kBuckets - 1;
+    }
+
+private:
+    static int highestBit(quint64 v)
+    {
+#if defined(_MSC_VER)
+        unsigned long idx = 0;
+#  if defined(_M_X64) || defined(_M_ARM64)
+        _BitScanReverse64(&idx, v);
+        return static_cast<int>(idx);
+#  else
+        // 32 位 MSVC 没有 _BitScanReverse64，分高低两半查找
+        if (_BitScanReverse(&idx, static_cast<unsigned long>(v >> 32)))
+            return static_cast<int>(idx) + 32;
+        _BitScanReverse(&idx, static_cast<unsigned long>(v));
+        return static_cast<int>(idx);
+#  endif
+#else
+        return 63 - __builtin_clzll(v);
+#endif
+    }
+
+private:
+    std::atomic<quint64> counts_[kBuckets] = {};
+    std::atomic<quint64> max_{0};
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,291 @@
+#include "livestreamsink.h"
+#include <QDir>
+#include <QFile>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <sddl.h>
+#include <string>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#if !defined(Q_OS_WIN) && !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+
+#ifdef Q_OS_WIN
+static constexpr DWORD kPipeBufferBytes = 64 * 1024;
+
+// 只允许当前用户访问的安全描述符，用完由调用方 LocalFree
+static void* currentUserOnlyDescriptor()
+{
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token))
+        return nullptr;
+    DWORD length = 0;
+    GetTokenInformation(token, TokenUser, nullptr, 0, &length);
+    std::vector<char> buffer(length);
+    LPWSTR sid = nullptr;
+    const bool ok = length > 0
+        && GetTokenInformation(token, TokenUser, buffer.data(), length, &length)
+        && ConvertSidToStringSidW(reinterpret_cast<TOKEN_USER*>(buffer.data())->User.Sid, &sid);
+    CloseHandle(token);
+    if (!ok)
+        return nullptr;
+    const std::wstring sddl = std::wstring(L"D:P(A;;GA;;;") + sid + L")";
+    LocalFree(sid);
+    PSECURITY_DESCRIPTOR descriptor = nullptr;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(sddl.c_str(), SDDL_REVISION_1, &descriptor, nullptr))
+        return nullptr;
+    return descriptor;
+}
+
+// 非阻塞（PIPE_NOWAIT）的管道实例：ConnectNamedPipe 和 WriteFile 都立即返回。
+// first 为 true 时同名管道已存在则失败，用来发现另一个正在发布的实例
+static qintptr createPipeInstance(const QString& name, void* security, bool first)
+{
+    SECURITY_ATTRIBUTES attributes{};
+    attributes.nLength = sizeof(attributes);
+    attributes.lpSecurityDescriptor = security;
+    const HANDLE pipe = CreateNamedPipeW(reinterpret_cast<const wchar_t*>(name.utf16()),
+                                         PIPE_ACCESS_DUPLEX | (first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+                                         PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_NOWAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                         PIPE_UNLIMITED_INSTANCES, kPipeBufferBytes, kPipeBufferBytes, 0, &attributes);
+    return reinterpret_cast<qintptr>(pipe);
+}
+#endif
+
+static void closeHandle(qintptr handle)
+{
+#ifdef Q_OS_WIN
+    CloseHandle(reinterpret_cast<HANDLE>(handle));
+#else
+    ::close(static_cast<int>(handle));
+#endif
+}
+
+// 尽量写出，返回实际写出的字节数（对方缓冲满时可能为 0），-1 表示对方已断开或出错
+static qint64 sendSome(qintptr handle, const char* data, qint64 size)
+{
+#ifdef Q_OS_WIN
+    DWORD written = 0;
+    if (!WriteFile(reinterpret_cast<HANDLE>(handle), data, static_cast<DWORD>(size), &written, nullptr))
+        return -1;
+    return written;
+#else
+    const ssize_t n = ::send(static_cast<int>(handle), data, static_cast<std::size_t>(size), MSG_NOSIGNAL);
+    if (n >= 0)
+        return n;
+    return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+#endif
+}
+
+LiveStreamSink::LiveStreamSink(const QString& serverName, qint64 maxClientBacklog)
+    : serverName_(serverName), maxClientBacklog_(maxClientBacklog)
+{
+#ifdef Q_OS_WIN
+    fullServerName_ = QString("\\\\.\\pipe\\") + serverName_;
+#else
+    fullServerName_ = serverName_.startsWith('/') ? serverName_ : QDir::tempPath() + '/' + serverName_;
+#endif
+}
+
+LiveStreamSink::~LiveStreamSink()
+{
+    close();
+}
+
+bool LiveStreamSink::open()
+{
+    if (!listen())
+        return false;
+    haveHeader_ = false;
+    qDebug() << "LiveStreamSink: listening on" << fullServerName_;
+    return true;
+}
+
+#ifdef Q_OS_WIN
+bool LiveStreamSink::listen()
+{
+    security_ = currentUserOnlyDescriptor();
+    if (!security_) {
+        qWarning() << "LiveStreamSink: 无法创建访问控制" << GetLastError();
+        return false;
+    }
+    listener_ = createPipeInstance(fullServerName_, security_, true);
+    if (listener_ == -1) {
+        const DWORD error = GetLastError();
+        if (error == ERROR_ACCESS_DENIED)
+            qWarning() << "LiveStreamSink:" << serverName_ << "已被其他进程占用";
+        else
+            qWarning() << "LiveStreamSink: 无法创建管道" << fullServerName_ << error;
+        LocalFree(security_);
+        security_ = nullptr;
+        return false;
+    }
+    return true;
+}
+#else
+bool LiveStreamSink::listen()
+{
+    const QByteArray path = QFile::encodeName(fullServerName_);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (static_cast<std::size_t>(path.size()) >= sizeof(address.sun_path)) {
+        qWarning() << "LiveStreamSink: 套接字路径过长" << fullServerName_;
+        return false;
+    }
+    std::memcpy(address.sun_path, path.constData(), static_cast<std::size_t>(path.size()));
+
+    // 上次异常退出留下的套接字文件会让 bind() 失败；先确认没有进程在这个名字上应答，
+    // 否则删掉的是另一个正在发布的实例的套接字
+    const int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0) {
+        const bool answered = ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        const int error = errno;
+        ::close(probe);
+        if (answered) {
+            qWarning() << "LiveStreamSink:" << serverName_ << "已被其他进程占用";
+            return false;
+        }
+        if (error == ECONNREFUSED)
+            ::unlink(path.constData());
+    }
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        qWarning() << "LiveStreamSink: socket failed:" << strerror(errno);
+        return false;
+    }
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    // 录制内容包含键盘输入，只允许当前用户连接；在 listen() 之前收紧权限，之前没有人能连上
+    if (::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0
+        || ::chmod(path.constData(), S_IRUSR | S_IWUSR) < 0
+        || ::listen(fd, SOMAXCONN) < 0) {
+        qWarning() << "LiveStreamSink: 无法监听" << fullServerName_ << strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    listener_ = fd;
+    return true;
+}
+#endif
+
+// 只由 write() 调用：空闲时没有批次，挂起的连接等到下一个批次再接受（见类说明）
+void LiveStreamSink::acceptClients()
+{
+    while (listener_ != -1) {
+        Client client;
+#ifdef Q_OS_WIN
+        // 非阻塞模式下 ConnectNamedPipe 立即返回：已有客户端连上时把这个实例交给它，再开一个新实例等下一个
+        const HANDLE pipe = reinterpret_cast<HANDLE>(listener_);
+        if (!ConnectNamedPipe(pipe, nullptr)) {
+            const DWORD error = GetLastError();
+            if (error == ERROR_NO_DATA) {   // 客户端连上后又断开了，实例复位后继续等待
+                DisconnectNamedPipe(pipe);
+                continue;
+            }
+            if (error != ERROR_PIPE_CONNECTED)
+                return;                     // ERROR_PIPE_LISTENING：没有等待中的连接
+        }
+        client.handle = listener_;
+        listener_ = createPipeInstance(fullServerName_, security_, false);
+        if (listener_ == -1)
+            qWarning() << "LiveStreamSink: 无法创建新的管道实例，不再接受连接" << GetLastError();
+#else
+        const int fd = ::accept(static_cast<int>(listener_), nullptr, nullptr);
+        if (fd < 0)
+            return;                         // EAGAIN：没有等待中的连接
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        client.handle = fd;
+#endif
+        if (haveHeader_ && !sendToClient(client, header_.constData(), header_.size())) {
+            closeHandle(client.handle);
+            continue;
+        }
+        clients_.push_back(std::move(client));
+    }
+}
+
+bool LiveStreamSink::sendToClient(Client& client, const char* data, qint64 size)
+{
+    // 先发上次剩下的积压，积压没发完时新数据直接接在后面，保证顺序
+    if (!client.backlog.isEmpty()) {
+        const qint64 sent = sendSome(client.handle, client.backlog.constData(), client.backlog.size());
+        if (sent < 0)
+            return false;
+        client.backlog.remove(0, static_cast<int>(sent));
+    }
+    qint64 sent = 0;
+    if (client.backlog.isEmpty()) {
+        sent = sendSome(client.handle, data, size);
+        if (sent < 0)
+            return false;
+    }
+    if (sent < size)
+        client.backlog.append(data + sent, static_cast<int>(size - sent));
+    if (client.backlog.size() > maxClientBacklog_) {
+        qWarning() << "LiveStreamSink: 客户端读取跟不上，断开连接";
+        return false;
+    }
+    return true;
+}
+
+void LiveStreamSink::removeClient(std::size_t index)
+{
+    closeHandle(clients_[index].handle);
+    clients_.erase(clients_.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+bool LiveStreamSink::write(const char* data, qint64 size)
+{
+    if (listener_ == -1 && clients_.empty())
+        return false;
+    if (!haveHeader_) {
+        header_ = QByteArray(data, static_cast<int>(size));
+        haveHeader_ = true;
+        acceptClients();   // 客户端在接入时收到文件头
+        return true;
+    }
+
+    acceptClients();
+    for (std::size_t i = clients_.size(); i-- > 0;) {
+        if (!sendToClient(clients_[i], data, size))
+            removeClient(i);
+    }
+    return true;
+}
+
+void LiveStreamSink::close()
+{
+    // 最后再尝试发一次积压，不等待对方读取
+    for (Client& client : clients_) {
+        if (!client.backlog.isEmpty())
+            sendSome(client.handle, client.backlog.constData(), client.backlog.size());
+        closeHandle(client.handle);
+    }
+    clients_.clear();
+    if (listener_ != -1) {
+        closeHandle(listener_);
+        listener_ = -1;
+#ifndef Q_OS_WIN
+        ::unlink(QFile::encodeName(fullServerName_).constData());
+#endif
+    }
+#ifdef Q_OS_WIN
+    if (security_) {
+        LocalFree(security_);
+        security_ = nullptr;
+    }
+#endif
+}
@@ -0,0 +1,60 @@
+#ifndef LIVESTREAMSINK_H
+#define LIVESTREAMSINK_H
+
+#include <QByteArray>
+#include <vector>
+#include "recordsink.h"
+
+/**
+ * @brief 通过本地套接字实时发布录制（Linux 上为 Unix 域套接字，Windows 上为命名管道）
+ *
+ * 作为 SinkFanout 的旁路 sink 使用，open / write / close 都在 SinkFanout 的 std::thread 上调用。
+ * 这个线程没有 Qt 事件循环，所以不用 QLocalServer / QLocalSocket，直接使用系统接口：
+ * 监听套接字和每个客户端都是非阻塞的（Windows 上为 PIPE_NOWAIT 的管道实例），
+ * 每个批次先接受新的连接，再把批次写给所有客户端，写不出去的部分留在该客户端的积压里，下一个批次先发积压。
+ * 服务名与 QLocalServer 相同：Linux 上不含 '/' 时位于 QDir::tempPath() 下，Windows 上为 \\.\pipe\<名称>，
+ * 客户端可以直接用 QLocalSocket 连接。只有当前用户可以连接（录制内容包含键盘输入）。
+ *
+ * 订阅方读到的是一条 .mkr 字节流：连接后先收到文件头，之后从下一个批次（以 Sync 记录开头）起依次收到，
+ * 可以直接交给 RecordFormat::decode。
+ *
+ * 新连接只在写批次时接受：没有输入时录制不产生批次，这期间连上的客户端要等到下一个批次
+ * 才和它一起收到文件头（在此之前连接停留在系统的监听队列里）。这里有意不设定时轮询，
+ * 空闲录制时旁路线程与捕获、写入线程一样不会醒来。
+ *
+ * 读取跟不上的客户端（积压超过 maxClientBacklog）会被断开，不影响其它客户端和录制。
+ */
+class LiveStreamSink : public RecordSink
+{
+public:
+    explicit LiveStreamSink(const QString& serverName, qint64 maxClientBacklog = 4 * 1024 * 1024);
+    ~LiveStreamSink() override;
+
+    bool open() override;
+    bool write(const char* data, qint64 size) override;
+    void close() override;
+    QString name() const override { return QString("live stream %1").arg(serverName_); }
+
+private:
+    struct Client {
+        qintptr handle = -1;
+        QByteArray backlog;   // 对方暂时读不动、还没发出去的数据
+    };
+
+    bool listen();
+    void acceptClients();
+    bool sendToClient(Client& client, const char* data, qint64 size);   // 返回 false 表示应断开
+    void removeClient(std::size_t index);
+
+private:
+    QString serverName_;
+    QString fullServerName_;
+    qint64 maxClientBacklog_;
+    qintptr listener_ = -1;        // Linux 上为监听套接字，Windows 上为正在等待连接的管道实例
+    void* security_ = nullptr;     // Windows：只允许当前用户访问的安全描述符（LocalAlloc 分配）
+    std::vector<Client> clients_;
+    QByteArray header_;
+    bool haveHeader_ = false;
+};
+
+#endif // LIVESTREAMSINK_H
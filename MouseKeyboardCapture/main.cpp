@@ -1,8 +1,703 @@
 #include "mainwindow.h"
+#include "alloccounter.h"
+#include "eventserializer.h"
+#include "inputcodes.h"
+#include "journalsink.h"
+#include "mmapsink.h"
+#include "recordingstats.h"
+#include "spscring.h"
+#ifdef Q_OS_LINUX
+#include "evdevbackend.h"
+#include "iouringsink.h"
+#endif
+#include "syntheticbackend.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+// 无界面压力测试：合成事件 → CaptureEngine → EventBus → RecorderWorker → 文件，结束后打印统计
+// saturateGui 为 true 时让 GUI 线程一直忙（每轮空转 50 ms），用来观察捕获线程的回调延迟是否受界面拖累
+static int runLoadTest(QApplication& app, SyntheticBackend* backend, const QString& outputPath, bool saturateGui)
+{
+    // Recorder 的写入线程直接订阅引擎的总线，GUI 线程被占满也不影响录制
+    CaptureEngine& engine = CaptureEngine::instance();
+
+    Recorder::instance().startRecording(outputPath);
+    if (!engine.start()) {
+        Recorder::instance().stopRecording();
+        return 1;
+    }
+
+    QTimer busy;
+    if (saturateGui) {
+        QObject::connect(&busy, &QTimer::timeout, &app, []() {
+            QElapsedTimer spin;
+            spin.start();
+            while (spin.elapsed() < 50) {}
+        });
+        busy.start(0);
+    }
+
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &app, [&]() {
+        if (!backend->isFinished()) return;
+        poll.stop();
+        busy.stop();
+
+        const SyntheticBackend::Report r = backend->report();
+        engine.stop();
+
+        QElapsedTimer drain;
+        drain.start();
+        Recorder::instance().stopRecording();
+
+        const CaptureEngine::Stats s = engine.stats();
+        qInfo().noquote() << QString("load test: generated %1 events in %2 s (%3 events/s)")
+                             .arg(r.generated).arg(r.elapsedSec, 0, 'f', 3).arg(r.generatedPerSec, 0, 'f', 0);
+        qInfo().noquote() << QString("  delivered %1, dropped mouse %2 key %3, queue high-water mouse %4 key %5")
+                             .arg(s.delivered).arg(s.droppedMouse).arg(s.droppedKey)
+                             .arg(s.mouseHighWater).arg(s.keyHighWater);
+        qInfo().noquote() << QString("  overload: held high-water %1, coalesced moves %2, dropped old moves %3, "
+                                     "block waits %4, block timeouts %5")
+                             .arg(s.heldHighWater).arg(s.coalescedMoves).arg(s.droppedOldMoves)
+                             .arg(s.blockWaits).arg(s.blockTimeouts);
+        if (s.filtered)
+            qInfo().noquote() << QString("  filtered %1").arg(s.filtered);
+        if (s.injectedMouse || s.injectedKey)
+            qInfo().noquote() << QString("  injected mouse %1 key %2, dropped %3")
+                                 .arg(s.injectedMouse).arg(s.injectedKey).arg(s.injectedDropped);
+        qInfo().noquote() << QString("  recorder drain after stop: %1 ms").arg(drain.elapsed());
+        const RecorderWorker::Stats w = Recorder::instance().lastStats();
+        qInfo().noquote() << QString("  recorder: %1 events, %2 writes (%3 events/s, %4 writes/s), largest batch %5")
+                             .arg(w.events).arg(w.writes).arg(w.eventsPerSec, 0, 'f', 0)
+                             .arg(w.writesPerSec, 0, 'f', 1).arg(w.largestBatch);
+        const qint64 fileBytes = QFileInfo(outputPath).size();
+        qInfo().noquote() << QString("  recorded %1 bytes (%2 bytes/event)")
+                             .arg(fileBytes).arg(s.delivered ? double(fileBytes) / s.delivered : 0.0, 0, 'f', 1);
+        qInfo().noquote() << engine.metricsReport();
+        app.quit();
+    });
+    poll.start(100);
+    return app.exec();
+}
+
+// 空闲唤醒检查：不产生输入（真实设备时不要触碰鼠标键盘，或配合 --synthetic idle），
+// 统计引擎工作线程、一个总线订阅者和一个打开着的 .mkj（默认 Interval 刷盘）后台线程在这段时间内醒来的次数，理想值为 0
+static int runIdleCheck(int seconds)
+{
+    CaptureEngine& engine = CaptureEngine::instance();
+    const QString journalPath = QDir::temp().filePath("mkc-idle-check.mkj");
+    JournalSink journal(std::unique_ptr<RecordSink>(new FileSink(journalPath)), Journal::Config());
+    if (!journal.open()) {
+        qWarning() << "idle check: cannot open" << journalPath;
+        return 1;
+    }
+    std::shared_ptr<EventSubscription> sub = engine.bus().subscribe("idle check", EventBus::Delivery::Lossless);
+    std::atomic<quint64> subscriberWakeups{0};
+    std::thread reader([&]() {
+        std::vector<EventBatch> batches;
+        while (sub->wait(batches)) {
+            subscriberWakeups.fetch_add(1);
+            batches.clear();
+        }
+    });
+
+    if (!engine.start()) {
+        sub->close();
+        reader.join();
+        journal.close();
+        QFile::remove(journalPath);
+        return 1;
+    }
+    // 启动阶段（后端打开设备、线程设置优先级）可能有几次唤醒，稳定后再开始计数
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    const quint64 workerBefore = engine.stats().workerWakeups;
+    const quint64 subscriberBefore = subscriberWakeups.load();
+    const quint64 journalBefore = journal.stats().syncThreadWakeups;
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    const quint64 worker = engine.stats().workerWakeups - workerBefore;
+    const quint64 subscriber = subscriberWakeups.load() - subscriberBefore;
+    const quint64 journalWakeups = journal.stats().syncThreadWakeups - journalBefore;
+    const quint64 delivered = engine.stats().delivered;
+    engine.stop();
+    sub->close();
+    reader.join();
+    journal.close();
+    QFile::remove(journalPath);
+
+    qInfo().noquote() << QString("idle check (%1, %2 s): capture worker wakeups %3, subscriber wakeups %4, "
+                                 "journal sync wakeups %5, events %6")
+                         .arg(engine.backendName()).arg(seconds).arg(worker).arg(subscriber)
+                         .arg(journalWakeups).arg(delivered);
+    return (worker == 0 && subscriber == 0 && journalWakeups == 0) ? 0 : 1;
+}
+
+// 入队延迟对比：按 1k、10k、100k 事件/秒各运行 seconds 秒，生产者线程按节拍逐个入队，统计每次入队的耗时并打印分位数
+// （包含两次取时钟的开销，两条路径相同）。两边都照各自实际的引擎实现建模：
+//   spsc ring    CaptureEngine 现在的做法：tryPush 后按 wakeWorker 的协议只在消费者睡着时加锁 notify；
+//                消费者按 waitForWork 的协议在条件变量上等待，醒来后无锁取空队列
+//   mutex+queue  改动前的 enqueueMouseEvent / workerLoop：加锁 push 后每次 notify_one；
+//                消费者 wait_for(5 ms)，每个事件在锁内 front/pop，解锁交付（原来的 emit）后再加锁
+// 交付只是追加到预留好的数组，两边相同
+static int runEnqueueBench(int seconds)
+{
+    static constexpr std::size_t kCapacity = 8192;
+    using Ring = SpscRing<MouseEventData, kCapacity>;
+
+    for (int rate : { 1000, 10000, 100000 }) {
+        const int events = rate * seconds;
+        const qint64 intervalNs = 1000000000LL / rate;
+        for (bool lockFree : { true, false }) {
+            std::unique_ptr<Ring> ring(new Ring);   // 存储区在对象内部，放在堆上避免占满栈
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::queue<MouseEventData> queue;
+            std::atomic<bool> sleeping{false};
+            std::atomic<bool> done{false};
+            std::vector<MouseEventData> delivered;
+            delivered.reserve(static_cast<std::size_t>(events));
+
+            std::thread consumer([&]() {
+                MouseEventData e;
+                if (lockFree) {
+                    for (;;) {
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            sleeping.store(true, std::memory_order_relaxed);
+                            std::atomic_thread_fence(std::memory_order_seq_cst);
+                            cv.wait(lock, [&] { return !ring->empty() || done.load(); });
+                            sleeping.store(false, std::memory_order_relaxed);
+                        }
+                        while (ring->tryPop(e))
+                            delivered.push_back(e);
+                        if (done.load() && ring->empty())
+                            return;
+                    }
+                } else {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    for (;;) {
+                        cv.wait_for(lock, std::chrono::milliseconds(5), [&] { return !queue.empty() || done.load(); });
+                        while (!queue.empty()) {
+                            e = queue.front();
+                            queue.pop();
+                            lock.unlock();
+                            delivered.push_back(e);
+                            lock.lock();
+                        }
+                        if (done.load())
+                            return;
+                    }
+                }
+            });
+
+            std::vector<qint64> samples;
+            samples.reserve(static_cast<std::size_t>(events));
+            quint64 full = 0;
+            qint64 next = captureTimestampNs();
+            for (int i = 0; i < events; ++i) {
+                next += intervalNs;
+                while (captureTimestampNs() < next) {}
+                const MouseEventData e{ i % 1920, i % 1080, InputCode::MouseMove, 0, 0, next };
+                const qint64 t0 = captureTimestampNs();
+                if (lockFree) {
+                    if (!ring->tryPush(e))
+                        ++full;
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (sleeping.load(std::memory_order_relaxed)) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        cv.notify_one();
+                    }
+                } else {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        queue.push(e);
+                    }
+                    cv.notify_one();
+                }
+                samples.push_back(captureTimestampNs() - t0);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.store(true);
+                cv.notify_one();
+            }
+            consumer.join();
+
+            std::sort(samples.begin(), samples.end());
+            auto pct = [&samples](double p) {
+                return samples[std::min(samples.size() - 1, static_cast<std::size_t>(p * samples.size()))];
+            };
+            qInfo().noquote() << QString("enqueue bench (%1, %2 events/s): %3 events, p50 %4 ns, p99 %5 ns, "
+                                         "p99.9 %6 ns, max %7 ns%8")
+                                 .arg(lockFree ? "spsc ring" : "mutex+queue").arg(rate).arg(delivered.size())
+                                 .arg(pct(0.50)).arg(pct(0.99)).arg(pct(0.999)).arg(samples.back())
+                                 .arg(full ? QString(", %1 dropped (ring full)").arg(full) : QString());
+        }
+    }
+    return 0;
+}
+
+// 一段混合事件（移动、点击、相对运动、滚轮、按键，带设备编号和注入标志），事件间隔 intervalNs
+static std::vector<CapturedEvent> mixedEventStream(int events, qint64 startNs, qint64 intervalNs)
+{
+    std::vector<CapturedEvent> stream;
+    stream.reserve(static_cast<std::size_t>(events));
+    for (int i = 0; i < events; ++i) {
+        const qint64 ts = startNs + qint64(i) * intervalNs;
+        const DeviceId device = static_cast<DeviceId>(i % 3);
+        const EventFlags flags = (i % 97 == 0) ? EventFlag::Injected : 0;
+        switch (i % 8) {
+        case 0:
+            stream.push_back(CapturedEvent::fromKey(KeyEventData{ quint32('A' + i % 26), (i / 8) % 2 == 0, flags, device, ts }));
+            break;
+        case 1:
+            stream.push_back(CapturedEvent::fromMouse(MouseEventData{ 3 - i % 7, i % 5 - 2, InputCode::RawMotion, flags, device, ts }));
+            break;
+        case 2:
+            stream.push_back(CapturedEvent::fromMouse(MouseEventData{ -InputCode::WheelDelta, 0, InputCode::RawWheel, flags, device, ts }));
+            break;
+        case 3:
+            stream.push_back(CapturedEvent::fromMouse(MouseEventData{ i % 1920, i % 1080,
+                (i / 8) % 2 ? InputCode::LeftUp : InputCode::LeftDown, flags, device, ts }));
+            break;
+        default:
+            stream.push_back(CapturedEvent::fromMouse(MouseEventData{ i % 1920, i % 1080, InputCode::MouseMove, flags, device, ts }));
+            break;
+        }
+    }
+    return stream;
+}
+
+// 序列化分配检查：对一段混合事件分别用 JSON 和 .mkr 格式序列化到预留好的缓冲，
+// 预热后统计本线程的堆分配次数，理想值为 0
+static int runAllocCheck(int events)
+{
+    if (!AllocCounter::available()) {
+        qWarning() << "--alloc-check is unavailable: rebuild with DEFINES += MKC_ALLOC_COUNTER";
+        return 1;
+    }
+
+    const qint64 startNs = captureTimestampNs();
+    const std::vector<CapturedEvent> stream = mixedEventStream(events, startNs, 250000);
+
+    static constexpr int kFlushBytes = 64 * 1024;
+    bool clean = true;
+    for (EventSerializer::Format format : { EventSerializer::Format::Json, EventSerializer::Format::Binary }) {
+        EventSerializer serializer(format, startNs);
+        QByteArray buffer;
+        buffer.reserve(kFlushBytes + EventSerializer::kMaxEventBytes);
+        serializer.appendHeader(buffer);
+
+        // 预热：第一个事件之前的一次性分配（文件头等）不计入
+        qint64 bytes = 0;
+        const std::size_t warmup = std::min<std::size_t>(stream.size(), 1000);
+        std::size_t i = 0;
+        for (; i < warmup; ++i)
+            serializer.appendEvent(buffer, stream[i]);
+
+        const quint64 before = AllocCounter::threadAllocations();
+        for (; i < stream.size(); ++i) {
+            serializer.appendEvent(buffer, stream[i]);
+            if (buffer.size() >= kFlushBytes) {
+                bytes += buffer.size();
+                buffer.resize(0);
+            }
+        }
+        const quint64 allocations = AllocCounter::threadAllocations() - before;
+        bytes += buffer.size();
+
+        const std::size_t measured = stream.size() - warmup;
+        qInfo().noquote() << QString("alloc check (%1): %2 events, %3 heap allocations, %4 bytes/event")
+                             .arg(format == EventSerializer::Format::Json ? "json" : "mkr")
+                             .arg(measured).arg(allocations)
+                             .arg(double(bytes) / stream.size(), 0, 'f', 1);
+        clean = clean && allocations == 0;
+    }
+    return clean ? 0 : 1;
+}
+
+// 写入方式对比：按 10k、100k 事件/秒各生成 10 秒的混合事件，按默认组提交参数（每 50 ms 一批）序列化成 .mkr 批次，
+// 再分别通过 FileSink、MmapSink 和（Linux 上内核支持时）IoUringSink 写到 path，只计 open / write / close 的耗时（序列化不计入），
+// 换算成每录制 1 秒占用写入线程的时间。结束后删除文件
+static int runSinkBench(const QString& path)
+{
+    static constexpr int kSeconds = 10;
+    static constexpr int kBatchMs = 50;
+    bool ok = true;
+    for (int rate : { 10000, 100000 }) {
+        const int events = rate * kSeconds;
+        const qint64 startNs = captureTimestampNs();
+        const std::vector<CapturedEvent> stream = mixedEventStream(events, startNs, 1000000000LL / rate);
+
+        std::vector<QByteArray> batches;
+        EventSerializer serializer(EventSerializer::Format::Binary, startNs);
+        QByteArray buffer;
+        serializer.appendHeader(buffer);
+        const int perBatch = rate * kBatchMs / 1000;
+        for (int i = 0; i < events; ++i) {
+            serializer.appendEvent(buffer, stream[static_cast<std::size_t>(i)]);
+            if ((i + 1) % perBatch == 0) {
+                batches.push_back(buffer);
+                buffer.resize(0);
+            }
+        }
+        serializer.appendFooter(buffer, {});
+        batches.push_back(buffer);
+
+        std::vector<RecorderWorker::Writer> writers = { RecorderWorker::Writer::File, RecorderWorker::Writer::Mmap };
+#ifdef Q_OS_LINUX
+        if (IoUringSink::isAvailable())
+            writers.push_back(RecorderWorker::Writer::IoUring);
+#endif
+        for (RecorderWorker::Writer writer : writers) {
+            std::unique_ptr<RecordSink> sink;
+            const char* writerName = "file";
+            if (writer == RecorderWorker::Writer::Mmap) {
+                sink.reset(new MmapSink(path));
+                writerName = "mmap";
+            }
+#ifdef Q_OS_LINUX
+            else if (writer == RecorderWorker::Writer::IoUring) {
+                sink.reset(new IoUringSink(path));
+                writerName = "uring";
+            }
+#endif
+            else {
+                sink.reset(new FileSink(path));
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            bool written = sink->open();
+            qint64 bytes = 0;
+            for (const QByteArray& batch : batches) {
+                written = written && sink->write(batch.constData(), batch.size());
+                bytes += batch.size();
+            }
+            sink->close();
+            const qint64 ns = timer.nsecsElapsed();
+            ok = ok && written && QFileInfo(path).size() == bytes;
+
+            qInfo().noquote() << QString("sink bench (%1, %2 events/s): %3 events, %4 writes, %5 MB, "
+                                         "%6 ms total, %7 us/write, %8 ms per recorded second%9")
+                                 .arg(writerName).arg(rate)
+                                 .arg(events).arg(batches.size()).arg(bytes / 1e6, 0, 'f', 1)
+                                 .arg(ns / 1e6, 0, 'f', 1).arg(ns / 1e3 / batches.size(), 0, 'f', 1)
+                                 .arg(ns / 1e6 / kSeconds, 0, 'f', 2)
+                                 .arg(written ? "" : " (write failed)");
+        }
+    }
+    QFile::remove(path);
+    return ok ? 0 : 1;
+}
+
+// 读录制的统计旁路文件并打印概要，不解析事件本身
+static int printRecordingStats(const QString& path)
+{
+    const QString sidecar = path.endsWith(".stats.json") ? path : RecordingStats::sidecarPath(path);
+    RecordingStats::Stats stats;
+    QString error;
+    if (!RecordingStats::load(sidecar, stats, &error)) {
+        qWarning().noquote() << QString("cannot read %1: %2").arg(sidecar, error);
+        return 1;
+    }
+    qInfo().noquote() << QString("%1 (started %2)").arg(stats.recordFile, stats.recordStartTime);
+    qInfo().noquote() << stats.summary();
+
+    QStringList mouse;
+    for (int i = 0; i < RecordingStats::kMouseTypes; ++i) {
+        if (stats.mouseTypes[static_cast<std::size_t>(i)])
+            mouse << QString("%1 %2").arg(RecordingStats::mouseTypeName(i)).arg(stats.mouseTypes[static_cast<std::size_t>(i)]);
+    }
+    if (!mouse.isEmpty())
+        qInfo().noquote() << "mouse:" << mouse.join(", ");
+
+    // 按下次数最多的 10 个键
+    std::vector<int> keys;
+    for (int vk = 0; vk < RecordingStats::kKeyCodes; ++vk) {
+        if (stats.keyDown[static_cast<std::size_t>(vk)])
+            keys.push_back(vk);
+    }
+    std::sort(keys.begin(), keys.end(), [&stats](int a, int b) {
+        return stats.keyDown[static_cast<std::size_t>(a)] > stats.keyDown[static_cast<std::size_t>(b)];
+    });
+    QStringList top;
+    for (std::size_t i = 0; i < keys.size() && i < 10; ++i)
+        top << QString("0x%1 %2").arg(keys[i], 2, 16, QChar('0')).arg(stats.keyDown[static_cast<std::size_t>(keys[i])]);
+    if (!top.isEmpty())
+        qInfo().noquote() << "top keys:" << top.join(", ");
+    return 0;
+}
 
 int main(int argc, char *argv[]) {
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption syntheticOption("synthetic",
+        "Use generated input instead of the real devices: <move|typing|click|mixed|idle>[:rateHz[:seconds]]",
+        "spec");
+    QCommandLineOption loadTestOption("load-test",
+        "Run the synthetic input headless, record it to <file> (.json, .mkr, .mkrz or .mkj) and print throughput statistics",
+        "file");
+    QCommandLineOption overloadOption("overload",
+        "What to do when the UI or recorder falls behind: coalesce (default), drop-oldest or block",
+        "policy");
+    QCommandLineOption filterOption("filter",
+        "Load capture filter rules from <file>, one rule per line (e.g. \"drop move in 0,1040,1920,40\")",
+        "file");
+    QCommandLineOption injectedOption("injected",
+        "Events injected by software (including our own replay): drop (default) or tag (default with --evdev-devices)",
+        "policy");
+    QCommandLineOption evdevDevicesOption("evdev-devices",
+        "Linux: read only these evdev nodes (comma separated, e.g. a uinput test device) instead of scanning /dev/input",
+        "paths");
+    QCommandLineOption relativeOption("relative",
+        "Record raw relative mouse motion and wheel deltas instead of absolute cursor positions");
+    QCommandLineOption recordBatchOption("record-batch",
+        "Write at most <n> events per recorder write (default 8192)", "n");
+    QCommandLineOption recordLatencyOption("record-latency",
+        "Write recorded events at most <ms> after capture (default 50)", "ms");
+    QCommandLineOption compressOption("compress",
+        "Codec for .mkrz recordings: none, zlib or zlib:<1-9> (default zlib:6)", "codec");
+    QCommandLineOption fsyncOption("fsync",
+        "Flush policy for .mkj recordings: none, batch, interval or interval:<ms> (default interval:1000)", "policy");
+    QCommandLineOption segmentSizeOption("segment-size",
+        "Roll recordings over to a new numbered segment every <MB> megabytes and write a .mkrm manifest", "MB");
+    QCommandLineOption segmentDurationOption("segment-duration",
+        "Roll recordings over to a new numbered segment every <seconds> of events", "seconds");
+    QCommandLineOption writerOption("writer",
+        "How recordings are written: file (one write call per batch, default), mmap (preallocated, memory-mapped) "
+        "or uring (asynchronous io_uring writes, Linux only; falls back to file)", "writer");
+    QCommandLineOption liveStreamOption("live-stream",
+        "While recording a binary format, also publish the .mkr stream on local socket <name>", "name");
+    QCommandLineOption recentMinutesOption("recent-minutes",
+        "While recording a binary format, keep the last <n> minutes in memory for Record > Save recent", "n");
+    QCommandLineOption sinkBenchOption("sink-bench",
+        "Write 10 s of generated events at 10k and 100k events/s to <file> with each writer and print the write cost", "file");
+    QCommandLineOption statsOption("stats",
+        "Print the statistics recorded next to <file> (<file>.stats.json, or the sidecar itself) and exit", "file");
+    QCommandLineOption captureCpuOption("capture-cpu",
+        "Pin the capture thread to CPU <n>", "n");
+    QCommandLineOption idleCheckOption("idle-check",
+        "Capture with no input for <seconds> and fail if any engine thread, a bus subscriber or an open journal's sync thread woke up", "seconds");
+    QCommandLineOption enqueueBenchOption("enqueue-bench",
+        "Time each enqueue through the lock-free ring and through a mutex + queue at 1k, 10k and 100k events/s "
+        "for <seconds> each and print percentiles", "seconds");
+    QCommandLineOption allocCheckOption("alloc-check",
+        "Serialize <n> generated events as JSON and .mkr and fail if steady-state serialization allocated "
+        "(needs a build with DEFINES += MKC_ALLOC_COUNTER)", "n");
+    QCommandLineOption saturateGuiOption("saturate-gui",
+        "With --load-test: keep the GUI thread busy to measure capture latency under a stalled UI");
+    parser.addOption(syntheticOption);
+    parser.addOption(loadTestOption);
+    parser.addOption(idleCheckOption);
+    parser.addOption(allocCheckOption);
+    parser.addOption(enqueueBenchOption);
+    parser.addOption(sinkBenchOption);
+    parser.addOption(statsOption);
+    parser.addOption(overloadOption);
+    parser.addOption(filterOption);
+    parser.addOption(injectedOption);
+    parser.addOption(evdevDevicesOption);
+    parser.addOption(relativeOption);
+    parser.addOption(captureCpuOption);
+    parser.addOption(recordBatchOption);
+    parser.addOption(recordLatencyOption);
+    parser.addOption(compressOption);
+    parser.addOption(fsyncOption);
+    parser.addOption(segmentSizeOption);
+    parser.addOption(segmentDurationOption);
+    parser.addOption(writerOption);
+    parser.addOption(liveStreamOption);
+    parser.addOption(recentMinutesOption);
+    parser.addOption(saturateGuiOption);
+    parser.process(a);
+
+    if (parser.isSet(allocCheckOption)) {
+        const int events = parser.value(allocCheckOption).toInt();
+        if (events <= 0) {
+            qWarning() << "invalid --alloc-check event count:" << parser.value(allocCheckOption);
+            return 1;
+        }
+        return runAllocCheck(events);
+    }
+
+    if (parser.isSet(enqueueBenchOption)) {
+        const int seconds = parser.value(enqueueBenchOption).toInt();
+        if (seconds <= 0) {
+            qWarning() << "invalid --enqueue-bench duration:" << parser.value(enqueueBenchOption);
+            return 1;
+        }
+        return runEnqueueBench(seconds);
+    }
+
+    if (parser.isSet(sinkBenchOption))
+        return runSinkBench(parser.value(sinkBenchOption));
+
+    if (parser.isSet(statsOption))
+        return printRecordingStats(parser.value(statsOption));
+
+    if (parser.isSet(filterOption)) {
+        QFile file(parser.value(filterOption));
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            qWarning() << "cannot open filter file:" << file.fileName();
+            return 1;
+        }
+        QStringList rules;
+        QTextStream in(&file);
+        while (!in.atEnd())
+            rules << in.readLine();
+        QString error;
+        if (!CaptureEngine::instance().setCaptureFilter(rules, &error)) {
+            qWarning().noquote() << error;
+            return 1;
+        }
+    }
+
+    if (parser.isSet(injectedOption)) {
+        CaptureEngine::InjectedPolicy injected;
+        if (!CaptureEngine::parseInjectedPolicy(parser.value(injectedOption), injected)) {
+            qWarning() << "invalid --injected policy:" << parser.value(injectedOption);
+            return 1;
+        }
+        CaptureEngine::instance().setInjectedPolicy(injected);
+    }
+
+    if (parser.isSet(relativeOption))
+        CaptureEngine::instance().setRelativeMotion(true);
+
+    if (parser.isSet(captureCpuOption)) {
+        CaptureBackend::ThreadConfig thread;
+        thread.cpu = parser.value(captureCpuOption).toInt();
+        CaptureEngine::instance().setCaptureThreadConfig(thread);
+    }
+
+    if (parser.isSet(recordBatchOption) || parser.isSet(recordLatencyOption)) {
+        RecorderWorker::BatchConfig batch;
+        if (parser.isSet(recordBatchOption))
+            batch.maxBatchEvents = parser.value(recordBatchOption).toInt();
+        if (parser.isSet(recordLatencyOption))
+            batch.maxLatencyMs = parser.value(recordLatencyOption).toInt();
+        Recorder::instance().setBatchConfig(batch);
+    }
+
+    if (parser.isSet(compressOption)) {
+        BlockCodec::Config compression;
+        if (!BlockCodec::parseConfig(parser.value(compressOption), compression)) {
+            qWarning() << "invalid --compress codec:" << parser.value(compressOption);
+            return 1;
+        }
+        Recorder::instance().setCompression(compression);
+    }
+
+    if (parser.isSet(fsyncOption)) {
+        Journal::Config journal;
+        if (!Journal::parseConfig(parser.value(fsyncOption), journal)) {
+            qWarning() << "invalid --fsync policy:" << parser.value(fsyncOption);
+            return 1;
+        }
+        Recorder::instance().setJournalConfig(journal);
+    }
+
+    if (parser.isSet(segmentSizeOption) || parser.isSet(segmentDurationOption)) {
+        SegmentManifest::Config segments;
+        segments.maxBytes = parser.value(segmentSizeOption).toLongLong() * 1024 * 1024;
+        segments.maxSeconds = parser.value(segmentDurationOption).toInt();
+        Recorder::instance().setSegmentConfig(segments);
+    }
+
+    if (parser.isSet(writerOption)) {
+        RecorderWorker::Writer writer;
+        if (!RecorderWorker::parseWriter(parser.value(writerOption), writer)) {
+            qWarning() << "invalid --writer:" << parser.value(writerOption);
+            return 1;
+        }
+        Recorder::instance().setWriter(writer);
+    }
+
+    if (parser.isSet(liveStreamOption))
+        Recorder::instance().setLiveStream(parser.value(liveStreamOption));
+
+    if (parser.isSet(recentMinutesOption)) {
+        const int minutes = parser.value(recentMinutesOption).toInt();
+        if (minutes <= 0) {
+            qWarning() << "invalid --recent-minutes:" << parser.value(recentMinutesOption);
+            return 1;
+        }
+        Recorder::instance().setRecentMinutes(minutes);
+    }
+
+    if (parser.isSet(overloadOption)) {
+        CaptureEngine::OverloadConfig overload;
+        if (!CaptureEngine::parsePolicy(parser.value(overloadOption), overload.policy)) {
+            qWarning() << "invalid --overload policy:" << parser.value(overloadOption);
+            return 1;
+        }
+        CaptureEngine::instance().setOverloadConfig(overload);
+    }
+
+    SyntheticBackend* synthetic = nullptr;
+    SyntheticBackend::Config config;
+    if (parser.isSet(syntheticOption)) {
+        if (!SyntheticBackend::parseSpec(parser.value(syntheticOption), config)) {
+            qWarning() << "invalid --synthetic spec:" << parser.value(syntheticOption);
+            return 1;
+        }
+        synthetic = new SyntheticBackend(config);
+        CaptureEngine::instance().setBackend(std::unique_ptr<CaptureBackend>(synthetic));
+    }
+
+    if (parser.isSet(evdevDevicesOption)) {
+#ifdef Q_OS_LINUX
+        const QStringList paths = parser.value(evdevDevicesOption).split(',', QString::SkipEmptyParts);
+        if (synthetic || paths.isEmpty()) {
+            qWarning() << "--evdev-devices needs at least one path and cannot be combined with --synthetic";
+            return 1;
+        }
+        EvdevBackend* evdev = new EvdevBackend();
+        evdev->setDevicePaths(paths);
+        CaptureEngine::instance().setBackend(std::unique_ptr<CaptureBackend>(evdev));
+        // 指定设备多半是 uinput 测试设备，它们的事件被标记为注入；未显式指定 --injected 时保留下来
+        if (!parser.isSet(injectedOption))
+            CaptureEngine::instance().setInjectedPolicy(CaptureEngine::InjectedPolicy::Tag);
+#else
+        qWarning() << "--evdev-devices is only available on Linux";
+        return 1;
+#endif
+    }
+
+    if (parser.isSet(loadTestOption)) {
+        if (!synthetic || config.durationMs <= 0) {
+            qWarning() << "--load-test requires --synthetic with a duration";
+            return 1;
+        }
+        return runLoadTest(a, synthetic, parser.value(loadTestOption), parser.isSet(saturateGuiOption));
+    }
+
+    if (parser.isSet(idleCheckOption)) {
+        const int seconds = parser.value(idleCheckOption).toInt();
+        if (seconds <= 0) {
+            qWarning() << "invalid --idle-check duration:" << parser.value(idleCheckOption);
+            return 1;
+        }
+        return runIdleCheck(seconds);
+    }
+
     MainWindow w;
     w.show();
     return a.exec();
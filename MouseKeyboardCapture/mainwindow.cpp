@@ -1,13 +1,36 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "inputcodes.h"
+#include "recordingstats.h"
+#ifdef Q_OS_LINUX
+#include "evdevbackend.h"
+#endif
 
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QLineEdit>
 #include <QMessageBox>
 #include <QVBoxLayout>
 #include <QMenuBar>
 #include <QDebug>
 #include <QDateTime>
 
+// 捕获时间戳是单调时钟，只能换算成相对时间；用当前墙上时间减去事件已经过去的时长来显示
+static QString formatCaptureTime(qint64 timestampNs)
+{
+    const qint64 ageMs = (captureTimestampNs() - timestampNs) / 1000000;
+    return QDateTime::currentDateTime().addMSecs(-ageMs).toString("hh:mm:ss.zzz");
+}
+
+// 能区分设备时在日志里注明设备编号
+static QString formatSource(DeviceId id, EventFlags flags)
+{
+    QString text = id ? QString(" Dev=%1").arg(id) : QString();
+    if (flags & EventFlag::Injected)
+        text += " [注入]";
+    return text;
+}
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       ui(new Ui::MainWindow),
@@ -17,6 +40,8 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
     ui->statusLabel->setText("status: off");
+    // 窗口创建前只有命令行会设置后端；之后 start() 留下的默认后端不算
+    commandLineBackend_ = CaptureEngine::instance().hasBackend();
     // 初始化全局热键管理器
     hotkeyManager_ = &GlobalHotkeyManager::instance();
 
@@ -34,22 +59,12 @@ MainWindow::MainWindow(QWidget *parent)
     setupMenus();
     setupConnections();
 
-    // 注册信号槽中使用的自定义类型
-    qRegisterMetaType<MouseEventData>("MouseEventData");
-    qRegisterMetaType<KeyEventData>("KeyEventData");
-
-    // 捕获引擎信号连接
-    CaptureEngine &engine = CaptureEngine::instance();
-    connect(&engine, &CaptureEngine::mouseEventCaptured,
-            this, &MainWindow::handleMouseEvent, Qt::QueuedConnection);
-    connect(&engine, &CaptureEngine::keyEventCaptured,
-            this, &MainWindow::handleKeyEvent, Qt::QueuedConnection);
-
-    // 捕获数据传给录制模块
-    connect(&engine, &CaptureEngine::mouseEventCaptured,
-            &Recorder::instance(), &Recorder::onMouseEventCaptured, Qt::QueuedConnection);
-    connect(&engine, &CaptureEngine::keyEventCaptured,
-            &Recorder::instance(), &Recorder::onKeyEventCaptured, Qt::QueuedConnection);
+    // 订阅捕获总线：发布线程只在「已读完 → 有新批次」时投递一次 drainEvents，
+    // GUI 线程一次读走期间积压的所有批次；录制模块有自己的订阅和线程，不经过这里
+    logEvents_ = CaptureEngine::instance().bus().subscribe("log view", EventBus::Delivery::Lossy, kLogMaxLagEvents);
+    logEvents_->setNotify([this]() {
+        QMetaObject::invokeMethod(this, "drainEvents", Qt::QueuedConnection);
+    });
 
     // 默认注册热键（可被 HotkeyConfigDialog 覆盖）
     hotkeyManager_->registerHotkey(GlobalHotkeyManager::StopReplay,   QKeySequence("Ctrl+Alt+S"));
@@ -65,6 +80,8 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // 先注销订阅，close() 返回后发布线程不会再通知这个窗口
+    logEvents_->close();
     delete ui;
     CaptureEngine::instance().stop();
 }
@@ -74,6 +91,10 @@ void MainWindow::setupMenus()
     QMenu *menu = menuBar()->addMenu(tr("设置"));
     QAction *hotkeyAction = menu->addAction(tr("热键配置..."));
     connect(hotkeyAction, &QAction::triggered, this, &MainWindow::onOpenHotkeyConfig);
+
+    QMenu *recordMenu = menuBar()->addMenu(tr("录制"));
+    QAction *saveRecentAction = recordMenu->addAction(tr("保存最近录制..."));
+    connect(saveRecentAction, &QAction::triggered, this, &MainWindow::onSaveRecent);
 }
 
 void MainWindow::setupConnections()
@@ -86,11 +107,108 @@ void MainWindow::setupConnections()
 void MainWindow::on_startButton_clicked()
 {
     if (!capturing_) {
-        QString filePath = QFileDialog::getSaveFileName(this, "选择录制文件", "", "JSON Files (*.json)");
+        // 按扩展名选择录制格式：.mkr 为紧凑的二进制格式，.mkrz 再分块压缩，.mkj 在崩溃或直接关闭窗口后仍可读出，
+        // .json 便于直接查看
+        QString filePath = QFileDialog::getSaveFileName(this, "选择录制文件", "",
+                                                        "JSON Files (*.json);;Binary Record (*.mkr);;Compressed Record (*.mkrz);;"
+                                                        "Journaled Record (*.mkj)");
         if (filePath.isEmpty()) return;
 
+        // 录制写入的组提交参数：每批最多事件数、事件从捕获到写出的最长延迟（毫秒）
+        QSettings settings;
+        RecorderWorker::BatchConfig batch;
+        batch.maxBatchEvents = settings.value("record/maxBatchEvents", batch.maxBatchEvents).toInt();
+        batch.maxLatencyMs = settings.value("record/maxLatencyMs", batch.maxLatencyMs).toInt();
+        Recorder::instance().setBatchConfig(batch);
+        // .mkrz 的压缩方式：none / zlib / zlib:<1-9>
+        BlockCodec::Config compression;
+        if (BlockCodec::parseConfig(settings.value("record/compression", "zlib").toString(), compression))
+            Recorder::instance().setCompression(compression);
+        // .mkj 的落盘策略：none / batch / interval / interval:<ms>
+        Journal::Config journal;
+        if (Journal::parseConfig(settings.value("record/fsync", "interval").toString(), journal))
+            Recorder::instance().setJournalConfig(journal);
+        // 全天录制按大小（MB）或时长（分钟）自动分段，并写出清单 .mkrm；都为 0 时不分段
+        SegmentManifest::Config segments;
+        segments.maxBytes = settings.value("record/segmentMB", 0).toLongLong() * 1024 * 1024;
+        segments.maxSeconds = settings.value("record/segmentMinutes", 0).toInt() * 60;
+        Recorder::instance().setSegmentConfig(segments);
+        // 底层写入方式：file（默认）/ mmap / uring（Linux）
+        RecorderWorker::Writer writer;
+        if (RecorderWorker::parseWriter(settings.value("record/writer", "file").toString(), writer))
+            Recorder::instance().setWriter(writer);
+        // 旁路输出（仅二进制格式）：本地套接字实时发布、内存中保留最近若干分钟供“保存最近录制”；
+        // 未配置时保持命令行指定的值
+        if (settings.contains("record/liveStream"))
+            Recorder::instance().setLiveStream(settings.value("record/liveStream").toString());
+        if (settings.contains("record/recentMinutes"))
+            Recorder::instance().setRecentMinutes(settings.value("record/recentMinutes").toInt());
         Recorder::instance().startRecording(filePath);
 
+        // 鼠标轨迹简化的误差范围（像素 / 毫秒），可在配置中调整，像素设为 0 即关闭简化
+        MousePathSimplifier::Config simplify;
+        simplify.epsilonPx = settings.value("capture/simplifyPx", simplify.epsilonPx).toDouble();
+        simplify.epsilonMs = settings.value("capture/simplifyMs", simplify.epsilonMs).toDouble();
+        CaptureEngine::instance().setMouseSimplification(simplify);
+
+        // 捕获线程优先级与 CPU 绑定（capture/cpu 为 -1 时不绑定），未配置时保持默认（或命令行指定的值）
+        if (settings.contains("capture/highPriority") || settings.contains("capture/cpu")) {
+            CaptureBackend::ThreadConfig thread;
+            thread.highPriority = settings.value("capture/highPriority", thread.highPriority).toBool();
+            thread.cpu = settings.value("capture/cpu", thread.cpu).toInt();
+            CaptureEngine::instance().setCaptureThreadConfig(thread);
+        }
+
+        // 捕获过滤规则，每条一行，例如 "drop move in 0,1040,1920,40"（语法见 CaptureFilter）
+        if (settings.contains("capture/filterRules")) {
+            QString error;
+            if (!CaptureEngine::instance().setCaptureFilter(settings.value("capture/filterRules").toStringList(), &error))
+                QMessageBox::warning(this, "捕获过滤规则", error);
+        }
+
+        // 相对运动模式：记录原始位移和滚轮量（游戏、CAD 等需要精确回放的场景）
+        if (settings.contains("capture/relativeMotion"))
+            CaptureEngine::instance().setRelativeMotion(settings.value("capture/relativeMotion").toBool());
+
+        // 注入事件（包括本程序回放发出的）：drop / tag，未配置时丢弃，录制与回放同时进行时不会把回放结果再录进去
+        if (settings.contains("capture/injected")) {
+            CaptureEngine::InjectedPolicy injected;
+            if (CaptureEngine::parseInjectedPolicy(settings.value("capture/injected").toString(), injected))
+                CaptureEngine::instance().setInjectedPolicy(injected);
+        }
+
+        // 界面或录制跟不上时的过载策略：coalesce / drop-oldest / block，未配置时保持默认（或命令行指定的值）
+        if (settings.contains("capture/overloadPolicy")) {
+            CaptureEngine::OverloadConfig overload;
+            if (CaptureEngine::parsePolicy(settings.value("capture/overloadPolicy").toString(), overload.policy))
+                CaptureEngine::instance().setOverloadConfig(overload);
+        }
+
+#ifdef Q_OS_LINUX
+        // 只读取指定的 evdev 设备节点（例如测试用的 uinput 设备）；每次开始都按当前配置重建后端，
+        // 配置删除后恢复扫描全部设备。命令行已选定后端时不覆盖
+        if (!commandLineBackend_) {
+            const QStringList paths = settings.value("capture/evdevDevices").toStringList();
+            if (!paths.isEmpty()) {
+                EvdevBackend* evdev = new EvdevBackend();
+                evdev->setDevicePaths(paths);
+                CaptureEngine::instance().setBackend(std::unique_ptr<CaptureBackend>(evdev));
+            } else {
+                CaptureEngine::instance().setBackend(nullptr);   // start() 使用默认后端
+            }
+            // 指定的设备多半是 uinput 测试设备，未配置 capture/injected 时保留它们的（注入）事件
+            if (!settings.contains("capture/injected")) {
+                if (!paths.isEmpty()) {
+                    CaptureEngine::instance().setInjectedPolicy(CaptureEngine::InjectedPolicy::Tag);
+                    injectedTagForDevices_ = true;
+                } else if (injectedTagForDevices_) {
+                    CaptureEngine::instance().setInjectedPolicy(CaptureEngine::InjectedPolicy::Drop);
+                    injectedTagForDevices_ = false;
+                }
+            }
+        }
+#endif
+
         if (CaptureEngine::instance().start()) {
             capturing_ = true;
             ui->statusLabel->setText("status: capture...");
@@ -104,7 +222,11 @@ void MainWindow::on_stopButton_clicked()
         CaptureEngine::instance().stop();
         Recorder::instance().stopRecording();
         capturing_ = false;
-        ui->statusLabel->setText("status: off");
+
+        const CaptureEngine::Stats stats = CaptureEngine::instance().stats();
+        ui->statusLabel->setText(QString("status: off (mouse moves %1 -> %2, saved %3, filtered %4)")
+                                 .arg(stats.movesCaptured).arg(stats.movesDelivered).arg(stats.movesSaved())
+                                 .arg(stats.filtered));
     }
 }
 
@@ -113,7 +235,7 @@ void MainWindow::on_replayButton_clicked()
     QString path = QFileDialog::getOpenFileName(
         this, tr("选择操作记录文件"),
         lastReplayPath_.isEmpty() ? QDir::currentPath() : lastReplayPath_,
-        tr("Operation Record (*.json);;All files (*.*)")
+        tr("Operation Record (*.json *.mkr *.mkrz *.mkj);;Segmented Record (*.mkrm);;All files (*.*)")
     );
     if (path.isEmpty()) {
         QMessageBox::information(this, tr("提示"), tr("未选择文件"));
@@ -121,8 +243,28 @@ void MainWindow::on_replayButton_clicked()
     }
     lastReplayPath_ = QFileInfo(path).absolutePath();
 
+    // 有统计旁路文件时先显示录制概要，不必等事件加载完
+    RecordingStats::Stats summary;
+    if (RecordingStats::load(RecordingStats::sidecarPath(path), summary))
+        ui->statusLabel->setText(QString("record: %1").arg(summary.summary()));
+
     auto &replay = ReplayManager::instance();
     if (replay.loadReplayFile(path)) {
+        // 分段录制可以只回放其中一段时间，只会读取与之重叠的段
+        if (replay.isSegmented()) {
+            bool ok = false;
+            const QString spec = QInputDialog::getText(this, tr("回放时间窗口"),
+                                                       tr("起止时间（秒，如 3600-5400，留空回放全部）"),
+                                                       QLineEdit::Normal, QString(), &ok);
+            if (!ok)
+                return;
+            qint64 fromUs = 0, toUs = -1;
+            if (!ReplayManager::parseWindow(spec, fromUs, toUs)) {
+                QMessageBox::warning(this, tr("error"), tr("Invalid time window"));
+                return;
+            }
+            replay.setReplayWindow(fromUs, toUs);
+        }
         connect(&replay, &ReplayManager::replayProgress, this,
                 [](int cur, int total) { qDebug() << "replay progress:" << cur << "/" << total; });
         connect(&replay, &ReplayManager::replayFinished, this,
@@ -135,23 +277,55 @@ void MainWindow::on_replayButton_clicked()
     }
 }
 
-void MainWindow::handleMouseEvent(const MouseEventData &e)
+void MainWindow::drainEvents()
+{
+    if (!logEvents_->poll(pending_))
+        return;
+    appendEvents(pending_);
+    pending_.clear();
+}
+
+void MainWindow::appendEvents(const std::vector<EventBatch> &batches)
 {
-    QString msg = QString("[%1] 鼠标事件: (%2,%3) Type=%4")
-                      .arg(e.time.toString("hh:mm:ss.zzz"))
-                      .arg(e.pos.x())
-                      .arg(e.pos.y())
-                      .arg(e.type);
-    ui->logTextEdit->append(msg);
+    // 所有批次拼成一次 append，避免每个事件都触发一次文本布局
+    QStringList lines;
+    for (const EventBatch &batch : batches) {
+        for (const CapturedEvent &e : batch) {
+            if (e.category == InputCategory::Mouse)
+                lines << formatMouseEvent(e.mouse);
+            else
+                lines << formatKeyEvent(e.key);
+        }
+    }
+    if (!lines.isEmpty())
+        ui->logTextEdit->append(lines.join('\n'));
 }
 
-void MainWindow::handleKeyEvent(const KeyEventData &e)
+QString MainWindow::formatMouseEvent(const MouseEventData &e) const
 {
-    QString msg = QString("[%1] 键盘事件: %2 KeyCode=%3")
-                      .arg(e.time.toString("hh:mm:ss.zzz"))
-                      .arg(e.keyDown ? "按下" : "释放")
-                      .arg(e.vkCode);
-    ui->logTextEdit->append(msg);
+    if (InputCode::isRelative(e.type)) {
+        return QString("[%1] 鼠标%2: %3 Type=%4%5")
+                .arg(formatCaptureTime(e.timestampNs))
+                .arg(e.type == InputCode::RawMotion ? "位移" : "滚轮")
+                .arg(e.type == InputCode::RawMotion ? QString("(%1,%2)").arg(e.x).arg(e.y) : QString::number(e.x))
+                .arg(e.type)
+                .arg(formatSource(e.deviceId, e.flags));
+    }
+    return QString("[%1] 鼠标事件: (%2,%3) Type=%4%5")
+            .arg(formatCaptureTime(e.timestampNs))
+            .arg(e.x)
+            .arg(e.y)
+            .arg(e.type)
+            .arg(formatSource(e.deviceId, e.flags));
+}
+
+QString MainWindow::formatKeyEvent(const KeyEventData &e) const
+{
+    return QString("[%1] 键盘事件: %2 KeyCode=%3%4")
+            .arg(formatCaptureTime(e.timestampNs))
+            .arg(e.keyDown ? "按下" : "释放")
+            .arg(e.vkCode)
+            .arg(formatSource(e.deviceId, e.flags));
 }
 
 // 打开热键配置对话框
@@ -174,6 +348,22 @@ void MainWindow::onOpenHotkeyConfig()
     load(GlobalHotkeyManager::SpeedUpReplay,"hotkeys/speed");
 }
 
+void MainWindow::onSaveRecent()
+{
+    Recorder &recorder = Recorder::instance();
+    if (!recorder.hasRecent()) {
+        QMessageBox::information(this, tr("提示"), tr("未开启最近录制缓冲（record/recentMinutes）"));
+        return;
+    }
+    const QString path = QFileDialog::getSaveFileName(this, tr("保存最近录制"), lastReplayPath_,
+                                                      tr("Binary Record (*.mkr)"));
+    if (path.isEmpty())
+        return;
+    QString error;
+    if (!recorder.saveRecent(path, &error))
+        QMessageBox::warning(this, tr("error"), error);
+}
+
 
 //#include "mainwindow.h"
 //#include "ui_mainwindow.h"
@@ -27,22 +27,33 @@ private slots:
     void on_stopButton_clicked();
     void on_replayButton_clicked();
 
-    void handleMouseEvent(const MouseEventData &e);
-    void handleKeyEvent(const KeyEventData &e);
+    void drainEvents();          // 读取总线上积压的批次并显示（由总线通知调度到 GUI 线程）
 
     void onOpenHotkeyConfig();   // 打开热键配置窗口
+    void onSaveRecent();         // 把内存中最近几分钟的录制另存为文件
 
 private:
     void setupMenus();
     void setupConnections();
+    void appendEvents(const std::vector<EventBatch> &batches);
+    QString formatMouseEvent(const MouseEventData &e) const;
+    QString formatKeyEvent(const KeyEventData &e) const;
 
 private:
     Ui::MainWindow *ui;
     bool capturing_;
     QString lastReplayPath_;
+    // 命令行（--synthetic / --evdev-devices）已选定捕获后端时，配置中的设备列表不覆盖它
+    bool commandLineBackend_ = false;
+    bool injectedTagForDevices_ = false;   // 因 capture/evdevDevices 把注入策略默认改成了 Tag
 
     ReplayControlWidget *replayControlWidget_;
     GlobalHotkeyManager *hotkeyManager_;
+
+    // 日志显示只是预览：Lossy 订阅，界面忙不过来时跳过旧批次，不会拖慢捕获和录制
+    static constexpr quint64 kLogMaxLagEvents = 20000;
+    std::shared_ptr<EventSubscription> logEvents_;
+    std::vector<EventBatch> pending_;   // drainEvents 复用的缓冲区
 };
 
 
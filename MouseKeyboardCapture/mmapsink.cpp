@@ -0,0 +1,134 @@
+#include "mmapsink.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+MmapSink::MmapSink(const QString& path, qint64 extentBytes)
+    : file_(path)
+    // 映射偏移要对齐到分配粒度（Windows 为 64 KiB）
+    , extentBytes_(std::max<qint64>(64 * 1024, extentBytes / (64 * 1024) * (64 * 1024)))
+{
+}
+
+MmapSink::~MmapSink()
+{
+    close();
+}
+
+bool MmapSink::open()
+{
+    // 可写映射要求文件以读写方式打开
+    if (!file_.open(QIODevice::ReadWrite | QIODevice::Truncate))
+        return false;
+    std::lock_guard<std::mutex> lock(mapMutex_);
+    written_ = 0;
+    stats_ = Stats();
+    return mapExtent(0);
+}
+
+bool MmapSink::mapExtent(qint64 offset)
+{
+    if (window_) {
+        file_.unmap(window_);
+        window_ = nullptr;
+    }
+
+    // 先把整段的磁盘空间分配好：稀疏文件的映射在磁盘满时写入会触发 SIGBUS，而这里能返回错误
+    const qint64 end = offset + extentBytes_;
+#if defined(Q_OS_LINUX)
+    if (::posix_fallocate(file_.handle(), offset, extentBytes_) != 0)
+        return false;
+#else
+    if (!file_.resize(end))
+        return false;
+#endif
+    window_ = file_.map(offset, extentBytes_);
+    if (!window_)
+        return false;
+    windowStart_ = offset;
+    ++stats_.extents;
+    stats_.preallocated = end;
+    return true;
+}
+
+bool MmapSink::write(const char* data, qint64 size)
+{
+    if (!window_)
+        return false;
+    qint64 pos = written_.load(std::memory_order_relaxed);
+    while (size > 0) {
+        if (pos == windowStart_ + extentBytes_) {
+            std::lock_guard<std::mutex> lock(mapMutex_);
+            if (!mapExtent(pos))
+                return false;
+        }
+        const qint64 n = std::min(size, windowStart_ + extentBytes_ - pos);
+        std::memcpy(window_ + (pos - windowStart_), data, static_cast<std::size_t>(n));
+        data += n;
+        size -= n;
+        pos += n;
+        written_.store(pos, std::memory_order_release);
+    }
+    return true;
+}
+
+// 把当前窗口中 end 之前的脏页交给磁盘；之前已解除映射的窗口由随后的 fdatasync 一并刷出
+bool MmapSink::flushWindow(qint64 end)
+{
+    const qint64 length = std::min(end, windowStart_ + extentBytes_) - windowStart_;
+    if (!window_ || length <= 0)
+        return true;
+#if defined(Q_OS_WIN)
+    return FlushViewOfFile(window_, static_cast<SIZE_T>(length)) != 0;
+#else
+    return ::msync(window_, static_cast<std::size_t>(length), MS_SYNC) == 0;
+#endif
+}
+
+bool MmapSink::sync()
+{
+    std::lock_guard<std::mutex> lock(mapMutex_);
+    if (!file_.isOpen())
+        return false;
+    ++stats_.syncs;
+    if (!flushWindow(written_.load(std::memory_order_acquire)))
+        return false;
+#if defined(Q_OS_WIN)
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(file_.handle()))) != 0;
+#elif defined(Q_OS_LINUX)
+    return ::fdatasync(file_.handle()) == 0;
+#else
+    return ::fsync(file_.handle()) == 0;
+#endif
+}
+
+void MmapSink::close()
+{
+    std::lock_guard<std::mutex> lock(mapMutex_);
+    if (!file_.isOpen())
+        return;
+    if (window_) {
+        file_.unmap(window_);
+        window_ = nullptr;
+    }
+    // 去掉预分配但没有用到的部分
+    file_.resize(written_.load());
+    file_.close();
+    qDebug().noquote() << QString("MmapSink: %1 bytes in %2 extents of %3 MiB, %4 syncs")
+                          .arg(written_.load()).arg(stats_.extents).arg(extentBytes_ / (1024 * 1024))
+                          .arg(stats_.syncs);
+}
+
+MmapSink::Stats MmapSink::stats() const
+{
+    std::lock_guard<std::mutex> lock(mapMutex_);
+    return stats_;
+}
@@ -0,0 +1,58 @@
+#ifndef MMAPSINK_H
+#define MMAPSINK_H
+
+#include <QFile>
+#include <atomic>
+#include <mutex>
+#include "recordsink.h"
+
+/**
+ * @brief 通过内存映射写入本地文件（record/writer = mmap）
+ *
+ * 文件按 extentBytes（默认 64 MiB）一段一段地预先分配（Linux 上 posix_fallocate，其它平台 QFile::resize），
+ * 只映射正在写的那一段：write() 只是一次 memcpy，写满一段再扩展文件、映射下一段。
+ * 批次写入不再经过 write 系统调用和页缓存拷贝，系统调用只发生在换段时。
+ *
+ * 落盘时刻是显式的：只有 sync() 返回后数据才保证写到磁盘（msync / FlushViewOfFile 加 fdatasync / FlushFileBuffers），
+ * 配合 .mkj 由 JournalSink 按 fsync 策略调用。close() 解除映射并把文件截到实际长度，不额外刷盘（与 FileSink 相同）。
+ * 进程崩溃时文件末尾会留下预分配的零字节：.mkr / .mkj 读取时在零长度的记录处停止，
+ * .mkrz 在全零的块头处停止（BlockCodec 不写空块），前面的内容不受影响。
+ */
+class MmapSink : public RecordSink
+{
+public:
+    static constexpr qint64 kDefaultExtentBytes = 64 * 1024 * 1024;
+
+    struct Stats {
+        quint64 extents = 0;     // 映射过的段数
+        quint64 syncs = 0;
+        qint64 preallocated = 0; // 关闭前文件的分配长度
+    };
+
+    explicit MmapSink(const QString& path, qint64 extentBytes = kDefaultExtentBytes);
+    ~MmapSink() override;
+
+    bool open() override;
+    bool write(const char* data, qint64 size) override;
+    bool sync() override;
+    void close() override;
+    QString name() const override { return file_.fileName(); }
+
+    Stats stats() const;
+
+private:
+    bool mapExtent(qint64 offset);   // 持有 mapMutex_ 调用
+    bool flushWindow(qint64 end);    // 持有 mapMutex_ 调用
+
+private:
+    QFile file_;
+    qint64 extentBytes_;
+    // 当前映射的窗口 [windowStart_, windowStart_ + extentBytes_)；换段和 sync() 互斥（sync() 可能在 JournalSink 的线程上）
+    mutable std::mutex mapMutex_;
+    uchar* window_ = nullptr;
+    qint64 windowStart_ = 0;
+    std::atomic<qint64> written_{0};
+    Stats stats_;
+};
+
+#endif // MMAPSINK_H
@@ -0,0 +1,110 @@
+#include "mousepathsimplifier.h"
+#include "inputcodes.h"
+#include <cmath>
+
+static bool isMove(const CapturedEvent& e)
+{
+    return e.category == InputCategory::Mouse && e.mouse.type == InputCode::MouseMove;
+}
+
+void MousePathSimplifier::reset()
+{
+    stats_ = Stats();
+    hasAnchor_ = false;
+    pending_.clear();
+}
+
+void MousePathSimplifier::process(const std::vector<CapturedEvent>& in, std::vector<CapturedEvent>& out)
+{
+    out.reserve(out.size() + in.size());
+    for (const CapturedEvent& e : in) {
+        if (isMove(e)) {
+            ++stats_.inputMoves;
+            if (config_.epsilonPx <= 0.0) {
+                emitPoint(e, out);
+                continue;
+            }
+            addMove(e, out);
+        } else {
+            // 点击、滚轮、按键前先把光标送到最后的位置
+            flush(out);
+            out.push_back(e);
+        }
+    }
+}
+
+void MousePathSimplifier::flush(std::vector<CapturedEvent>& out)
+{
+    if (pending_.empty())
+        return;
+    emitPoint(pending_.back(), out);
+    pending_.clear();
+}
+
+void MousePathSimplifier::flushIfIdle(qint64 nowNs, std::vector<CapturedEvent>& out)
+{
+    if (!pending_.empty() && nowNs - pending_.back().mouse.timestampNs >= config_.maxHoldNs)
+        flush(out);
+}
+
+void MousePathSimplifier::addMove(const CapturedEvent& e, std::vector<CapturedEvent>& out)
+{
+    if (!hasAnchor_) {
+        emitPoint(e, out);
+        return;
+    }
+
+    if (segmentCovers(anchor_, e.mouse) && static_cast<int>(pending_.size()) < config_.maxPending) {
+        pending_.push_back(e);
+        return;
+    }
+
+    // 锚点→新点已经无法代替暂存点：输出上一个点作为新锚点，新点重新开始暂存
+    if (!pending_.empty()) {
+        emitPoint(pending_.back(), out);
+        pending_.clear();
+        pending_.push_back(e);
+    } else {
+        emitPoint(e, out);
+    }
+}
+
+// 检查线段 a→b 是否能在误差范围内代替所有暂存点
+bool MousePathSimplifier::segmentCovers(const MouseEventData& a, const MouseEventData& b) const
+{
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    const double len2 = dx * dx + dy * dy;
+    const double dt = static_cast<double>(b.timestampNs - a.timestampNs);
+    const double epsPx2 = config_.epsilonPx * config_.epsilonPx;
+    const double epsNs = config_.epsilonMs * 1e6;
+
+    for (const CapturedEvent& pe : pending_) {
+        const MouseEventData& c = pe.mouse;
+        const double ct = static_cast<double>(c.timestampNs - a.timestampNs);
+
+        // 空间误差：同一时刻，线段上按时间插值的位置与实际位置的距离
+        const double u = dt > 0.0 ? ct / dt : 1.0;
+        const double ex = a.x + dx * u - c.x;
+        const double ey = a.y + dy * u - c.y;
+        if (ex * ex + ey * ey > epsPx2)
+            return false;
+
+        // 时间误差：实际位置投影到线段上，对应的插值时刻与实际时刻之差
+        if (epsNs > 0.0 && len2 > 0.0) {
+            double w = ((c.x - a.x) * dx + (c.y - a.y) * dy) / len2;
+            w = w < 0.0 ? 0.0 : (w > 1.0 ? 1.0 : w);
+            if (std::fabs(w * dt - ct) > epsNs)
+                return false;
+        }
+    }
+    return true;
+}
+
+void MousePathSimplifier::emitPoint(const CapturedEvent& e, std::vector<CapturedEvent>& out)
+{
+    out.push_back(e);
+    anchor_ = e.mouse;
+    hasAnchor_ = true;
+    ++stats_.outputMoves;
+}
@@ -0,0 +1,63 @@
+#ifndef MOUSEPATHSIMPLIFIER_H
+#define MOUSEPATHSIMPLIFIER_H
+
+#include <vector>
+#include "inputevent.h"
+
+/**
+ * @brief 鼠标轨迹简化（在 CaptureEngine 工作线程中运行，钩子线程只管原样采集）
+ *
+ * 流式的「最大误差折线」算法：保留一个锚点（上一次输出的点），后续移动点先暂存；
+ * 每来一个新点，就检查锚点→新点这条线段能否在误差范围内代替所有暂存点：
+ * - 空间误差：按时间线性插值得到的位置与实际位置的距离（像素），即回放时同一时刻光标的偏差；
+ * - 时间误差：暂存点投影到线段上对应的时刻与实际时刻之差（毫秒）。
+ * 一旦超出误差，就输出上一个点作为新的锚点。输出的点保留原始时间戳，所以回放节奏不变。
+ *
+ * 非移动事件（点击、滚轮、按键）到来前会先输出暂存的最后一个点，保证点击位置与顺序准确。
+ */
+class MousePathSimplifier
+{
+public:
+    struct Config {
+        double epsilonPx = 2.0;     // <= 0 时关闭简化，原样输出
+        double epsilonMs = 10.0;    // <= 0 时不检查时间误差
+        int maxPending = 256;       // 暂存点上限，防止极长的直线让输出长时间停滞
+        qint64 maxHoldNs = 100LL * 1000 * 1000;  // 空闲多久后输出暂存点
+    };
+
+    struct Stats {
+        quint64 inputMoves = 0;
+        quint64 outputMoves = 0;
+        quint64 saved() const { return inputMoves - outputMoves; }
+    };
+
+    void setConfig(const Config& config) { config_ = config; }
+    const Config& config() const { return config_; }
+    void reset();
+
+    // 处理一个批次，结果追加到 out
+    void process(const std::vector<CapturedEvent>& in, std::vector<CapturedEvent>& out);
+    // 输出暂存点（空闲超时或停止时调用）
+    void flush(std::vector<CapturedEvent>& out);
+    // 有暂存点且已空闲超过 maxHoldNs 时输出
+    void flushIfIdle(qint64 nowNs, std::vector<CapturedEvent>& out);
+
+    bool hasPending() const { return !pending_.empty(); }
+    // flushIfIdle 会输出暂存点的时刻；没有暂存点时返回 0（调用方据此决定是否需要带超时的等待）
+    qint64 idleDeadlineNs() const { return pending_.empty() ? 0 : pending_.back().mouse.timestampNs + config_.maxHoldNs; }
+    const Stats& stats() const { return stats_; }
+
+private:
+    void addMove(const CapturedEvent& e, std::vector<CapturedEvent>& out);
+    bool segmentCovers(const MouseEventData& a, const MouseEventData& b) const;
+    void emitPoint(const CapturedEvent& e, std::vector<CapturedEvent>& out);
+
+private:
+    Config config_;
+    Stats stats_;
+    bool hasAnchor_ = false;
+    MouseEventData anchor_{};
+    std::vector<CapturedEvent> pending_;   // 锚点之后尚未输出的移动点
+};
+
+#endif // MOUSEPATHSIMPLIFIER_H
@@ -0,0 +1,98 @@
+#include "recentringsink.h"
+#include <QSaveFile>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+RecentRingSink::RecentRingSink(int minutes, qint64 maxBytes)
+    : minutes_(std::max(1, minutes)), maxBytes_(maxBytes)
+{
+}
+
+qint64 RecentRingSink::nowMs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+bool RecentRingSink::open()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    header_ = QByteArray();
+    haveHeader_ = false;
+    batches_.clear();
+    bytes_ = 0;
+    return true;
+}
+
+bool RecentRingSink::write(const char* data, qint64 size)
+{
+    return writeBuffer(QByteArray(data, static_cast<int>(size)));
+}
+
+bool RecentRingSink::writeBuffer(const QByteArray& batch)
+{
+    const qint64 now = nowMs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!haveHeader_) {
+        header_ = batch;
+        haveHeader_ = true;
+        return true;
+    }
+    batches_.push_back(Entry{ now, batch });
+    bytes_ += batch.size();
+    trim(now);
+    return true;
+}
+
+void RecentRingSink::trim(qint64 now)
+{
+    const qint64 oldest = now - minutes_ * Q_INT64_C(60000);
+    while (!batches_.empty() && (batches_.front().ms < oldest || bytes_ > maxBytes_)) {
+        bytes_ -= batches_.front().batch.size();
+        batches_.pop_front();
+    }
+}
+
+bool RecentRingSink::save(const QString& path, QString* error) const
+{
+    // 只在锁内复制引用，写文件时不挡住录制
+    QByteArray header;
+    std::vector<QByteArray> batches;
+    const qint64 oldest = nowMs() - minutes_ * Q_INT64_C(60000);   // 空闲时没有新批次触发 trim()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!haveHeader_) {
+            if (error) *error = "nothing recorded yet";
+            return false;
+        }
+        header = header_;
+        batches.reserve(batches_.size());
+        for (const Entry& e : batches_) {
+            if (e.ms >= oldest)
+                batches.push_back(e.batch);
+        }
+    }
+
+    QSaveFile file(path);
+    bool ok = file.open(QIODevice::WriteOnly) && file.write(header) == header.size();
+    for (std::size_t i = 0; ok && i < batches.size(); ++i)
+        ok = file.write(batches[i]) == batches[i].size();
+    if (!ok || !file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+qint64 RecentRingSink::spanMs() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batches_.empty() ? 0 : nowMs() - batches_.front().ms;
+}
+
+qint64 RecentRingSink::bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
@@ -0,0 +1,54 @@
+#ifndef RECENTRINGSINK_H
+#define RECENTRINGSINK_H
+
+#include <QByteArray>
+#include <deque>
+#include <mutex>
+#include "recordsink.h"
+
+/**
+ * @brief 在内存中保留最近 N 分钟的录制（“保存刚才发生的事”）
+ *
+ * 作为 SinkFanout 的旁路 sink 使用：第一个批次是文件头，之后的批次按到达时间保留，
+ * 超过 minutes 或总量超过 maxBytes 的最早批次被丢弃。批次直接持有 SinkFanout 共享的 QByteArray，不再拷贝。
+ *
+ * save() 可在任意线程（通常是界面线程）调用，把文件头和当前保留的批次写成一个 .mkr 文件：
+ * 每个批次以 Sync 记录开头，丢掉前面的批次不影响解码；录制进行中保存时没有设备表。
+ * close() 不清空内容，录制停止后仍可保存，下一次 open() 时才清空。
+ */
+class RecentRingSink : public RecordSink
+{
+public:
+    explicit RecentRingSink(int minutes, qint64 maxBytes = 512 * 1024 * 1024);
+
+    bool open() override;
+    bool write(const char* data, qint64 size) override;
+    bool writeBuffer(const QByteArray& batch) override;
+    void close() override {}
+    QString name() const override { return QString("recent %1 min").arg(minutes_); }
+
+    bool save(const QString& path, QString* error = nullptr) const;
+    // 当前保留的时长（毫秒，按批次到达时间）和字节数
+    qint64 spanMs() const;
+    qint64 bytes() const;
+
+private:
+    static qint64 nowMs();
+    void trim(qint64 now);
+
+private:
+    struct Entry {
+        qint64 ms;          // 到达时间
+        QByteArray batch;
+    };
+
+    int minutes_;
+    qint64 maxBytes_;
+    mutable std::mutex mutex_;
+    QByteArray header_;
+    bool haveHeader_ = false;
+    std::deque<Entry> batches_;
+    qint64 bytes_ = 0;
+};
+
+#endif // RECENTRINGSINK_H
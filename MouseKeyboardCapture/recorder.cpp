@@ -1,7 +1,20 @@
 #include "recorder.h"
-#include <QJsonDocument>
-#include <QTextStream>
+#include "compressedsink.h"
+#include "eventserializer.h"
+#ifdef Q_OS_LINUX
+#include "iouringsink.h"
+#endif
+#include "journalsink.h"
+#include "livestreamsink.h"
+#include "mmapsink.h"
+#include "recordingstats.h"
+#include "sinkfanout.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QDebug>
+#include <algorithm>
+#include <chrono>
 
 //
 // RecorderWorker (后台写入线程)
@@ -16,77 +29,267 @@ RecorderWorker::~RecorderWorker()
     stopWorker();
 }
 
+bool RecorderWorker::parseWriter(const QString& name, Writer& out)
+{
+    const QString n = name.trimmed().toLower();
+    if (n == "file")      out = Writer::File;
+    else if (n == "mmap") out = Writer::Mmap;
+    else if (n == "uring") out = Writer::IoUring;
+    else return false;
+    return true;
+}
+
 void RecorderWorker::setOutputFile(const QString& path)
 {
-    file_.setFileName(path);
+    path_ = path;
 }
 
-void RecorderWorker::enqueue(const RecordedEvent& evt)
+void RecorderWorker::setDevices(const std::vector<InputDeviceInfo>& devices)
 {
     QMutexLocker locker(&mutex_);
-    queue_.push(evt);
-    cond_.wakeOne();
+    devices_ = devices;
 }
 
 void RecorderWorker::stopWorker()
 {
-    {
-        QMutexLocker locker(&mutex_);
-        running_ = false;
-        cond_.wakeOne();
-    }
+    // 关闭订阅：不再接收新批次，已发布的批次由写入线程写完后退出
+    if (subscription_)
+        subscription_->close();
     wait();
-    if (file_.isOpen()) file_.close();
+    subscription_.reset();
+}
+
+// 按录制文件的扩展名（不是段文件名）选择压缩、分帧
+std::unique_ptr<RecordSink> RecorderWorker::createSink(const QString& file) const
+{
+    std::unique_ptr<RecordSink> sink;
+    if (writer_ == Writer::Mmap) {
+        sink.reset(new MmapSink(file));
+    } else if (writer_ == Writer::IoUring) {
+#ifdef Q_OS_LINUX
+        if (IoUringSink::isAvailable())
+            sink.reset(new IoUringSink(file));
+#endif
+        if (!sink)
+            qWarning() << "RecorderWorker: io_uring is not available, writing synchronously";
+    }
+    if (!sink)
+        sink.reset(new FileSink(file));
+    if (BlockCodec::isCompressedPath(path_))
+        sink.reset(new CompressedSink(std::move(sink), compression_));
+    else if (Journal::isJournalPath(path_))
+        sink.reset(new JournalSink(std::move(sink), journal_));
+    return sink;
 }
 
 void RecorderWorker::run()
 {
-    if (!file_.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qWarning() << "RecorderWorker: 无法打开文件" << file_.fileName();
+    using Clock = std::chrono::steady_clock;
+
+    // 调用方自己设置 sink 时不分段
+    const bool segmented = !sink_ && segments_.enabled();
+    if (!sink_)
+        sink_ = createSink(segmented ? SegmentManifest::segmentPath(path_, 0) : path_);
+    if (!sink_->open()) {
+        qWarning() << "RecorderWorker: 无法打开" << sink_->name();
+        // 不再读取的 Lossless 订阅必须关掉，否则它的积压会让引擎一直处于过载状态
+        subscription_->close();
         return;
     }
 
-    QTextStream out(&file_);
-    out << "{\n  \"record_start_time\": \""
-        << QDateTime::currentDateTime().toString(Qt::ISODate) << "\",\n"
-        << "  \"events\": [\n";
-    out.flush();
-
-    running_ = true;
-    bool first = true;
-
-    while (true) {
-        // 首先锁定 mutex_，确保对 queue_（事件队列）和 running_（运行状态）的访问线程安全。
-        mutex_.lock();
-        // 若队列空且线程仍在运行（running_ = true），则通过 cond_.wait(&mutex_) 释放锁并阻塞线程，避免空循环浪费 CPU。
-        if (queue_.empty() && running_) {
-            cond_.wait(&mutex_);
+    const EventSerializer::Format format = EventSerializer::formatForPath(path_);
+    EventSerializer serializer(format, startNs_);
+    const int maxEvents = std::min(std::max(1, batch_.maxBatchEvents), 65536);
+    const std::chrono::milliseconds maxLatency(std::max(0, batch_.maxLatencyMs));
+    stats_ = Stats();
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    // 一个批次的缓冲只在开始时分配一次：reserve 之后 resize(0) 保留容量，之后每个事件只是追加字节
+    QByteArray buffer;
+    buffer.reserve(maxEvents * EventSerializer::kMaxEventBytes);
+    int pending = 0;            // 缓冲中尚未写出的事件数
+    Clock::time_point deadline; // 缓冲中最早的事件必须写出的时刻
+    bool writeFailed = false;
+
+    // 旁路输出：每个批次开头写一条 Sync 记录，丢掉批次或中途接入的一方也能解码
+    SinkFanout fanout;
+    if (!taps_.empty() && format != EventSerializer::Format::Binary)
+        qWarning() << "RecorderWorker: 实时流和最近录制缓冲只支持二进制格式（.mkr / .mkrz / .mkj），已忽略";
+    else
+        for (const std::shared_ptr<RecordSink>& tap : taps_)
+            fanout.add(tap);
+    fanout.start();
+
+    // 分段录制：当前段的统计，换段和结束时写进清单
+    SegmentManifest::Manifest manifest;
+    const QString manifestFile = SegmentManifest::manifestPath(path_);
+    quint64 segmentEvents = 0;
+    qint64 segmentBytes = 0;
+    qint64 segmentFirstUs = 0;
+    qint64 segmentLastUs = 0;
+
+    // 整次录制的统计，结束时写到旁路文件（分段录制写在清单旁边）
+    RecordingStats::Stats recordingStats;
+    const QString recordFile = segmented ? manifestFile : path_;
+    recordingStats.recordFile = QFileInfo(recordFile).fileName();
+    recordingStats.recordStartTime = QDateTime::currentDateTime().toString(Qt::ISODate);
+
+    auto saveManifest = [&]() {
+        QString error;
+        if (!SegmentManifest::save(manifestFile, manifest, &error))
+            qWarning() << "RecorderWorker: 无法写入清单" << manifestFile << error;
+    };
+    auto finishSegment = [&]() {
+        SegmentManifest::Segment& s = manifest.segments.back();
+        s.startUs = segmentFirstUs;
+        s.endUs = segmentLastUs;
+        s.events = segmentEvents;
+        s.bytes = QFileInfo(SegmentManifest::resolve(manifestFile, s.file)).size();
+        s.complete = true;
+    };
+
+    // publish 为 false 时只写录制文件，不转发给旁路 sink（换段时的段尾）
+    auto commit = [&](bool header = false, bool publish = true) {
+        if (buffer.isEmpty())
+            return;
+        if (header)
+            fanout.publishHeader(buffer.constData(), buffer.size());
+        else if (publish)
+            fanout.publish(buffer.constData(), buffer.size());
+        // 写入失败后继续读取并丢弃，不能让 Lossless 订阅的积压拖住捕获
+        if (writeFailed || !sink_->write(buffer.constData(), buffer.size())) {
+            if (!writeFailed)
+                qWarning() << "RecorderWorker: 写入失败，之后的事件不再写出" << sink_->name();
+            writeFailed = true;
+            ++stats_.failedWrites;
         }
-        // 1 当 enqueue 被调用（新事件入队）时，cond_.wakeOne() 唤醒线程；
-        // 2 当 stopWorker 被调用（停止线程）时，cond_.wakeOne() 强制唤醒线程，使其退出阻塞。
+        ++stats_.writes;
+        stats_.bytes += static_cast<quint64>(buffer.size());
+        stats_.largestBatch = std::max<quint64>(stats_.largestBatch, static_cast<quint64>(pending));
+        segmentBytes += buffer.size();
+        buffer.resize(0);
+        pending = 0;
+    };
+
+    serializer.appendHeader(buffer);
+    commit(true);
+
+    if (segmented) {
+        manifest.recordStartTime = recordingStats.recordStartTime;
+        manifest.segments.push_back(SegmentManifest::Segment());
+        manifest.segments.back().file = QFileInfo(SegmentManifest::segmentPath(path_, 0)).fileName();
+        saveManifest();
+    }
 
-        // 若线程已停止（running_ = false）且队列空，解锁后跳出循环，准备结束线程。
-        if (!running_ && queue_.empty()) {
-            mutex_.unlock();
+    // 换段只发生在批次写出之后：结束当前段（写设备表、关闭、更新清单），再打开下一段并写文件头。
+    // 每段的编码器重新开始，段文件可以单独打开；时间戳仍相对整次录制的开始时刻
+    auto rolloverIfFull = [&]() {
+        if (!segmented || writeFailed || segmentEvents == 0)
+            return;
+        const bool full = (segments_.maxBytes > 0 && segmentBytes >= segments_.maxBytes)
+                       || (segments_.maxSeconds > 0 && segmentLastUs - segmentFirstUs >= segments_.maxSeconds * Q_INT64_C(1000000));
+        if (!full)
+            return;
+
+        // 中途的段写入目前已出现过的设备（后端的 devices() 可在任意线程读）；
+        // 段尾只属于段文件，旁路输出是一条连续的流，段尾出现在中间会被订阅方当成录制结束
+        serializer.appendFooter(buffer, CaptureEngine::instance().devices());
+        commit(false, false);
+        sink_->close();
+        finishSegment();
+
+        const int index = static_cast<int>(manifest.segments.size());
+        const QString file = SegmentManifest::segmentPath(path_, index);
+        SegmentManifest::Segment next;
+        next.file = QFileInfo(file).fileName();
+        next.offset = manifest.segments.back().offset + manifest.segments.back().bytes;
+        manifest.segments.push_back(next);
+        segmentEvents = 0;
+        segmentBytes = 0;
+
+        sink_ = createSink(file);
+        if (!sink_->open()) {
+            qWarning() << "RecorderWorker: 无法打开" << sink_->name() << "，之后的事件不再写出";
+            writeFailed = true;
+        }
+        saveManifest();
+        serializer = EventSerializer(format, startNs_);
+        serializer.appendHeader(buffer);
+        commit(true);
+    };
+
+    std::vector<EventBatch> batches;
+    for (;;) {
+        // 有未写的事件时最多等到它的期限；wait() 一次取回自上次读取以来发布的全部批次，
+        // stopWorker() 关闭订阅后先返回剩余的批次，全部取完才返回 false
+        const bool open = pending ? subscription_->wait(batches, deadline) : subscription_->wait(batches);
+        for (const EventBatch& batch : batches) {
+            for (const CapturedEvent& e : batch) {
+                // 期限从事件的捕获时刻算起（captureTimestampNs 与 steady_clock 同源），限制的是捕获到落盘的延迟
+                if (pending == 0) {
+                    deadline = Clock::time_point(std::chrono::nanoseconds(e.timestampNs())) + maxLatency;
+                    if (!fanout.empty())
+                        serializer.appendSync(buffer);
+                }
+                serializer.appendEvent(buffer, e);
+                ++stats_.events;
+                const qint64 us = (e.timestampNs() - startNs_) / 1000;
+                if (segmentEvents++ == 0)
+                    segmentFirstUs = us;
+                segmentLastUs = us;
+                recordingStats.add(e, us);
+                if (++pending >= maxEvents) {
+                    commit();
+                    rolloverIfFull();
+                }
+            }
+        }
+        // 读完立即释放，最后一个持有者释放后批次内存才回收
+        batches.clear();
+        if (!open)
             break;
+        if (pending && Clock::now() >= deadline) {
+            commit();
+            rolloverIfFull();
         }
-
-        auto evt = queue_.front();
-        queue_.pop();
-        mutex_.unlock();
-
-        if (!first) out << ",\n";
-        QJsonDocument doc(evt.json);
-        out << doc.toJson(QJsonDocument::Compact);
-        first = false;
     }
-    // 上述 “等待事件 → 处理事件” 的过程会反复执行，直到 running_ 被设为 false 且队列中的所有事件都被处理完毕
+    commit();
 
-    out << "\n  ]\n}\n";
-    out.flush();
-    file_.close();
+    std::vector<InputDeviceInfo> devices;
+    {
+        QMutexLocker locker(&mutex_);
+        devices = devices_;
+    }
+    serializer.appendFooter(buffer, devices);
+    commit();
+    sink_->close();
+    fanout.stop();
+    for (const SinkFanout::TapStats& tap : fanout.stats()) {
+        qDebug().noquote() << QString("RecorderWorker tap %1: %2 batches, %3 bytes, %4 dropped%5")
+                              .arg(tap.name).arg(tap.batches).arg(tap.bytes).arg(tap.dropped)
+                              .arg(tap.failed ? " (failed)" : "");
+    }
+    if (segmented) {
+        finishSegment();
+        manifest.complete = true;
+        saveManifest();
+    }
+    if (!path_.isEmpty()) {
+        QString error;
+        if (!RecordingStats::save(RecordingStats::sidecarPath(recordFile), recordingStats, &error))
+            qWarning() << "RecorderWorker: 无法写入统计文件" << RecordingStats::sidecarPath(recordFile) << error;
+    }
 
-    qDebug() << "RecorderWorker stopped.";
+    stats_.elapsedSec = elapsed.nsecsElapsed() / 1e9;
+    if (stats_.elapsedSec > 0) {
+        stats_.eventsPerSec = stats_.events / stats_.elapsedSec;
+        stats_.writesPerSec = stats_.writes / stats_.elapsedSec;
+    }
+    qDebug().noquote() << QString("RecorderWorker stopped: %1 events in %2 writes (%3 events/s, %4 writes/s, largest batch %5)")
+                          .arg(stats_.events).arg(stats_.writes)
+                          .arg(stats_.eventsPerSec, 0, 'f', 0).arg(stats_.writesPerSec, 0, 'f', 1)
+                          .arg(stats_.largestBatch);
 }
 
 //
@@ -114,10 +317,24 @@ void Recorder::startRecording(const QString& filePath)
 
     worker_ = new RecorderWorker();
     worker_->setOutputFile(filePath);
+    worker_->setBatchConfig(batch_);
+    worker_->setCompression(compression_);
+    worker_->setJournalConfig(journal_);
+    worker_->setSegmentConfig(segments_);
+    worker_->setWriter(writer_);
+    recent_.reset();
+    if (recentMinutes_ > 0) {
+        recent_ = std::make_shared<RecentRingSink>(recentMinutes_);
+        worker_->addTap(recent_);
+    }
+    if (!liveStream_.isEmpty())
+        worker_->addTap(std::make_shared<LiveStreamSink>(liveStream_));
+    // 录制不能丢事件：Lossless 订阅，跟不上时由 CaptureEngine 的过载策略处理
+    worker_->setSubscription(CaptureEngine::instance().bus().subscribe("recorder", EventBus::Delivery::Lossless));
+    worker_->setStartTimestamp(captureTimestampNs());
     // worker_->start() 启动线程（触发 run() 方法执行）。
     worker_->start();
 
-    timer_.restart();
     recording_ = true;
 
     qDebug() << "Recorder started.";
@@ -127,7 +344,9 @@ void Recorder::stopRecording()
 {
     if (!recording_) return;
 
+    worker_->setDevices(CaptureEngine::instance().devices());
     worker_->stopWorker();
+    lastStats_ = worker_->stats();
     delete worker_;
     worker_ = nullptr;
 
@@ -135,31 +354,13 @@ void Recorder::stopRecording()
     qDebug() << "Recorder stopped.";
 }
 
-void Recorder::onMouseEventCaptured(const MouseEventData& e)
+bool Recorder::saveRecent(const QString& path, QString* error) const
 {
-    if (!recording_ || !worker_) return;
-
-    RecordedEvent evt;
-    evt.json["category"] = "mouse";
-    evt.json["x"] = e.pos.x();
-    evt.json["y"] = e.pos.y();
-    evt.json["type"] = (int)e.type;
-    evt.json["timestamp_ms"] = static_cast<qint64>(timer_.elapsed());
-
-    worker_->enqueue(evt);
-}
-
-void Recorder::onKeyEventCaptured(const KeyEventData& e)
-{
-    if (!recording_ || !worker_) return;
-
-    RecordedEvent evt;
-    evt.json["category"] = "keyboard";
-    evt.json["vkCode"] = (int)e.vkCode;
-    evt.json["keyDown"] = e.keyDown;
-    evt.json["timestamp_ms"] = static_cast<qint64>(timer_.elapsed());
-
-    worker_->enqueue(evt);
+    if (!recent_) {
+        if (error) *error = "the recent buffer is not enabled";
+        return false;
+    }
+    return recent_->save(path, error);
 }
 
 
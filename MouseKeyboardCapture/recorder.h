@@ -6,13 +6,17 @@
 #include <QFile>
 #include <QJsonArray>
 #include <QJsonObject>
-#include <QElapsedTimer>
 #include <QDateTime>
 #include <QMutex>
 #include <QThread>
-#include <QWaitCondition>
-#include <queue>
+#include <memory>
+#include <vector>
 #include "captureengine.h"
+#include "blockcodec.h"
+#include "journal.h"
+#include "recentringsink.h"
+#include "recordsink.h"
+#include "segmentmanifest.h"
 
 //struct MouseEventData {
 //    QPoint pos;
@@ -26,29 +30,83 @@
 //    QDateTime time;
 //};
 
-struct RecordedEvent {
-    QJsonObject json;
-};
-
 class RecorderWorker : public QThread {
     Q_OBJECT
 public:
+    // 组提交：事件先序列化进一块连续缓冲，攒够 maxBatchEvents 个事件，
+    // 或最早的未写事件自捕获起已过 maxLatencyMs 毫秒时，整块一次写给 RecordSink
+    struct BatchConfig {
+        int maxBatchEvents = 8192;  // 上限 65536
+        int maxLatencyMs = 50;
+    };
+
+    // 一次录制的写入统计（stopWorker() 之后读取）
+    struct Stats {
+        quint64 events = 0;
+        quint64 writes = 0;         // RecordSink::write 调用次数（含文件头、文件尾）
+        quint64 bytes = 0;
+        quint64 largestBatch = 0;   // 单次写入的最多事件数
+        quint64 failedWrites = 0;   // 写入失败（及失败之后被丢弃）的批次
+        double elapsedSec = 0.0;
+        double eventsPerSec = 0.0;
+        double writesPerSec = 0.0;
+    };
+
+    // 录制文件的底层写入方式
+    enum class Writer {
+        File,   // FileSink：每个批次一次 write 系统调用
+        Mmap,   // MmapSink：按大段预分配文件，通过滑动的内存映射窗口写入
+        IoUring // IoUringSink（仅 Linux）：异步提交，多个写入和 fdatasync 同时在途；内核不支持时退回 File
+    };
+    // 解析 "file" / "mmap" / "uring"
+    static bool parseWriter(const QString& name, Writer& out);
+
     explicit RecorderWorker(QObject* parent = nullptr);
     ~RecorderWorker();
 
+    // 按扩展名选择格式：.mkr 写二进制格式（RecordFormat），.mkrz 再按 compression 分块压缩（CompressedSink），
+    // .mkj 每个批次一帧、按 journal 的 fsync 策略落盘（JournalSink），其它写 JSON；未设置 sink 时写入这个文件。
+    // 开启分段时改为写 <名称>.000.<扩展名>、<名称>.001.<扩展名>……和清单 <名称>.mkrm（见 SegmentManifest）。
+    // 结束时另写统计旁路文件 <文件>.stats.json，分段录制为 <名称>.mkrm.stats.json（见 RecordingStats）
     void setOutputFile(const QString& path);
-    void enqueue(const RecordedEvent& evt);
+    void setCompression(const BlockCodec::Config& config) { compression_ = config; }
+    void setJournalConfig(const Journal::Config& config) { journal_ = config; }
+    void setSegmentConfig(const SegmentManifest::Config& config) { segments_ = config; }
+    void setWriter(Writer writer) { writer_ = writer; }
+    void setSink(std::unique_ptr<RecordSink> sink) { sink_ = std::move(sink); }
+    // 旁路输出（实时流、最近 N 分钟缓冲……），经 SinkFanout 各自在自己的线程上写，跟不上时丢弃批次、不拖慢录制。
+    // 只支持二进制格式（.mkr / .mkrz / .mkj），收到的是压缩、分帧之前的 .mkr 字节流
+    void addTap(std::shared_ptr<RecordSink> sink) { taps_.push_back(std::move(sink)); }
+    void setBatchConfig(const BatchConfig& config) { batch_ = config; }
+    void setStartTimestamp(qint64 startNs) { startNs_ = startNs; }
+    // 写入线程直接从总线订阅读取批次，由 EventSerializer 在写入线程中序列化，事件不经过 GUI 线程
+    void setSubscription(std::shared_ptr<EventSubscription> subscription) { subscription_ = std::move(subscription); }
+    // 停止前设置本次录制涉及的设备列表，写在文件末尾（事件里只记录 deviceId）
+    void setDevices(const std::vector<InputDeviceInfo>& devices);
     void stopWorker();
 
+    Stats stats() const { return stats_; }
+
 protected:
     void run() override;
 
 private:
-    QFile file_;
-    bool running_ = false;
-    QMutex mutex_;
-    QWaitCondition cond_;
-    std::queue<RecordedEvent> queue_;
+    std::unique_ptr<RecordSink> createSink(const QString& file) const;
+
+private:
+    QString path_;
+    std::unique_ptr<RecordSink> sink_;
+    std::vector<std::shared_ptr<RecordSink>> taps_;
+    BatchConfig batch_;
+    BlockCodec::Config compression_;
+    Journal::Config journal_;
+    SegmentManifest::Config segments_;
+    Writer writer_ = Writer::File;
+    Stats stats_;
+    std::shared_ptr<EventSubscription> subscription_;
+    QMutex mutex_;   // 保护 devices_
+    std::vector<InputDeviceInfo> devices_;
+    qint64 startNs_ = 0;    // 录制开始时刻（captureTimestampNs），事件时间戳相对它计算
 };
 
 
@@ -61,9 +119,21 @@ public:
     void stopRecording();
     bool isRecording() const { return recording_; }
 
-public slots:
-    void onMouseEventCaptured(const MouseEventData& event);
-    void onKeyEventCaptured(const KeyEventData& event);
+    // 对之后开始的录制生效
+    void setBatchConfig(const RecorderWorker::BatchConfig& config) { batch_ = config; }
+    void setCompression(const BlockCodec::Config& config) { compression_ = config; }
+    void setJournalConfig(const Journal::Config& config) { journal_ = config; }
+    void setSegmentConfig(const SegmentManifest::Config& config) { segments_ = config; }
+    void setWriter(RecorderWorker::Writer writer) { writer_ = writer; }
+    // 录制时通过本地套接字 name 实时发布（见 LiveStreamSink，客户端在下一个批次时接入），空字符串表示不发布
+    void setLiveStream(const QString& name) { liveStream_ = name; }
+    // 在内存中保留最近 minutes 分钟（见 RecentRingSink），0 表示不保留
+    void setRecentMinutes(int minutes) { recentMinutes_ = minutes; }
+    // 把最近保留的部分另存为 .mkr（录制中或停止后都可以，下一次开始录制时清空）
+    bool hasRecent() const { return recent_ != nullptr; }
+    bool saveRecent(const QString& path, QString* error = nullptr) const;
+    // 最近一次录制的写入统计
+    RecorderWorker::Stats lastStats() const { return lastStats_; }
 
 private:
     explicit Recorder(QObject* parent = nullptr);
@@ -72,7 +142,15 @@ private:
 private:
     RecorderWorker* worker_ = nullptr;
     bool recording_ = false;
-    QElapsedTimer timer_;
+    RecorderWorker::BatchConfig batch_;
+    BlockCodec::Config compression_;
+    Journal::Config journal_;
+    SegmentManifest::Config segments_;
+    RecorderWorker::Writer writer_ = RecorderWorker::Writer::File;
+    QString liveStream_;
+    int recentMinutes_ = 0;
+    std::shared_ptr<RecentRingSink> recent_;
+    RecorderWorker::Stats lastStats_;
 };
 
 
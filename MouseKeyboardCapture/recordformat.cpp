@@ -0,0 +1,313 @@
+#include "recordformat.h"
+#include "inputcodes.h"
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <cstring>
+
+namespace RecordFormat {
+
+// 鼠标消息与类型码的对应关系，下标为 Kind
+static const quint32 kMouseTypes[] = {
+    0,
+    InputCode::MouseMove,
+    InputCode::LeftDown,
+    InputCode::LeftUp,
+    InputCode::RightDown,
+    InputCode::RightUp,
+    InputCode::MiddleDown,
+    InputCode::MiddleUp,
+    InputCode::Wheel,
+    InputCode::XButtonDown,
+    InputCode::XButtonUp,
+    InputCode::HWheel,
+    InputCode::RawMotion,
+    InputCode::RawWheel,
+    InputCode::RawHWheel,
+};
+static constexpr int kMouseTypeCount = sizeof(kMouseTypes) / sizeof(kMouseTypes[0]);
+
+static quint8 mouseKind(quint32 type)
+{
+    for (int k = 1; k < kMouseTypeCount; ++k) {
+        if (kMouseTypes[k] == type)
+            return static_cast<quint8>(k);
+    }
+    return MouseOther;
+}
+
+// ======================== varint / zigzag ========================
+static int putVarint(char* p, quint64 v)
+{
+    int n = 0;
+    while (v >= 0x80) {
+        p[n++] = static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    p[n++] = static_cast<char>(v);
+    return n;
+}
+
+static quint64 zigzag(qint64 v)
+{
+    return (static_cast<quint64>(v) << 1) ^ static_cast<quint64>(v >> 63);
+}
+
+static qint64 unzigzag(quint64 v)
+{
+    return static_cast<qint64>(v >> 1) ^ -static_cast<qint64>(v & 1);
+}
+
+static void appendVarint(QByteArray& out, quint64 v)
+{
+    char buf[10];
+    out.append(buf, putVarint(buf, v));
+}
+
+static void appendString(QByteArray& out, const QString& s)
+{
+    const QByteArray utf8 = s.toUtf8();
+    appendVarint(out, static_cast<quint64>(utf8.size()));
+    out.append(utf8);
+}
+
+// 带边界检查的读取游标，越界后 ok 置为 false，之后的读取都返回 0
+struct Reader {
+    const uchar* p;
+    const uchar* end;
+    bool ok = true;
+
+    quint64 varint()
+    {
+        quint64 v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p >= end) break;
+            const uchar b = *p++;
+            v |= quint64(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        ok = false;
+        return 0;
+    }
+
+    qint64 svarint() { return unzigzag(varint()); }
+
+    quint8 byte()
+    {
+        if (p >= end) { ok = false; return 0; }
+        return *p++;
+    }
+
+    QString string()
+    {
+        const quint64 len = varint();
+        if (!ok || len > static_cast<quint64>(end - p)) { ok = false; return QString(); }
+        const QString s = QString::fromUtf8(reinterpret_cast<const char*>(p), static_cast<int>(len));
+        p += len;
+        return s;
+    }
+};
+
+bool isBinaryPath(const QString& path)
+{
+    return QFileInfo(path).suffix().compare("mkr", Qt::CaseInsensitive) == 0;
+}
+
+bool hasMagic(const QByteArray& data)
+{
+    return data.size() >= 4 && std::memcmp(data.constData(), kMagic, 4) == 0;
+}
+
+// ======================== 编码 ========================
+void Encoder::appendHeader(QByteArray& out, const QJsonObject& meta) const
+{
+    out.append(kMagic, 4);
+    out.append(static_cast<char>(kVersion));
+    const QByteArray json = QJsonDocument(meta).toJson(QJsonDocument::Compact);
+    appendVarint(out, static_cast<quint64>(json.size()));
+    out.append(json);
+}
+
+void Encoder::appendEvent(QByteArray& out, const CapturedEvent& e)
+{
+    // 负载从 rec[1] 开始写，长度不超过 127 字节，最后把 1 字节的长度前缀填进 rec[0]
+    char rec[kMaxEventRecordBytes];
+    int n = 2;
+
+    // 时间戳按微秒记录（与 JSON 的 timestamp_us 相同）；归并后偶有早于上一个事件的，按上一个事件的时间记录
+    qint64 us = e.timestampNs() > startNs_ ? (e.timestampNs() - startNs_) / 1000 : 0;
+    if (us < lastUs_) us = lastUs_;
+    n += putVarint(rec + n, static_cast<quint64>(us - lastUs_));
+    lastUs_ = us;
+
+    quint8 code;
+    if (e.category == InputCategory::Mouse) {
+        const MouseEventData& m = e.mouse;
+        code = mouseKind(m.type);
+        if (code == RawMotion) {
+            n += putVarint(rec + n, zigzag(m.x));
+            n += putVarint(rec + n, zigzag(m.y));
+        } else if (code == RawWheel || code == RawHWheel) {
+            n += putVarint(rec + n, zigzag(m.x));
+        } else {
+            if (code == MouseOther)
+                n += putVarint(rec + n, m.type);
+            n += putVarint(rec + n, zigzag(qint64(m.x) - lastX_));
+            n += putVarint(rec + n, zigzag(qint64(m.y) - lastY_));
+            lastX_ = m.x;
+            lastY_ = m.y;
+        }
+    } else {
+        code = e.key.keyDown ? KeyDown : KeyUp;
+        n += putVarint(rec + n, e.key.vkCode);
+    }
+
+    if (e.deviceId() != 0) {
+        code |= kHasDevice;
+        n += putVarint(rec + n, e.deviceId());
+    }
+    if (e.isInjected())
+        code |= kInjected;
+
+    rec[1] = static_cast<char>(code);
+    rec[0] = static_cast<char>(n - 1);
+    out.append(rec, n);
+}
+
+void Encoder::appendDevice(QByteArray& out, const InputDeviceInfo& device) const
+{
+    QByteArray payload;
+    payload.append(static_cast<char>(Device));
+    appendVarint(payload, device.id);
+    payload.append(static_cast<char>(device.injected ? 0x01 : 0x00));
+    appendString(payload, device.name);
+    appendString(payload, device.path);
+
+    appendVarint(out, static_cast<quint64>(payload.size()));
+    out.append(payload);
+}
+
+void Encoder::appendSync(QByteArray& out) const
+{
+    char rec[kMaxEventRecordBytes];
+    int n = 1;
+    rec[n++] = static_cast<char>(Sync);
+    n += putVarint(rec + n, static_cast<quint64>(lastUs_));
+    n += putVarint(rec + n, zigzag(lastX_));
+    n += putVarint(rec + n, zigzag(lastY_));
+    rec[0] = static_cast<char>(n - 1);
+    out.append(rec, n);
+}
+
+// ======================== 解码 ========================
+bool decode(const QByteArray& data, std::vector<CapturedEvent>& events,
+            std::vector<InputDeviceInfo>* devices, QJsonObject* meta, QString* error)
+{
+    auto fail = [error](const QString& why) {
+        if (error) *error = why;
+        return false;
+    };
+
+    if (!hasMagic(data))
+        return fail("not a .mkr record file");
+    const uchar* begin = reinterpret_cast<const uchar*>(data.constData());
+    Reader in{ begin + 4, begin + data.size() };
+    const quint8 version = in.byte();
+    if (!in.ok || version != kVersion)
+        return fail(QString("unsupported .mkr version %1").arg(version));
+
+    const quint64 metaSize = in.varint();
+    if (!in.ok || metaSize > static_cast<quint64>(in.end - in.p))
+        return fail("truncated .mkr header");
+    if (meta)
+        *meta = QJsonDocument::fromJson(QByteArray(reinterpret_cast<const char*>(in.p), static_cast<int>(metaSize))).object();
+    in.p += metaSize;
+
+    // 每条事件记录至少 3 字节，按剩余长度预留，读取过程中不再扩容
+    events.clear();
+    events.reserve(static_cast<std::size_t>((in.end - in.p) / 3));
+
+    qint64 us = 0;
+    qint32 lastX = 0, lastY = 0;
+
+    while (in.p < in.end) {
+        const quint64 size = in.varint();
+        if (!in.ok || size == 0 || size > static_cast<quint64>(in.end - in.p))
+            break;   // 末尾不完整的记录
+        Reader rec{ in.p, in.p + size };
+        in.p += size;
+
+        const quint8 code = rec.byte();
+        const quint8 kind = code & kKindMask;
+
+        if (kind == Device) {
+            InputDeviceInfo d;
+            d.id = static_cast<DeviceId>(rec.varint());
+            d.injected = (rec.byte() & 0x01) != 0;
+            d.name = rec.string();
+            d.path = rec.string();
+            d.connected = false;
+            if (rec.ok && devices)
+                devices->push_back(d);
+            continue;
+        }
+        if (kind == Sync) {
+            const qint64 syncUs = static_cast<qint64>(rec.varint());
+            const qint64 syncX = rec.svarint();
+            const qint64 syncY = rec.svarint();
+            if (rec.ok) {
+                us = syncUs;
+                lastX = static_cast<qint32>(syncX);
+                lastY = static_cast<qint32>(syncY);
+            }
+            continue;
+        }
+        if (kind < MouseMove || kind > KeyUp)
+            continue;   // 新版本增加的记录种类，按长度跳过
+
+        us += static_cast<qint64>(rec.varint());
+        CapturedEvent e;
+        std::memset(&e, 0, sizeof(e));
+
+        if (kind == KeyDown || kind == KeyUp) {
+            e.category = InputCategory::Keyboard;
+            e.key.vkCode = static_cast<quint32>(rec.varint());
+            e.key.keyDown = (kind == KeyDown);
+        } else {
+            e.category = InputCategory::Mouse;
+            MouseEventData& m = e.mouse;
+            if (kind == RawMotion) {
+                m.type = InputCode::RawMotion;
+                m.x = static_cast<qint32>(rec.svarint());
+                m.y = static_cast<qint32>(rec.svarint());
+            } else if (kind == RawWheel || kind == RawHWheel) {
+                m.type = kMouseTypes[kind];
+                m.x = static_cast<qint32>(rec.svarint());
+            } else {
+                m.type = (kind == MouseOther) ? static_cast<quint32>(rec.varint()) : kMouseTypes[kind];
+                lastX = static_cast<qint32>(lastX + rec.svarint());
+                lastY = static_cast<qint32>(lastY + rec.svarint());
+                m.x = lastX;
+                m.y = lastY;
+            }
+        }
+        const DeviceId device = (code & kHasDevice) ? static_cast<DeviceId>(rec.varint()) : 0;
+        if (!rec.ok)
+            return fail("corrupt .mkr event record");
+
+        const EventFlags flags = (code & kInjected) ? EventFlag::Injected : 0;
+        if (e.category == InputCategory::Mouse) {
+            e.mouse.flags = flags;
+            e.mouse.deviceId = device;
+            e.mouse.timestampNs = us * 1000;
+        } else {
+            e.key.flags = flags;
+            e.key.deviceId = device;
+            e.key.timestampNs = us * 1000;
+        }
+        events.push_back(e);
+    }
+    return true;
+}
+
+} // namespace RecordFormat
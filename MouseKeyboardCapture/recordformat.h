@@ -0,0 +1,106 @@
+#ifndef RECORDFORMAT_H
+#define RECORDFORMAT_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <vector>
+#include "capturebackend.h"
+#include "inputevent.h"
+
+/**
+ * @brief 二进制录制格式（.mkr）
+ *
+ * 与 JSON 格式记录相同的信息，体积约为其十分之一，只追加写入：
+ *
+ *   文件头  4 字节魔数 "MKR\x1A" | 1 字节版本号 | varint 长度 + UTF-8 JSON 元数据（record_start_time 等）
+ *   记录    varint 负载长度 | 1 字节类型码 | 负载
+ *
+ * 类型码低 6 位为记录种类（Kind），事件记录另有两个标志位：
+ *   0x40 负载末尾带 varint 设备编号（编号为 0 时省略），0x80 注入事件（EventFlag::Injected）。
+ *
+ * 事件记录的负载以 varint 时间增量开头（微秒，相对上一个事件），之后：
+ *   鼠标按键/移动/滚轮    zigzag varint x、y 增量（相对上一个带绝对坐标的鼠标事件）
+ *   RawMotion             zigzag varint dx、dy（本身就是位移）
+ *   RawWheel / RawHWheel  zigzag varint 滚动量
+ *   其它鼠标消息          varint 消息值，再按绝对坐标写 x、y 增量
+ *   键盘                  varint 虚拟键码
+ * 录制结束时设备表作为 Device 记录追加在末尾：varint 编号、1 字节标志（0x01 注入）、名称和路径（varint 长度 + UTF-8）。
+ *
+ * Sync 记录是解码状态的快照：varint 当前时间（微秒）、zigzag varint 上一个绝对坐标 x、y。
+ * 它只重复编码器已有的状态，顺序读取时跳过它结果不变；从它开始读（旁路输出中途接入、丢掉前面的批次）也能正确解码。
+ *
+ * 读取时按长度跳过不认识的记录；文件末尾不完整的记录（进程在写入中途退出）被忽略，之前的事件照常读出。
+ */
+namespace RecordFormat {
+
+constexpr char kMagic[4] = { 'M', 'K', 'R', '\x1A' };
+constexpr quint8 kVersion = 1;
+constexpr int kMaxEventRecordBytes = 32;   // 一条事件记录（含长度前缀）编码后的上限
+
+enum Kind : quint8 {
+    MouseMove = 1,
+    LeftDown,
+    LeftUp,
+    RightDown,
+    RightUp,
+    MiddleDown,
+    MiddleUp,
+    Wheel,
+    XButtonDown,
+    XButtonUp,
+    HWheel,
+    RawMotion,
+    RawWheel,
+    RawHWheel,
+    MouseOther,
+    KeyDown,
+    KeyUp,
+    Device = 0x30,
+    Sync = 0x31
+};
+
+constexpr quint8 kKindMask = 0x3F;
+constexpr quint8 kHasDevice = 0x40;
+constexpr quint8 kInjected = 0x80;
+
+// 按扩展名选择格式：.mkr 为二进制，其它按 JSON 处理
+bool isBinaryPath(const QString& path);
+bool hasMagic(const QByteArray& data);
+
+/**
+ * @brief 二进制编码器（只由一个写入线程使用）
+ * 事件先编码到栈上的定长缓冲，再追加到调用方的输出缓冲；
+ * 输出缓冲预留了足够容量时，编码一个事件不做任何堆分配。
+ */
+class Encoder
+{
+public:
+    // startNs：录制开始时刻（captureTimestampNs），事件时间戳相对它计算
+    explicit Encoder(qint64 startNs = 0) : startNs_(startNs) {}
+
+    void appendHeader(QByteArray& out, const QJsonObject& meta) const;
+    void appendEvent(QByteArray& out, const CapturedEvent& e);
+    void appendDevice(QByteArray& out, const InputDeviceInfo& device) const;
+    // 写一条 Sync 记录（当前的时间和坐标基准）
+    void appendSync(QByteArray& out) const;
+
+private:
+    qint64 startNs_;
+    qint64 lastUs_ = 0;
+    qint32 lastX_ = 0;
+    qint32 lastY_ = 0;
+};
+
+/**
+ * @brief 解码整个文件
+ * 事件的 timestampNs 为相对录制开始的时间（纳秒），与 JSON 加载结果一致，可直接交给 ReplayWorker。
+ * 文件头不合法时返回 false 并给出原因。
+ */
+bool decode(const QByteArray& data, std::vector<CapturedEvent>& events,
+            std::vector<InputDeviceInfo>* devices = nullptr, QJsonObject* meta = nullptr,
+            QString* error = nullptr);
+
+} // namespace RecordFormat
+
+#endif // RECORDFORMAT_H
@@ -0,0 +1,285 @@
+#include "recordingstats.h"
+#include "inputcodes.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+
+namespace RecordingStats {
+
+namespace {
+
+struct MouseType {
+    quint32 code;
+    const char* name;
+};
+
+const MouseType kMouseTypeTable[kMouseTypes - 1] = {
+    { InputCode::MouseMove,   "move" },
+    { InputCode::LeftDown,    "left_down" },
+    { InputCode::LeftUp,      "left_up" },
+    { InputCode::RightDown,   "right_down" },
+    { InputCode::RightUp,     "right_up" },
+    { InputCode::MiddleDown,  "middle_down" },
+    { InputCode::MiddleUp,    "middle_up" },
+    { InputCode::Wheel,       "wheel" },
+    { InputCode::XButtonDown, "xbutton_down" },
+    { InputCode::XButtonUp,   "xbutton_up" },
+    { InputCode::HWheel,      "hwheel" },
+    { InputCode::RawMotion,   "raw_motion" },
+    { InputCode::RawWheel,    "raw_wheel" },
+    { InputCode::RawHWheel,   "raw_hwheel" },
+};
+
+int mouseTypeIndex(quint32 code)
+{
+    for (int i = 0; i < kMouseTypes - 1; ++i) {
+        if (kMouseTypeTable[i].code == code)
+            return i;
+    }
+    return kMouseTypes - 1;
+}
+
+// 时间戳异常时不让每秒计数表无限增长
+constexpr qint64 kMaxSeconds = 31LL * 24 * 3600;
+
+} // namespace
+
+const char* mouseTypeName(int index)
+{
+    return index >= 0 && index < kMouseTypes - 1 ? kMouseTypeTable[index].name : "other";
+}
+
+Stats::Stats()
+{
+    perSecond.reserve(3600);
+}
+
+void Stats::add(const CapturedEvent& e, qint64 us)
+{
+    if (events == 0) {
+        firstUs = lastUs = us;
+    } else if (us > lastUs) {
+        const qint64 gap = us - lastUs;
+        if (gap >= kIdleThresholdUs) {
+            ++idleCount;
+            idleTotalUs += gap;
+            if (gap > idleLongestUs) {
+                idleLongestUs = gap;
+                idleLongestStartUs = lastUs;
+            }
+            if (idleGaps.size() < static_cast<std::size_t>(kMaxGaps))
+                idleGaps.emplace_back(lastUs, gap);
+        }
+        lastUs = us;
+    }
+    ++events;
+
+    const qint64 second = std::max<qint64>(0, us) / 1000000;
+    if (second < kMaxSeconds) {
+        if (static_cast<std::size_t>(second) >= perSecond.size())
+            perSecond.resize(static_cast<std::size_t>(second) + 1, 0);
+        ++perSecond[static_cast<std::size_t>(second)];
+    }
+
+    if (e.isInjected())
+        ++injectedEvents;
+
+    if (e.category == InputCategory::Mouse) {
+        ++mouseEvents;
+        ++mouseTypes[static_cast<std::size_t>(mouseTypeIndex(e.mouse.type))];
+        // 相对运动的 x/y 是位移，不是指针位置
+        if (!InputCode::isRelative(e.mouse.type)) {
+            if (!hasPointer) {
+                hasPointer = true;
+                minX = maxX = e.mouse.x;
+                minY = maxY = e.mouse.y;
+            } else {
+                minX = std::min(minX, e.mouse.x);
+                maxX = std::max(maxX, e.mouse.x);
+                minY = std::min(minY, e.mouse.y);
+                maxY = std::max(maxY, e.mouse.y);
+            }
+        }
+    } else {
+        ++keyEvents;
+        if (e.key.vkCode < static_cast<quint32>(kKeyCodes))
+            ++(e.key.keyDown ? keyDown : keyUp)[e.key.vkCode];
+        else
+            ++otherKeys;
+    }
+}
+
+quint32 Stats::peakPerSecond() const
+{
+    return perSecond.empty() ? 0 : *std::max_element(perSecond.begin(), perSecond.end());
+}
+
+QString Stats::summary() const
+{
+    QString s = QString("%1 events (%2 mouse, %3 keys) over %4 s, peak %5/s, %6 idle gaps")
+                .arg(events).arg(mouseEvents).arg(keyEvents)
+                .arg(durationUs() / 1e6, 0, 'f', 1).arg(peakPerSecond()).arg(idleCount);
+    if (idleCount)
+        s += QString(" (longest %1 s)").arg(idleLongestUs / 1e6, 0, 'f', 1);
+    if (hasPointer)
+        s += QString(", pointer %1,%2 - %3,%4").arg(minX).arg(minY).arg(maxX).arg(maxY);
+    return s;
+}
+
+QString sidecarPath(const QString& recordPath)
+{
+    return recordPath + ".stats.json";
+}
+
+bool save(const QString& path, const Stats& stats, QString* error)
+{
+    QJsonObject mouseTypes;
+    for (int i = 0; i < kMouseTypes; ++i) {
+        if (stats.mouseTypes[static_cast<std::size_t>(i)])
+            mouseTypes[mouseTypeName(i)] = static_cast<qint64>(stats.mouseTypes[static_cast<std::size_t>(i)]);
+    }
+    QJsonObject keys;
+    for (int vk = 0; vk < kKeyCodes; ++vk) {
+        const quint64 down = stats.keyDown[static_cast<std::size_t>(vk)];
+        const quint64 up = stats.keyUp[static_cast<std::size_t>(vk)];
+        if (!down && !up)
+            continue;
+        QJsonObject k;
+        k["down"] = static_cast<qint64>(down);
+        k["up"] = static_cast<qint64>(up);
+        keys[QString::number(vk)] = k;
+    }
+
+    QJsonArray perSecond;
+    for (quint32 n : stats.perSecond)
+        perSecond.append(static_cast<qint64>(n));
+    QJsonObject rate;
+    rate["peak_per_sec"] = static_cast<qint64>(stats.peakPerSecond());
+    rate["mean_per_sec"] = stats.durationUs() > 0 ? stats.events / (stats.durationUs() / 1e6) : 0.0;
+    rate["per_second"] = perSecond;
+
+    QJsonArray gaps;
+    for (const auto& g : stats.idleGaps)
+        gaps.append(QJsonArray{ g.first, g.second });
+    QJsonObject idle;
+    idle["threshold_us"] = kIdleThresholdUs;
+    idle["count"] = static_cast<qint64>(stats.idleCount);
+    idle["total_us"] = stats.idleTotalUs;
+    idle["longest_us"] = stats.idleLongestUs;
+    idle["longest_start_us"] = stats.idleLongestStartUs;
+    idle["gaps"] = gaps;
+
+    QJsonObject root;
+    root["version"] = kVersion;
+    root["record_file"] = stats.recordFile;
+    root["record_start_time"] = stats.recordStartTime;
+    root["time_unit"] = "us";
+    root["events"] = static_cast<qint64>(stats.events);
+    root["mouse_events"] = static_cast<qint64>(stats.mouseEvents);
+    root["key_events"] = static_cast<qint64>(stats.keyEvents);
+    root["injected_events"] = static_cast<qint64>(stats.injectedEvents);
+    root["first_us"] = stats.firstUs;
+    root["last_us"] = stats.lastUs;
+    root["duration_us"] = stats.durationUs();
+    root["mouse_types"] = mouseTypes;
+    root["keys"] = keys;
+    root["other_keys"] = static_cast<qint64>(stats.otherKeys);
+    root["rate"] = rate;
+    root["idle"] = idle;
+    if (stats.hasPointer) {
+        QJsonObject bounds;
+        bounds["min_x"] = stats.minX;
+        bounds["min_y"] = stats.minY;
+        bounds["max_x"] = stats.maxX;
+        bounds["max_y"] = stats.maxY;
+        root["pointer_bounds"] = bounds;
+    } else {
+        root["pointer_bounds"] = QJsonValue();
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0
+        || !file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool load(const QString& path, Stats& stats, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    QJsonParseError err;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &err);
+    if (err.error != QJsonParseError::NoError || !doc.isObject()) {
+        if (error) *error = QString("stats parse error: %1").arg(err.errorString());
+        return false;
+    }
+    const QJsonObject root = doc.object();
+    if (root.value("version").toInt() != kVersion) {
+        if (error) *error = QString("unsupported stats version %1").arg(root.value("version").toInt());
+        return false;
+    }
+
+    auto u64 = [](const QJsonValue& v) { return v.toVariant().toULongLong(); };
+    auto i64 = [](const QJsonValue& v) { return v.toVariant().toLongLong(); };
+
+    stats = Stats();
+    stats.recordFile = root.value("record_file").toString();
+    stats.recordStartTime = root.value("record_start_time").toString();
+    stats.events = u64(root.value("events"));
+    stats.mouseEvents = u64(root.value("mouse_events"));
+    stats.keyEvents = u64(root.value("key_events"));
+    stats.injectedEvents = u64(root.value("injected_events"));
+    stats.firstUs = i64(root.value("first_us"));
+    stats.lastUs = i64(root.value("last_us"));
+
+    const QJsonObject mouseTypes = root.value("mouse_types").toObject();
+    for (int i = 0; i < kMouseTypes; ++i)
+        stats.mouseTypes[static_cast<std::size_t>(i)] = u64(mouseTypes.value(mouseTypeName(i)));
+    const QJsonObject keys = root.value("keys").toObject();
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        const int vk = it.key().toInt();
+        if (vk < 0 || vk >= kKeyCodes)
+            continue;
+        const QJsonObject k = it.value().toObject();
+        stats.keyDown[static_cast<std::size_t>(vk)] = u64(k.value("down"));
+        stats.keyUp[static_cast<std::size_t>(vk)] = u64(k.value("up"));
+    }
+    stats.otherKeys = u64(root.value("other_keys"));
+
+    for (const QJsonValue& v : root.value("rate").toObject().value("per_second").toArray())
+        stats.perSecond.push_back(static_cast<quint32>(u64(v)));
+
+    const QJsonObject idle = root.value("idle").toObject();
+    stats.idleCount = u64(idle.value("count"));
+    stats.idleTotalUs = i64(idle.value("total_us"));
+    stats.idleLongestUs = i64(idle.value("longest_us"));
+    stats.idleLongestStartUs = i64(idle.value("longest_start_us"));
+    for (const QJsonValue& v : idle.value("gaps").toArray()) {
+        const QJsonArray g = v.toArray();
+        stats.idleGaps.emplace_back(i64(g.at(0)), i64(g.at(1)));
+    }
+
+    const QJsonValue bounds = root.value("pointer_bounds");
+    if (bounds.isObject()) {
+        const QJsonObject b = bounds.toObject();
+        stats.hasPointer = true;
+        stats.minX = b.value("min_x").toInt();
+        stats.minY = b.value("min_y").toInt();
+        stats.maxX = b.value("max_x").toInt();
+        stats.maxY = b.value("max_y").toInt();
+    }
+    return true;
+}
+
+} // namespace RecordingStats
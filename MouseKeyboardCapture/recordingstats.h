@@ -0,0 +1,88 @@
+#ifndef RECORDINGSTATS_H
+#define RECORDINGSTATS_H
+
+#include <QString>
+#include <array>
+#include <utility>
+#include <vector>
+#include "inputevent.h"
+
+/**
+ * @brief 录制统计旁路文件（<录制文件>.stats.json）
+ *
+ * RecorderWorker 在序列化每个事件时顺带累加（Stats::add 只做计数和比较，稳态下不分配内存），
+ * 录制结束时用 QSaveFile 写到录制文件旁边；分段录制写在清单旁边（day.mkrm.stats.json）。
+ * 资料库工具和界面读这个小文件就能显示概要，不必解析全部事件：
+ *
+ *   { "version": 1, "record_file": "day.mkj", "record_start_time": "...", "time_unit": "us",
+ *     "events": 123, "mouse_events": 100, "key_events": 23, "injected_events": 0,
+ *     "first_us": 0, "last_us": 5000000, "duration_us": 5000000,
+ *     "mouse_types": { "move": 90, "left_down": 5, ... },         // 只列出现过的类型
+ *     "keys": { "65": { "down": 3, "up": 3 }, ... },               // 按虚拟键码
+ *     "rate": { "peak_per_sec": 40, "mean_per_sec": 24.6, "per_second": [ 12, 40, ... ] },
+ *     "idle": { "threshold_us": 2000000, "count": 1, "total_us": 2500000, "longest_us": 2500000,
+ *               "longest_start_us": 1000000, "gaps": [ [ 1000000, 2500000 ], ... ] },
+ *     "pointer_bounds": { "min_x": 0, "min_y": 0, "max_x": 1919, "max_y": 1079 } }   // 没有绝对坐标时为 null
+ *
+ * per_second 的第 i 项是 [i, i+1) 秒内的事件数，从录制开始算起。空闲指相邻两个事件间隔不少于 threshold_us，
+ * gaps 只保留前 kMaxGaps 段（[开始时刻, 长度]），count / total_us / longest_us 覆盖全部。
+ */
+namespace RecordingStats {
+
+constexpr int kVersion = 1;
+constexpr qint64 kIdleThresholdUs = 2000000;
+constexpr int kMaxGaps = 1000;
+// 虚拟键码都小于 256，更大的编码只计入 otherKeys
+constexpr int kKeyCodes = 256;
+// 已知的鼠标事件类型（InputCode），最后一项为其它
+constexpr int kMouseTypes = 15;
+
+struct Stats {
+    QString recordFile;           // 文件名，不含目录
+    QString recordStartTime;
+    quint64 events = 0;
+    quint64 mouseEvents = 0;
+    quint64 keyEvents = 0;
+    quint64 injectedEvents = 0;
+    qint64 firstUs = 0;
+    qint64 lastUs = 0;
+
+    std::array<quint64, kMouseTypes> mouseTypes = {};
+    std::array<quint64, kKeyCodes> keyDown = {};
+    std::array<quint64, kKeyCodes> keyUp = {};
+    quint64 otherKeys = 0;
+
+    std::vector<quint32> perSecond;
+
+    quint64 idleCount = 0;
+    qint64 idleTotalUs = 0;
+    qint64 idleLongestUs = 0;
+    qint64 idleLongestStartUs = 0;
+    std::vector<std::pair<qint64, qint64>> idleGaps;   // [开始时刻, 长度]
+
+    bool hasPointer = false;
+    qint32 minX = 0, minY = 0, maxX = 0, maxY = 0;
+
+    Stats();
+
+    // us：事件时间戳相对录制开始的微秒数，按写出顺序调用
+    void add(const CapturedEvent& e, qint64 us);
+
+    qint64 durationUs() const { return events ? lastUs - firstUs : 0; }
+    quint32 peakPerSecond() const;
+    // 一行概要，界面和命令行显示用
+    QString summary() const;
+};
+
+// mouseTypes 下标对应的名称（"move"、"left_down"……，最后一项 "other"）
+const char* mouseTypeName(int index);
+
+// day.mkj -> day.mkj.stats.json
+QString sidecarPath(const QString& recordPath);
+
+bool save(const QString& path, const Stats& stats, QString* error = nullptr);
+bool load(const QString& path, Stats& stats, QString* error = nullptr);
+
+} // namespace RecordingStats
+
+#endif // RECORDINGSTATS_H
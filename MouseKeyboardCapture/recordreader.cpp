@@ -0,0 +1,118 @@
+#include "recordreader.h"
+#include "blockcodec.h"
+#include "inputcodes.h"
+#include "journal.h"
+#include "recordformat.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+#include <cstring>
+
+namespace RecordReader {
+
+// 新录制文件使用 timestamp_us（微秒），兼容旧文件的 timestamp_ms
+static qint64 eventTimestampUs(const QJsonObject &evt)
+{
+    if (evt.contains("timestamp_us"))
+        return evt.value("timestamp_us").toVariant().toLongLong();
+    return evt.value("timestamp_ms").toVariant().toLongLong() * 1000;
+}
+
+// JSON 事件转换成与 .mkr 解码结果相同的 POD 形式（相对运动的位移/滚动量放在 x/y 中）
+static CapturedEvent eventFromJson(const QJsonObject &evt)
+{
+    CapturedEvent e;
+    std::memset(&e, 0, sizeof(e));
+    const qint64 ts = eventTimestampUs(evt) * 1000;
+    const DeviceId device = static_cast<DeviceId>(evt.value("device").toInt());
+    const EventFlags flags = evt.value("injected").toBool() ? EventFlag::Injected : 0;
+
+    if (evt.value("category").toString() == "keyboard") {
+        e.category = InputCategory::Keyboard;
+        e.key = KeyEventData{ static_cast<quint32>(evt.value("vkCode").toInt()), evt.value("keyDown").toBool(),
+                              flags, device, ts };
+        return e;
+    }
+
+    e.category = InputCategory::Mouse;
+    const quint32 type = static_cast<quint32>(evt.value("type").toInt());
+    qint32 x, y = 0;
+    if (type == InputCode::RawMotion) {
+        x = evt.value("dx").toInt();
+        y = evt.value("dy").toInt();
+    } else if (InputCode::isRelative(type)) {
+        x = evt.value("delta").toInt();
+    } else {
+        x = evt.value("x").toInt();
+        y = evt.value("y").toInt();
+    }
+    e.mouse = MouseEventData{ x, y, type, flags, device, ts };
+    return e;
+}
+
+bool readFile(const QString& path, std::vector<CapturedEvent>& events, QString* error)
+{
+    auto fail = [error](const QString& why) {
+        if (error) *error = why;
+        return false;
+    };
+
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly))
+        return fail(QString("cannot open %1").arg(path));
+    QByteArray ba = f.readAll();
+    f.close();
+
+    // 分块压缩的录制先并行解压出 .mkr 字节流
+    if (BlockCodec::hasMagic(ba)) {
+        QByteArray raw;
+        QString why;
+        if (!BlockCodec::decode(ba, raw, &why))
+            return fail(why);
+        ba = raw;
+    }
+
+    // 日志格式的录制：校验每一帧，崩溃后留下的不完整尾部被丢弃，之前的事件照常回放
+    if (Journal::hasMagic(ba)) {
+        QByteArray raw;
+        QString why;
+        Journal::RecoverInfo info;
+        if (!Journal::recover(ba, raw, &info, &why))
+            return fail(why);
+        if (!info.stopReason.isEmpty())
+            qWarning().noquote() << QString("RecordReader: recovered %1 frames (%2 bytes) from %3, discarded %4 bytes: %5")
+                                    .arg(info.frames).arg(info.goodBytes).arg(path)
+                                    .arg(info.discardedBytes).arg(info.stopReason);
+        ba = raw;
+    }
+
+    // 二进制录制直接解码成事件数组，不经过 JSON
+    if (RecordFormat::hasMagic(ba)) {
+        QString why;
+        if (!RecordFormat::decode(ba, events, nullptr, nullptr, &why)) {
+            events.clear();
+            return fail(why);
+        }
+        return true;
+    }
+
+    QJsonParseError err;
+    QJsonDocument doc = QJsonDocument::fromJson(ba, &err);
+    if (err.error != QJsonParseError::NoError)
+        return fail(QString("JSON parse error: %1").arg(err.errorString()));
+    if (!doc.isObject())
+        return fail("not a record file");
+    QJsonObject root = doc.object();
+    if (!root.contains("events") || !root.value("events").isArray())
+        return fail("no events array");
+    const QJsonArray array = root.value("events").toArray();
+    events.clear();
+    events.reserve(static_cast<std::size_t>(array.size()));
+    for (const QJsonValue &v : array)
+        events.push_back(eventFromJson(v.toObject()));
+    return true;
+}
+
+} // namespace RecordReader
@@ -0,0 +1,20 @@
+#ifndef RECORDREADER_H
+#define RECORDREADER_H
+
+#include <QString>
+#include <vector>
+#include "inputevent.h"
+
+/**
+ * @brief 读取一个录制文件（.json / .mkr / .mkrz / .mkj，按内容识别）
+ *
+ * 事件解码成 POD（CapturedEvent，timestampNs 为相对录制开始的时间）。
+ * 只用局部状态，可以在任意线程调用：ReplayWorker 回放分段录制时在后台线程预读下一段。
+ */
+namespace RecordReader {
+
+bool readFile(const QString& path, std::vector<CapturedEvent>& events, QString* error = nullptr);
+
+} // namespace RecordReader
+
+#endif // RECORDREADER_H
@@ -0,0 +1,43 @@
+#include "recordsink.h"
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+FileSink::FileSink(const QString& path)
+    : file_(path)
+{
+}
+
+bool FileSink::open()
+{
+    // 批次已经在 RecorderWorker 里攒好，不再经过 QFile 的缓冲区：每个批次正好一次 write 系统调用
+    return file_.open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+bool FileSink::write(const char* data, qint64 size)
+{
+    return file_.write(data, size) == size;
+}
+
+bool FileSink::sync()
+{
+    if (!file_.isOpen())
+        return false;
+#if defined(Q_OS_WIN)
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(file_.handle()))) != 0;
+#elif defined(Q_OS_LINUX)
+    // 只需要数据和文件长度落盘，不必等修改时间等元数据
+    return ::fdatasync(file_.handle()) == 0;
+#else
+    return ::fsync(file_.handle()) == 0;
+#endif
+}
+
+void FileSink::close()
+{
+    if (file_.isOpen())
+        file_.close();
+}
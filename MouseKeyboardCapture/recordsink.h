@@ -0,0 +1,48 @@
+#ifndef RECORDSINK_H
+#define RECORDSINK_H
+
+#include <QFile>
+#include <QString>
+
+/**
+ * @brief 录制输出的去向
+ * RecorderWorker 把一批事件序列化成一块连续的缓冲后调用一次 write()，
+ * 实现只需要把这块数据按顺序写出去。open / write / close 都在写入线程中调用。
+ */
+class RecordSink
+{
+public:
+    virtual ~RecordSink() = default;
+
+    virtual bool open() = 0;
+    // 写出一个完整的批次，失败时返回 false（磁盘满、设备移除等）
+    virtual bool write(const char* data, qint64 size) = 0;
+    // 写出一个由多个 sink 共享的批次（SinkFanout，隐式共享、引用计数）；需要保留数据的实现重写它直接持有引用，不再拷贝
+    virtual bool writeBuffer(const QByteArray& batch) { return write(batch.constData(), batch.size()); }
+    // 把已写出的数据刷到持久存储（fsync）。JournalSink 可能在自己的线程上调用，与 write() 并发
+    virtual bool sync() { return true; }
+    virtual void close() = 0;
+    // 用于日志
+    virtual QString name() const = 0;
+};
+
+/**
+ * @brief 写入本地文件
+ * 以二进制方式打开（JSON 的换行由 EventSerializer 按平台写好），不经过 QFile 的缓冲区。
+ */
+class FileSink : public RecordSink
+{
+public:
+    explicit FileSink(const QString& path);
+
+    bool open() override;
+    bool write(const char* data, qint64 size) override;
+    bool sync() override;
+    void close() override;
+    QString name() const override { return file_.fileName(); }
+
+private:
+    QFile file_;
+};
+
+#endif // RECORDSINK_H
@@ -1,10 +1,10 @@
 #include "replaymanager.h"
 #include "replayworker.h"
 #include "globalhotkeymanager.h"
-#include <QFile>
-#include <QJsonDocument>
+#include "recordreader.h"
+#include <QStringList>
 #include <QDebug>
-#include <QJsonObject>
+#include <algorithm>
 
 ReplayManager& ReplayManager::instance()
 {
@@ -43,36 +43,88 @@ ReplayManager::~ReplayManager()
 
 bool ReplayManager::loadReplayFile(const QString &path)
 {
-    QFile f(path);
-    if (!f.open(QIODevice::ReadOnly)) {
-        qWarning() << "ReplayManager: cannot open" << path;
+    m_events.clear();
+    m_manifest = SegmentManifest::Manifest();
+    m_manifestPath.clear();
+    m_windowFromUs = 0;
+    m_windowToUs = -1;
+
+    // 分段录制只读清单，段文件在回放时由 ReplayWorker 逐段读取
+    if (SegmentManifest::isManifestPath(path)) {
+        QString error;
+        if (!SegmentManifest::load(path, m_manifest, &error)) {
+            qWarning() << "ReplayManager:" << error;
+            return false;
+        }
+        m_manifestPath = path;
+        return !m_manifest.segments.empty();
+    }
+
+    QString error;
+    if (!RecordReader::readFile(path, m_events, &error)) {
+        qWarning() << "ReplayManager:" << error;
         return false;
     }
-    QByteArray ba = f.readAll();
-    f.close();
+    return true;
+}
 
-    QJsonParseError err;
-    QJsonDocument doc = QJsonDocument::fromJson(ba, &err);
-    if (err.error != QJsonParseError::NoError) {
-        qWarning() << "JSON parse error:" << err.errorString();
+bool ReplayManager::parseWindow(const QString &spec, qint64 &fromUs, qint64 &toUs)
+{
+    const QString trimmed = spec.trimmed();
+    fromUs = 0;
+    toUs = -1;
+    if (trimmed.isEmpty())
+        return true;
+    const QStringList parts = trimmed.split('-');
+    if (parts.size() > 2)
         return false;
+    bool ok = true;
+    if (!parts.at(0).trimmed().isEmpty()) {
+        fromUs = static_cast<qint64>(parts.at(0).trimmed().toDouble(&ok) * 1e6);
+        if (!ok || fromUs < 0) return false;
+    }
+    if (parts.size() == 2 && !parts.at(1).trimmed().isEmpty()) {
+        toUs = static_cast<qint64>(parts.at(1).trimmed().toDouble(&ok) * 1e6);
+        if (!ok || toUs < fromUs) return false;
     }
-    if (!doc.isObject()) return false;
-    QJsonObject root = doc.object();
-    if (!root.contains("events") || !root.value("events").isArray()) return false;
-    m_events = root.value("events").toArray();
     return true;
 }
 
+void ReplayManager::setReplayWindow(qint64 fromUs, qint64 toUs)
+{
+    m_windowFromUs = std::max<qint64>(0, fromUs);
+    m_windowToUs = toUs;
+}
+
 bool ReplayManager::startReplay()
 {
     if (m_replaying) return false;
-    if (m_events.isEmpty()) return false;
+    if (m_events.empty() && m_manifest.segments.empty()) return false;
 
     stopReplay(); // 保证干净状态
 
     m_worker = new ReplayWorker();
-    m_worker->setEvents(m_events);
+    if (!m_manifest.segments.empty()) {
+        // 只交给 worker 与回放窗口重叠的段；未正常结束的段时间范围未知，总是读取
+        std::vector<QString> files;
+        std::vector<quint64> events;
+        for (const SegmentManifest::Segment &s : m_manifest.segments) {
+            if (s.complete && (s.endUs < m_windowFromUs || (m_windowToUs >= 0 && s.startUs > m_windowToUs)))
+                continue;
+            files.push_back(SegmentManifest::resolve(m_manifestPath, s.file));
+            events.push_back(s.events);
+        }
+        if (files.empty()) {
+            delete m_worker;
+            m_worker = nullptr;
+            return false;
+        }
+        const bool endsRecording = files.back() == SegmentManifest::resolve(m_manifestPath, m_manifest.segments.back().file);
+        m_worker->setSegments(files, events, endsRecording);
+    } else {
+        m_worker->setEvents(m_events);
+    }
+    m_worker->setWindow(m_windowFromUs, m_windowToUs);
     m_worker->setOptions(m_replayMouse, m_replayKeyboard);
     m_worker->setSpeedFactor(m_speed);
 
@@ -1,10 +1,12 @@
 #pragma once
 #include <QObject>
 #include <QThread>
-#include <QJsonArray>
 #include <QString>
 #include <QEventLoop>
 #include <QTimer>
+#include <vector>
+#include "inputevent.h"
+#include "segmentmanifest.h"
 
 class ReplayWorker;
 
@@ -14,7 +16,12 @@ class ReplayManager : public QObject
 public:
     static ReplayManager& instance();
 
-    bool loadReplayFile(const QString &path); // load json and store events
+    bool loadReplayFile(const QString &path); // load .json, .mkr, .mkrz or .mkj (detected by content), or a .mkrm segment manifest
+    bool isSegmented() const { return !m_manifest.segments.empty(); }
+    // 回放时间窗口（微秒，相对录制开始；toUs < 0 表示到结尾），对之后的 startReplay() 生效，重新加载文件时清除
+    void setReplayWindow(qint64 fromUs, qint64 toUs);
+    // 解析 "<起>-<止>"（秒，可为小数，任一端可省略；空字符串表示整个录制）
+    static bool parseWindow(const QString &spec, qint64 &fromUs, qint64 &toUs);
     bool startReplay();    // create worker/thread and start
     void stopReplay();
     void pauseReplay();
@@ -38,7 +45,12 @@ private:
     explicit ReplayManager(QObject* parent = nullptr);
     ~ReplayManager();
 
-    QJsonArray m_events;
+    std::vector<CapturedEvent> m_events;   // timestampNs 为相对录制开始的时间
+    // 分段录制：只保存清单，段文件回放时再读
+    SegmentManifest::Manifest m_manifest;
+    QString m_manifestPath;
+    qint64 m_windowFromUs = 0;
+    qint64 m_windowToUs = -1;
     QThread m_thread;
     ReplayWorker* m_worker = nullptr;
 
@@ -1,8 +1,11 @@
 #include "replayworker.h"
-#include <QJsonObject>
+#include "inputcodes.h"
+#include "recordreader.h"
 #include <QDebug>
 #include <QThread>
+#include <QElapsedTimer>
 #include <chrono>
+#include <numeric>
 
 #define NOMINMAX
 #ifdef Q_OS_WIN
@@ -21,11 +24,24 @@ ReplayWorker::~ReplayWorker()
     stopReplay();
 }
 
-void ReplayWorker::setEvents(const QJsonArray &events)
+void ReplayWorker::setEvents(const std::vector<CapturedEvent> &events)
 {
     m_events = events;
 }
 
+void ReplayWorker::setSegments(const std::vector<QString> &files, const std::vector<quint64> &segmentEvents, bool endsRecording)
+{
+    m_segments = files;
+    m_segmentEvents = segmentEvents;
+    m_endsRecording = endsRecording;
+}
+
+void ReplayWorker::setWindow(qint64 fromUs, qint64 toUs)
+{
+    m_fromUs = fromUs;
+    m_toUs = toUs;
+}
+
 void ReplayWorker::setOptions(bool replayMouse, bool replayKeyboard)
 {
     m_replayMouse = replayMouse;
@@ -44,17 +60,11 @@ void ReplayWorker::stopReplay()
 {
     qDebug() << "[ReplayWorker] Stop requested by manager.";
 
-    m_stopRequested.store(true);
-
-    {
-        QMutexLocker locker(&m_pauseMutex);
-        m_paused.store(false);
-        m_pauseCond.wakeAll();
-    }
-
-    // 唤醒 sleep 等待
+    // 持锁修改标志再唤醒：回放线程的等待没有超时兜底，不能错过这次唤醒
     {
         QMutexLocker locker(&m_waitMutex);
+        m_stopRequested.store(true);
+        m_paused.store(false);
         m_waitCond.wakeAll();
     }
 
@@ -64,7 +74,11 @@ void ReplayWorker::stopReplay()
 void ReplayWorker::pauseReplay()
 {
     if (!m_paused.load()) {
-        m_paused.store(true);
+        {
+            QMutexLocker locker(&m_waitMutex);
+            m_paused.store(true);
+            m_waitCond.wakeAll();
+        }
         emit stateChanged("paused");
         qDebug() << "[ReplayWorker] Paused.";
     }
@@ -73,9 +87,11 @@ void ReplayWorker::pauseReplay()
 void ReplayWorker::resumeReplay()
 {
     if (m_paused.load()) {
-        QMutexLocker locker(&m_pauseMutex);
-        m_paused.store(false);
-        m_pauseCond.wakeAll();
+        {
+            QMutexLocker locker(&m_waitMutex);
+            m_paused.store(false);
+            m_waitCond.wakeAll();
+        }
         emit stateChanged("resumed");
         qDebug() << "[ReplayWorker] Resumed.";
     }
@@ -83,94 +99,177 @@ void ReplayWorker::resumeReplay()
 
 void ReplayWorker::startReplay()
 {
-    if (m_events.isEmpty()) {
+    if (m_events.empty() && m_segments.empty()) {
         qDebug() << "[ReplayWorker] No events loaded, finish immediately.";
         emit stateChanged("finished");
         emit finished();
         return;
     }
 
-    qDebug() << "[ReplayWorker] Start replaying with" << m_events.size() << "events";
+    if (m_segments.empty())
+        qDebug() << "[ReplayWorker] Start replaying with" << m_events.size() << "events";
+    else
+        qDebug() << "[ReplayWorker] Start replaying" << m_segments.size() << "segments,"
+                 << std::accumulate(m_segmentEvents.begin(), m_segmentEvents.end(), quint64(0)) << "events";
     m_stopRequested.store(false);
     runLoop();
 }
 
-void ReplayWorker::runLoop()
+// 等待 waitMs 毫秒后返回 true。暂停时无超时地等到继续或停止，暂停的时长不计入；
+// 除到时、暂停/继续、停止之外线程不会醒来（虚假唤醒按剩余时间继续等）
+bool ReplayWorker::waitFor(qint64 waitMs)
 {
-    const int total = m_events.size()-2;
-    qint64 last_ts = 0;
+    QElapsedTimer timer;
+    timer.start();
+    qint64 remaining = waitMs;
 
-    // 已经更新：不再回放操作的最后两个事件（按下左键和松开左键），也就是结束录制这一步，不会被回放，避免在回放过程中的误触。
-    for (int i = 0; i < total; ++i)
-    {
-        // 立即检查 stop
-        if (m_stopRequested.load()) {
-            qDebug() << "[ReplayWorker] Stop flag detected (begin loop).";
-            break;
+    QMutexLocker locker(&m_waitMutex);
+    while (!m_stopRequested.load()) {
+        if (m_paused.load()) {
+            m_waitCond.wait(&m_waitMutex);
+            timer.restart();
+            continue;
         }
+        if (remaining <= 0)
+            return true;
+        m_waitCond.wait(&m_waitMutex, static_cast<unsigned long>(remaining));
+        remaining -= timer.restart();
+    }
+    return false;
+}
 
-        // 处理 pause
-        if (m_paused.load()) {
-            QMutexLocker locker(&m_pauseMutex);
-            while (m_paused.load() && !m_stopRequested.load()) {
-                m_pauseCond.wait(&m_pauseMutex, 50);
+void ReplayWorker::prefetchSegment()
+{
+    if (m_nextSegment >= m_segments.size())
+        return;
+    const QString file = m_segments[m_nextSegment++];
+    m_prefetch = std::async(std::launch::async, [file]() {
+        std::vector<CapturedEvent> events;
+        QString error;
+        if (!RecordReader::readFile(file, events, &error))
+            qWarning() << "[ReplayWorker] Skip segment" << file << ":" << error;
+        return events;
+    });
+}
+
+bool ReplayWorker::nextSegment()
+{
+    if (!m_prefetch.valid())
+        return false;
+    m_events = m_prefetch.get();
+    prefetchSegment();
+    return true;
+}
+
+void ReplayWorker::runLoop()
+{
+    const bool segmented = !m_segments.empty();
+    if (segmented) {
+        m_nextSegment = 0;
+        prefetchSegment();
+        nextSegment();
+    }
+
+    // 进度总数：单文件数出窗口内的事件；分段录制先用清单里各段的事件数，
+    // 每读入一段再换成该段落在窗口内的实际事件数（窗口两端的段只有一部分在窗口内）
+    int total = 0;
+    if (segmented) {
+        for (quint64 events : m_segmentEvents)
+            total += static_cast<int>(events);
+    } else {
+        for (const CapturedEvent &evt : m_events) {
+            const qint64 ts = evt.timestampNs() / 1000;
+            if (ts >= m_fromUs && (m_toUs < 0 || ts <= m_toUs))
+                ++total;
+        }
+    }
+    if (m_endsRecording)
+        total -= 2;
+
+    qint64 last_ts = m_fromUs;   // 第一个事件从窗口开始（默认即录制开始）起计时
+    qint64 carryUs = 0;   // 不足 1ms 的等待时间累积到下一个事件，避免长时间回放的时序漂移
+    int current = 0;
+    bool windowEnded = false;
+    std::size_t segment = 0;
+
+    for (;;) {
+        const bool lastChunk = !segmented || !m_prefetch.valid();
+        // 已经更新：不再回放操作的最后两个事件（按下左键和松开左键），也就是结束录制这一步，不会被回放，避免在回放过程中的误触。
+        std::size_t count = m_events.size();
+        if (lastChunk && m_endsRecording)
+            count = count > 2 ? count - 2 : 0;
+
+        if (segmented) {
+            int inWindow = 0;
+            for (std::size_t i = 0; i < count; ++i) {
+                const qint64 ts = m_events[i].timestampNs() / 1000;
+                if (ts >= m_fromUs && (m_toUs < 0 || ts <= m_toUs))
+                    ++inWindow;
             }
+            // 清单里的数目包含结束录制的两个事件，上面已从 total 里减掉
+            const int estimate = static_cast<int>(segment < m_segmentEvents.size() ? m_segmentEvents[segment] : 0)
+                               - ((lastChunk && m_endsRecording) ? 2 : 0);
+            total += inWindow - estimate;
+            ++segment;
+        }
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            // 立即检查 stop
             if (m_stopRequested.load()) {
-                qDebug() << "[ReplayWorker] Stop detected during pause.";
+                qDebug() << "[ReplayWorker] Stop flag detected (begin loop).";
                 break;
             }
-        }
 
-        // 取事件
-        QJsonObject evt = m_events.at(i).toObject();
-        qint64 ts = evt.value("timestamp_ms").toVariant().toLongLong();
-        qint64 delta = (i == 0) ? ts : (ts - last_ts);
-        last_ts = ts;
-
-        // 延时计算（支持倍速）
-        double speed = m_speed.load();
-        if (speed <= 0.0) speed = 1.0;
-        qint64 waitMs = static_cast<qint64>(delta / speed);
-
-        // 分片 sleep + 可中断等待
-        qint64 slept = 0;
-        const qint64 slice = 50;
-        while (slept < waitMs) {
-            if (m_stopRequested.load() || m_paused.load())
+            // 取事件
+            const CapturedEvent &evt = m_events[i];
+            qint64 ts = evt.timestampNs() / 1000;
+            if (ts < m_fromUs)
+                continue;
+            if (m_toUs >= 0 && ts > m_toUs) {
+                windowEnded = true;
                 break;
-
-            qint64 remain = waitMs - slept;
-            qint64 toWait = std::min(remain, slice);
-
-            QMutexLocker locker(&m_waitMutex);
-            m_waitCond.wait(&m_waitMutex, static_cast<unsigned long>(toWait));
-
-            if (m_stopRequested.load() || m_paused.load())
+            }
+            qint64 delta = ts - last_ts;
+            last_ts = ts;
+
+            // 延时计算（支持倍速），录制精度为微秒，等待精度为毫秒
+            double speed = m_speed.load();
+            if (speed <= 0.0) speed = 1.0;
+            qint64 waitUs = static_cast<qint64>(delta / speed) + carryUs;
+            qint64 waitMs = waitUs / 1000;
+            carryUs = waitUs - waitMs * 1000;
+
+            // 可中断等待（也处理暂停）：暂停发生在等待期间时，继续后等完剩余时间再执行这个事件，不会跳过它
+            if (!waitFor(waitMs)) {
+                qDebug() << "[ReplayWorker] Stop detected while waiting.";
                 break;
+            }
 
-            slept += toWait;
-        }
-
-        if (m_stopRequested.load()) {
-            qDebug() << "[ReplayWorker] Stop detected after sleep.";
-            break;
-        }
-
-        if (m_paused.load()) continue;
+            // 执行事件（带二次检查）
+            if (m_stopRequested.load()) break;
 
-        // 执行事件（带二次检查）
-        if (m_stopRequested.load()) break;
+            bool doMouse = (m_replayMouse && evt.category == InputCategory::Mouse);
+            bool doKey   = (m_replayKeyboard && evt.category == InputCategory::Keyboard);
 
-        QString cat = evt.value("category").toString();
-        bool doMouse = (m_replayMouse && cat == "mouse");
-        bool doKey   = (m_replayKeyboard && cat == "keyboard");
+            if ((doMouse || doKey) && !m_stopRequested.load()) {
+                simulateEvent(evt);
+            }
 
-        if ((doMouse || doKey) && !m_stopRequested.load()) {
-            simulateEvent(evt);
+            emit replayProgress(++current, total);
         }
 
-        emit replayProgress(i + 1, total);
+        // 下一段通常已在当前段回放期间读好，段与段之间不会停顿
+        if (m_stopRequested.load() || windowEnded || lastChunk || !nextSegment())
+            break;
     }
+    // 窗口在中途结束时，后面各段仍按清单估计计在 total 里，正常结束时把进度补满
+    if (!m_stopRequested.load() && current != total)
+        emit replayProgress(current, current);
+
+    // 停止时等后台预读结束，不让它在 worker 销毁后继续运行
+    if (m_prefetch.valid())
+        m_prefetch.wait();
 
     QString finalState = m_stopRequested.load() ? "stopped" : "finished";
     qDebug() << "[ReplayWorker] Replay loop exited with state:" << finalState;
@@ -178,18 +277,34 @@ void ReplayWorker::runLoop()
     emit finished();
 }
 
-void ReplayWorker::simulateEvent(const QJsonObject &evt)
+void ReplayWorker::simulateEvent(const CapturedEvent &evt)
 {
     if (m_stopRequested.load()) return;
 
 #ifdef Q_OS_WIN
-    QString cat = evt.value("category").toString();
-    if (cat == "mouse") {
-        int x = evt.value("x").toInt();
-        int y = evt.value("y").toInt();
-        int type = evt.value("type").toInt();
+    if (evt.category == InputCategory::Mouse) {
+        int x = evt.mouse.x;
+        int y = evt.mouse.y;
+        int type = static_cast<int>(evt.mouse.type);
 
         if (m_stopRequested.load()) return;
+
+        // 相对运动：按原始位移/滚动量重新注入，不设置光标绝对位置（x/y 为位移，滚轮的 x 为滚动量）
+        if (InputCode::isRelative(static_cast<quint32>(type))) {
+            INPUT rel; ZeroMemory(&rel, sizeof(rel));
+            rel.type = INPUT_MOUSE;
+            if (type == static_cast<int>(InputCode::RawMotion)) {
+                rel.mi.dx = x;
+                rel.mi.dy = y;
+                rel.mi.dwFlags = MOUSEEVENTF_MOVE;
+            } else {
+                rel.mi.mouseData = static_cast<DWORD>(x);
+                rel.mi.dwFlags = (type == static_cast<int>(InputCode::RawWheel)) ? MOUSEEVENTF_WHEEL : MOUSEEVENTF_HWHEEL;
+            }
+            if (!m_stopRequested.load()) SendInput(1, &rel, sizeof(rel));
+            return;
+        }
+
         SetCursorPos(x, y);
 
         INPUT in; ZeroMemory(&in, sizeof(in));
@@ -202,9 +317,9 @@ void ReplayWorker::simulateEvent(const QJsonObject &evt)
 
         if (!m_stopRequested.load()) SendInput(1, &in, sizeof(in));
     }
-    else if (cat == "keyboard") {
-        int vk = evt.value("vkCode").toInt();
-        bool down = evt.value("keyDown").toBool();
+    else {
+        int vk = static_cast<int>(evt.key.vkCode);
+        bool down = evt.key.keyDown;
         if (m_stopRequested.load()) return;
 
         INPUT in; ZeroMemory(&in, sizeof(in));
@@ -3,17 +3,23 @@
 
 #pragma once
 #include <QObject>
-#include <QJsonArray>
 #include <QMutex>
 #include <QWaitCondition>
 #include <atomic>
+#include <future>
+#include <vector>
+#include "inputevent.h"
 
 /*
  * ReplayWorker（线程内执行的对象）
  * ---------------------------------------------------------
  * - 支持即停即止（stopReplay 立刻唤醒所有 wait/sleep）
- * - 支持暂停/继续
+ * - 支持暂停/继续（暂停期间不计入事件间隔，继续后补足剩余等待）
+ * - 等待事件间隔和暂停都是一次无分片的条件等待，只在到时、暂停/继续、停止时醒来
  * - 支持倍速播放
+ * - 事件为 POD（CapturedEvent，timestampNs 为相对录制开始的时间），各种录制文件都由 RecordReader 解码成这种形式
+ * - 分段录制逐段读取：回放当前段时在后台线程预读下一段，段与段之间的时序连续，内存中最多两段
+ * - 可只回放一个时间窗口，窗口之前的事件跳过，第一个事件从窗口开始起计时
  * - 信号：
  *     replayProgress(int current, int total)
  *     stateChanged(QString)
@@ -27,7 +33,11 @@ public:
     explicit ReplayWorker(QObject *parent = nullptr);
     ~ReplayWorker();
 
-    void setEvents(const QJsonArray &events);
+    void setEvents(const std::vector<CapturedEvent> &events);
+    // 分段录制：按顺序回放这些段文件；segmentEvents 是清单里各段的事件数（进度的初始估计），
+    // endsRecording 表示最后一段是整个录制的最后一段
+    void setSegments(const std::vector<QString> &files, const std::vector<quint64> &segmentEvents, bool endsRecording);
+    void setWindow(qint64 fromUs, qint64 toUs);   // 微秒，toUs < 0 表示到结尾
     void setOptions(bool replayMouse, bool replayKeyboard);
 
 public slots:
@@ -44,10 +54,20 @@ signals:
 
 private:
     void runLoop();
-    void simulateEvent(const QJsonObject &evt);
+    bool waitFor(qint64 waitMs);   // 返回 false 表示已请求停止
+    void simulateEvent(const CapturedEvent &evt);
+    void prefetchSegment();   // 在后台线程读取下一段
+    bool nextSegment();       // 取出预读的段放进 m_events，并开始预读再下一段
 
 private:
-    QJsonArray m_events;
+    std::vector<CapturedEvent> m_events;   // 单文件回放的全部事件，或分段回放的当前段
+    std::vector<QString> m_segments;
+    std::size_t m_nextSegment = 0;
+    std::future<std::vector<CapturedEvent>> m_prefetch;
+    std::vector<quint64> m_segmentEvents;
+    bool m_endsRecording = true;
+    qint64 m_fromUs = 0;
+    qint64 m_toUs = -1;
     bool m_replayMouse = true;
     bool m_replayKeyboard = true;
 
@@ -55,11 +75,9 @@ private:
     std::atomic<bool> m_paused{false};
     std::atomic<double> m_speed{1.0};
 
-    QMutex m_pauseMutex;
-    QWaitCondition m_pauseCond;
-
-    QMutex m_waitMutex;        // 用于 sleep 的中断等待
-    QWaitCondition m_waitCond; // 可被 stopReplay() 唤醒
+    // 事件间隔和暂停共用一个等待：stop/pause/resume 持锁修改标志后唤醒
+    QMutex m_waitMutex;
+    QWaitCondition m_waitCond;
 };
 
 #endif // REPLAYWORKER_H
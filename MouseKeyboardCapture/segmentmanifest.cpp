@@ -0,0 +1,113 @@
+#include "segmentmanifest.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace SegmentManifest {
+
+quint64 Manifest::events() const
+{
+    quint64 n = 0;
+    for (const Segment& s : segments)
+        n += s.events;
+    return n;
+}
+
+bool isManifestPath(const QString& path)
+{
+    return QFileInfo(path).suffix().compare("mkrm", Qt::CaseInsensitive) == 0;
+}
+
+QString manifestPath(const QString& recordPath)
+{
+    const QFileInfo info(recordPath);
+    return info.dir().filePath(info.completeBaseName() + ".mkrm");
+}
+
+QString segmentPath(const QString& recordPath, int index)
+{
+    const QFileInfo info(recordPath);
+    return info.dir().filePath(QString("%1.%2.%3").arg(info.completeBaseName())
+                               .arg(index, 3, 10, QChar('0')).arg(info.suffix()));
+}
+
+QString resolve(const QString& manifestPath, const QString& file)
+{
+    return QFileInfo(manifestPath).dir().filePath(file);
+}
+
+bool save(const QString& path, const Manifest& manifest, QString* error)
+{
+    QJsonArray segments;
+    for (const Segment& s : manifest.segments) {
+        QJsonObject o;
+        o["file"] = s.file;
+        o["start_us"] = s.startUs;
+        o["end_us"] = s.endUs;
+        o["events"] = static_cast<qint64>(s.events);
+        o["bytes"] = s.bytes;
+        o["offset"] = s.offset;
+        o["complete"] = s.complete;
+        segments.append(o);
+    }
+    QJsonObject root;
+    root["version"] = kVersion;
+    root["record_start_time"] = manifest.recordStartTime;
+    root["time_unit"] = "us";
+    root["complete"] = manifest.complete;
+    root["events"] = static_cast<qint64>(manifest.events());
+    root["segments"] = segments;
+
+    // 先写临时文件再替换，任何时刻磁盘上都是一份完整的清单
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(QJsonDocument(root).toJson()) < 0
+        || !file.commit()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool load(const QString& path, Manifest& manifest, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    QJsonParseError err;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &err);
+    if (err.error != QJsonParseError::NoError || !doc.isObject()) {
+        if (error) *error = QString("manifest parse error: %1").arg(err.errorString());
+        return false;
+    }
+    const QJsonObject root = doc.object();
+    if (root.value("version").toInt() != kVersion) {
+        if (error) *error = QString("unsupported manifest version %1").arg(root.value("version").toInt());
+        return false;
+    }
+
+    manifest = Manifest();
+    manifest.recordStartTime = root.value("record_start_time").toString();
+    manifest.complete = root.value("complete").toBool();
+    for (const QJsonValue& v : root.value("segments").toArray()) {
+        const QJsonObject o = v.toObject();
+        Segment s;
+        s.file = o.value("file").toString();
+        s.startUs = o.value("start_us").toVariant().toLongLong();
+        s.endUs = o.value("end_us").toVariant().toLongLong();
+        s.events = o.value("events").toVariant().toULongLong();
+        s.bytes = o.value("bytes").toVariant().toLongLong();
+        s.offset = o.value("offset").toVariant().toLongLong();
+        s.complete = o.value("complete").toBool();
+        manifest.segments.push_back(s);
+    }
+    return true;
+}
+
+} // namespace SegmentManifest
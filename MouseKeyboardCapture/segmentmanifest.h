@@ -0,0 +1,62 @@
+#ifndef SEGMENTMANIFEST_H
+#define SEGMENTMANIFEST_H
+
+#include <QString>
+#include <vector>
+
+/**
+ * @brief 分段录制与清单文件（.mkrm）
+ *
+ * 开启分段后，录制 "day.mkj" 实际写出 day.000.mkj、day.001.mkj……每段都是完整、可单独打开的录制文件
+ * （格式由扩展名决定，时间戳仍相对整次录制的开始时刻），另写一个 JSON 清单 day.mkrm：
+ *
+ *   { "version": 1, "record_start_time": "...", "time_unit": "us", "complete": true, "events": 123,
+ *     "segments": [ { "file": "day.000.mkj", "start_us": 0, "end_us": 3600000000,
+ *                     "events": 100, "bytes": 4096, "offset": 0, "complete": true }, ... ] }
+ *
+ * offset 为该段在整个会话中的字节偏移（之前各段文件大小之和）。清单在每段开始和结束时用 QSaveFile 原子替换，
+ * 崩溃后清单里正在写的那一段 complete 为 false，它的时间范围和事件数由读取方从段文件本身得出。
+ */
+namespace SegmentManifest {
+
+constexpr int kVersion = 1;
+
+// 任一条件满足就在下一个批次边界换到新的一段；都为 0 表示不分段
+struct Config {
+    qint64 maxBytes = 0;      // 每段写出的 .mkr / JSON 字节数（压缩、分帧之前）
+    int maxSeconds = 0;       // 每段第一个到最后一个事件的时间跨度
+    bool enabled() const { return maxBytes > 0 || maxSeconds > 0; }
+};
+
+struct Segment {
+    QString file;             // 文件名，相对清单所在目录
+    qint64 startUs = 0;       // 第一个事件的时间戳（相对录制开始）
+    qint64 endUs = 0;         // 最后一个事件的时间戳
+    quint64 events = 0;
+    qint64 bytes = 0;         // 段文件大小
+    qint64 offset = 0;
+    bool complete = false;
+};
+
+struct Manifest {
+    QString recordStartTime;
+    bool complete = false;    // 录制正常结束
+    std::vector<Segment> segments;
+
+    quint64 events() const;
+};
+
+bool isManifestPath(const QString& path);   // .mkrm
+// day.mkj -> day.mkrm
+QString manifestPath(const QString& recordPath);
+// day.mkj, 3 -> day.003.mkj
+QString segmentPath(const QString& recordPath, int index);
+// 清单中的文件名相对清单所在目录
+QString resolve(const QString& manifestPath, const QString& file);
+
+bool save(const QString& path, const Manifest& manifest, QString* error = nullptr);
+bool load(const QString& path, Manifest& manifest, QString* error = nullptr);
+
+} // namespace SegmentManifest
+
+#endif // SEGMENTMANIFEST_H
@@ -0,0 +1,121 @@
+#include "sinkfanout.h"
+#include <QDebug>
+
+SinkFanout::SinkFanout(qint64 maxQueuedBytes)
+    : maxQueuedBytes_(maxQueuedBytes)
+{
+}
+
+SinkFanout::~SinkFanout()
+{
+    stop();
+}
+
+void SinkFanout::add(std::shared_ptr<RecordSink> sink)
+{
+    std::unique_ptr<Tap> tap(new Tap);
+    tap->stats.name = sink->name();
+    tap->sink = std::move(sink);
+    taps_.push_back(std::move(tap));
+}
+
+void SinkFanout::start()
+{
+    for (const std::unique_ptr<Tap>& tap : taps_) {
+        if (!tap->thread.joinable())
+            tap->thread = std::thread(&SinkFanout::tapLoop, this, tap.get());
+    }
+}
+
+void SinkFanout::publishHeader(const char* data, qint64 size)
+{
+    if (haveHeader_ || taps_.empty())
+        return;
+    haveHeader_ = true;
+    enqueue(QByteArray(data, static_cast<int>(size)), true);
+}
+
+void SinkFanout::publish(const char* data, qint64 size)
+{
+    if (taps_.empty() || size <= 0)
+        return;
+    // 唯一的一次拷贝，之后各队列只增加引用计数
+    enqueue(QByteArray(data, static_cast<int>(size)), false);
+}
+
+void SinkFanout::enqueue(const QByteArray& batch, bool header)
+{
+    for (const std::unique_ptr<Tap>& tap : taps_) {
+        {
+            std::lock_guard<std::mutex> lock(tap->mutex);
+            if (tap->stats.failed)
+                continue;
+            if (!header && tap->queuedBytes + batch.size() > maxQueuedBytes_) {
+                ++tap->stats.dropped;
+                continue;
+            }
+            tap->queue.push_back(batch);
+            tap->queuedBytes += batch.size();
+        }
+        tap->cv.notify_one();
+    }
+}
+
+void SinkFanout::tapLoop(Tap* tap)
+{
+    RecordSink& sink = *tap->sink;
+    bool ok = sink.open();
+    if (!ok)
+        qWarning() << "SinkFanout: 无法打开" << sink.name();
+
+    std::unique_lock<std::mutex> lock(tap->mutex);
+    tap->stats.failed = !ok;
+    for (;;) {
+        tap->cv.wait(lock, [tap] { return tap->stopping || !tap->queue.empty(); });
+        if (tap->queue.empty())
+            break;
+        const QByteArray batch = std::move(tap->queue.front());
+        tap->queue.pop_front();
+        tap->queuedBytes -= batch.size();
+        if (tap->stats.failed)
+            continue;
+
+        lock.unlock();
+        ok = sink.writeBuffer(batch);
+        lock.lock();
+        if (!ok) {
+            qWarning() << "SinkFanout: 写入失败，不再向它分发" << sink.name();
+            tap->stats.failed = true;
+            continue;
+        }
+        ++tap->stats.batches;
+        tap->stats.bytes += static_cast<quint64>(batch.size());
+    }
+    lock.unlock();
+    sink.close();
+}
+
+void SinkFanout::stop()
+{
+    for (const std::unique_ptr<Tap>& tap : taps_) {
+        {
+            std::lock_guard<std::mutex> lock(tap->mutex);
+            tap->stopping = true;
+        }
+        tap->cv.notify_one();
+    }
+    for (const std::unique_ptr<Tap>& tap : taps_) {
+        if (tap->thread.joinable())
+            tap->thread.join();
+    }
+}
+
+std::vector<SinkFanout::TapStats> SinkFanout::stats() const
+{
+    std::vector<TapStats> out;
+    for (const std::unique_ptr<Tap>& tap : taps_) {
+        std::lock_guard<std::mutex> lock(tap->mutex);
+        out.push_back(tap->stats);
+    }
+    return out;
+}
@@ -0,0 +1,75 @@
+#ifndef SINKFANOUT_H
+#define SINKFANOUT_H
+
+#include <QByteArray>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "recordsink.h"
+
+/**
+ * @brief 把录制的字节流同时分发给多个旁路 sink（实时流 LiveStreamSink、最近 N 分钟 RecentRingSink……）
+ *
+ * 录制文件仍由 RecorderWorker 在自己的线程上写出（不能丢，跟不上时由 Lossless 订阅积压）；
+ * 旁路 sink 各有一个线程和一个有上限的队列。每个批次只序列化一次，publish() 把它拷贝成一个 QByteArray，
+ * 所有队列共享这一份数据（隐式共享，引用计数），最后一个 sink 写完后才释放。
+ *
+ * 慢的 sink 只影响它自己：队列超过 maxQueuedBytes 时新的批次对它直接丢弃（计入 dropped），
+ * 录制线程和其它 sink 都不等待。RecorderWorker 在每个批次开头写一条 RecordFormat::Sync 记录，
+ * 丢掉批次或中途接入后，从任意批次开始都能解码。
+ *
+ * 约定：交给每个 sink 的第一个批次是文件头（publishHeader，不会被丢弃）；
+ * 分段录制换段时的文件头不再转发，旁路输出始终是一条连续的流。
+ */
+class SinkFanout
+{
+public:
+    struct TapStats {
+        QString name;
+        quint64 batches = 0;
+        quint64 bytes = 0;
+        quint64 dropped = 0;     // 队列满而丢弃的批次
+        bool failed = false;     // 打开或写入失败，之后的批次全部丢弃
+    };
+
+    explicit SinkFanout(qint64 maxQueuedBytes = 16 * 1024 * 1024);
+    ~SinkFanout();
+
+    // 在 start() 之前添加
+    void add(std::shared_ptr<RecordSink> sink);
+    bool empty() const { return taps_.empty(); }
+
+    // 每个 sink 启动自己的线程并在其中 open()
+    void start();
+    void publishHeader(const char* data, qint64 size);
+    void publish(const char* data, qint64 size);
+    // 写完已排队的批次后在各自线程中 close()
+    void stop();
+
+    std::vector<TapStats> stats() const;
+
+private:
+    struct Tap {
+        std::shared_ptr<RecordSink> sink;
+        std::thread thread;
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<QByteArray> queue;
+        qint64 queuedBytes = 0;
+        bool stopping = false;
+        TapStats stats;
+    };
+
+    void enqueue(const QByteArray& batch, bool header);
+    void tapLoop(Tap* tap);
+
+private:
+    qint64 maxQueuedBytes_;
+    std::vector<std::unique_ptr<Tap>> taps_;
+    bool haveHeader_ = false;
+};
+
+#endif // SINKFANOUT_H
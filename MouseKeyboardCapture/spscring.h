@@ -0,0 +1,112 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+/**
+ * @brief 单生产者/单消费者无锁环形队列（固定容量）
+ *
+ * - 生产者（钩子回调线程）只写 head_，消费者（CaptureEngine 工作线程）只写 tail_；
+ * - head_/tail_ 各自独占一个缓存行，避免两个线程互相踢掉对方的缓存行（false sharing）；
+ * - 存储区在对象内部静态分配，push/pop 不加锁、不分配堆内存；
+ * - Capacity 必须是 2 的幂，下标用掩码取模。
+ *
+ * 仅限一个线程调用 tryPush，一个线程调用 tryPop / front / popFront，否则行为未定义；size() / empty() 任意线程可调用。
+ */
+
+// 缓存行大小，MSVC2017 / 旧版 libstdc++ 未必提供 hardware_destructive_interference_size，直接固定为 64
+static constexpr std::size_t kCacheLineSize = 64;
+
+template <typename T, std::size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SpscRing element must be trivially copyable");
+
+public:
+    SpscRing() = default;
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    static constexpr std::size_t capacity() { return Capacity; }
+
+    // 生产者调用：队列已满时返回 false（由调用方计数丢弃），绝不阻塞
+    bool tryPush(const T& value)
+    {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cachedTail_ >= Capacity) {
+            // 缓存的 tail 可能过期，重新读取一次消费者位置
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head - cachedTail_ >= Capacity)
+                return false;
+        }
+        slots_[head & kMask] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者调用：队列为空时返回 false
+    bool tryPop(T& out)
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cachedHead_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail == cachedHead_)
+                return false;
+        }
+        out = slots_[tail & kMask];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者调用：查看队首元素但不出队（用于多路按时间戳归并），队列为空时返回 nullptr
+    const T* front()
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cachedHead_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail == cachedHead_)
+                return nullptr;
+        }
+        return &slots_[tail & kMask];
+    }
+
+    // 消费者调用：丢弃 front() 返回的元素
+    void popFront()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // 任意线程调用均可，结果只是近似值（用于唤醒判断和统计）。
+    // 先读 tail 再读 head：tail 只会追上之前读到的 head，这样 head - tail 不会回绕成巨大的值；
+    // 第三个线程读到的值仍可能过期，按容量截断
+    std::size_t size() const
+    {
+        const std::size_t tail = tail_.load(std::memory_order_acquire);
+        const std::size_t head = head_.load(std::memory_order_acquire);
+        const std::size_t n = head - tail;
+        return n > Capacity ? Capacity : n;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    static constexpr std::size_t kMask = Capacity - 1;
+
+    // 生产者独占的缓存行：写位置 + 对消费者位置的本地缓存
+    alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+    std::size_t cachedTail_ = 0;
+
+    // 消费者独占的缓存行：读位置 + 对生产者位置的本地缓存
+    alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+    std::size_t cachedHead_ = 0;
+
+    alignas(kCacheLineSize) T slots_[Capacity];
+};
+
+#endif // SPSCRING_H
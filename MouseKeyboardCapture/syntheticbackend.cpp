@@ -0,0 +1,227 @@
+#include "syntheticbackend.h"
+#include "captureengine.h"
+#include "inputcodes.h"
+#include <QStringList>
+#include <QDebug>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+
+// 每轮最多连续生成的事件数，之后回到外层检查 stop 标志并重新对齐节拍
+static constexpr quint64 kMaxChunk = 4096;
+
+namespace {
+
+// 事件流生成器：同一个种子总是生成同一串事件
+class EventGenerator
+{
+public:
+    EventGenerator(SyntheticBackend::Workload workload, quint32 seed, bool relative)
+        : workload_(workload), rng_(seed), relative_(relative) {}
+
+    void emitNext(CaptureEngine& engine, qint64 ts)
+    {
+        switch (workload_) {
+        case SyntheticBackend::Workload::MouseMove:   emitMove(engine, ts); break;
+        case SyntheticBackend::Workload::TypingBurst: emitKey(engine, ts); break;
+        case SyntheticBackend::Workload::ClickStorm:  emitClick(engine, ts); break;
+        case SyntheticBackend::Workload::Mixed:       emitMixed(engine, ts); break;
+        case SyntheticBackend::Workload::Idle:        break;
+        }
+    }
+
+private:
+    void emitMove(CaptureEngine& engine, qint64 ts)
+    {
+        // 以屏幕中心为圆心匀速画圆，每 1000 个点一圈
+        // 相对运动模式下发出与上一个点的位移，回放累加后与绝对坐标的轨迹一致
+        angle_ += 2.0 * 3.14159265358979 / 1000.0;
+        const qint32 x = 960 + static_cast<qint32>(std::lround(300.0 * std::cos(angle_)));
+        const qint32 y = 540 + static_cast<qint32>(std::lround(300.0 * std::sin(angle_)));
+        if (relative_)
+            engine.enqueueMouseEvent(MouseEventData{ x - x_, y - y_, InputCode::RawMotion, 0, 0, ts });
+        else
+            engine.enqueueMouseEvent(MouseEventData{ x, y, InputCode::MouseMove, 0, 0, ts });
+        x_ = x;
+        y_ = y;
+    }
+
+    void emitKey(CaptureEngine& engine, qint64 ts)
+    {
+        // 按下和抬起成对出现，抬起的一定是上一次按下的键
+        if (!keyDown_)
+            vk_ = 'A' + static_cast<quint32>(rng_() % 26);
+        keyDown_ = !keyDown_;
+        engine.enqueueKeyEvent(KeyEventData{ vk_, keyDown_, 0, 0, ts });
+    }
+
+    void emitClick(CaptureEngine& engine, qint64 ts)
+    {
+        buttonDown_ = !buttonDown_;
+        const quint32 type = buttonDown_ ? InputCode::LeftDown : InputCode::LeftUp;
+        engine.enqueueMouseEvent(MouseEventData{ x_, y_, type, 0, 0, ts });
+    }
+
+    void emitMixed(CaptureEngine& engine, qint64 ts)
+    {
+        // 未配对的按下先补上抬起，保证录制结果可以正常回放
+        if (keyDown_) { emitKey(engine, ts); return; }
+        if (buttonDown_) { emitClick(engine, ts); return; }
+
+        const quint32 roll = rng_() % 100;
+        if (roll < 90)      emitMove(engine, ts);
+        else if (roll < 95) emitKey(engine, ts);
+        else                emitClick(engine, ts);
+    }
+
+private:
+    SyntheticBackend::Workload workload_;
+    std::mt19937 rng_;
+    bool relative_;
+    double angle_ = 0.0;
+    qint32 x_ = 960;
+    qint32 y_ = 540;
+    quint32 vk_ = 'A';
+    bool keyDown_ = false;
+    bool buttonDown_ = false;
+};
+
+} // namespace
+
+SyntheticBackend::SyntheticBackend(const Config& config)
+    : config_(config)
+{
+    if (config_.rateHz <= 0.0)
+        config_.rateHz = 1000.0;
+}
+
+SyntheticBackend::~SyntheticBackend()
+{
+    stop();
+}
+
+bool SyntheticBackend::parseSpec(const QString& spec, Config& out)
+{
+    const QStringList parts = spec.split(':');
+    const QString kind = parts.value(0).trimmed().toLower();
+    if (kind == "move")        out.workload = Workload::MouseMove;
+    else if (kind == "typing") out.workload = Workload::TypingBurst;
+    else if (kind == "click")  out.workload = Workload::ClickStorm;
+    else if (kind == "mixed")  out.workload = Workload::Mixed;
+    else if (kind == "idle")   out.workload = Workload::Idle;
+    else return false;
+
+    bool ok = true;
+    if (parts.size() > 1) {
+        out.rateHz = parts.at(1).toDouble(&ok);
+        if (!ok || out.rateHz <= 0.0) return false;
+    }
+    if (parts.size() > 2) {
+        out.durationMs = static_cast<int>(parts.at(2).toDouble(&ok) * 1000.0);
+        if (!ok || out.durationMs < 0) return false;
+    }
+    return true;
+}
+
+bool SyntheticBackend::start(CaptureEngine& engine)
+{
+    if (thread_.joinable()) return true;
+
+    engine_ = &engine;
+    stopRequested_ = false;
+    finished_ = false;
+    generated_ = 0;
+    thread_ = std::thread(&SyntheticBackend::generateLoop, this);
+    return true;
+}
+
+void SyntheticBackend::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        stopRequested_ = true;
+    }
+    idleCv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+        const Report r = report();
+        qDebug() << "SyntheticBackend: generated" << r.generated << "events in" << r.elapsedSec << "s ("
+                 << r.generatedPerSec << "/s), dropped mouse" << r.droppedMouse << "key" << r.droppedKey
+                 << ", queue high-water mouse" << r.mouseHighWater << "key" << r.keyHighWater;
+    }
+    engine_ = nullptr;
+}
+
+SyntheticBackend::Report SyntheticBackend::report() const
+{
+    Report r;
+    r.generated = generated_.load();
+    const qint64 end = finished_.load() ? endNs_.load() : captureTimestampNs();
+    r.elapsedSec = (end - startNs_.load()) / 1e9;
+    r.generatedPerSec = r.elapsedSec > 0.0 ? r.generated / r.elapsedSec : 0.0;
+
+    const CaptureEngine::Stats s = CaptureEngine::instance().stats();
+    r.droppedMouse = s.droppedMouse;
+    r.droppedKey = s.droppedKey;
+    r.mouseHighWater = s.mouseHighWater;
+    r.keyHighWater = s.keyHighWater;
+    return r;
+}
+
+// ======================== 生成线程 ========================
+void SyntheticBackend::generateLoop()
+{
+    // 与真实后端一样按配置设置线程优先级和亲和性，压测结果才有可比性
+    applyThreadConfig();
+
+    if (config_.workload == Workload::Idle) {
+        idleLoop();
+        return;
+    }
+
+    EventGenerator gen(config_.workload, config_.seed, relativeMotion());
+    const double periodNs = 1e9 / config_.rateHz;
+    const quint64 limit = config_.durationMs > 0
+            ? static_cast<quint64>(config_.rateHz * config_.durationMs / 1000.0)
+            : std::numeric_limits<quint64>::max();
+
+    const qint64 t0 = captureTimestampNs();
+    startNs_ = t0;
+    quint64 i = 0;
+
+    while (!stopRequested_.load(std::memory_order_relaxed) && i < limit) {
+        // 按已经过去的时间计算「此刻应该生成到第几个事件」，领先则休眠，落后则连续补齐
+        const qint64 now = captureTimestampNs();
+        quint64 due = static_cast<quint64>((now - t0) / periodNs) + 1;
+        if (due > limit) due = limit;
+        if (i >= due) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+
+        const quint64 chunkEnd = (due - i > kMaxChunk) ? i + kMaxChunk : due;
+        for (; i < chunkEnd; ++i)
+            gen.emitNext(*engine_, t0 + static_cast<qint64>(i * periodNs));
+        generated_.store(i, std::memory_order_relaxed);
+    }
+
+    endNs_ = captureTimestampNs();
+    finished_ = true;
+}
+
+void SyntheticBackend::idleLoop()
+{
+    startNs_ = captureTimestampNs();
+    {
+        // 整个空闲期只有一次等待：到时或 stop() 才醒来
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        const auto stopped = [this] { return stopRequested_.load(); };
+        if (config_.durationMs > 0)
+            idleCv_.wait_for(lock, std::chrono::milliseconds(config_.durationMs), stopped);
+        else
+            idleCv_.wait(lock, stopped);
+    }
+    endNs_ = captureTimestampNs();
+    finished_ = true;
+}
@@ -0,0 +1,81 @@
+#ifndef SYNTHETICBACKEND_H
+#define SYNTHETICBACKEND_H
+
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "capturebackend.h"
+
+/**
+ * @brief 合成输入后端（压力测试用）
+ *
+ * 按配置的速率生成可复现的事件流（固定随机种子），不需要真人操作鼠标键盘，
+ * 用来测量 CaptureEngine → Recorder → RecorderWorker 整条流水线能承受的吞吐量。
+ *
+ * - 时间戳按理想节拍生成（起始时刻 + i × 周期），生成线程落后时延迟会体现在下游统计中；
+ * - 速率很高时按批生成，领先于节拍时短暂休眠，可以达到每秒数百万事件；
+ * - stop() 或达到设定时长后停止，report() 给出生成数量、实际速率以及引擎侧的丢弃数和队列高水位；
+ * - Idle 负载不生成任何事件，生成线程一直阻塞到 stop() 或到时，用来检查空闲时引擎各线程是否还在醒来。
+ */
+class SyntheticBackend : public CaptureBackend
+{
+public:
+    enum class Workload {
+        MouseMove,     // 匀速画圆的鼠标移动
+        TypingBurst,   // 连续打字（按下/抬起成对出现）
+        ClickStorm,    // 左键连点
+        Mixed,         // 约 90% 移动 + 5% 按键 + 5% 点击
+        Idle           // 不生成事件
+    };
+
+    struct Config {
+        Workload workload = Workload::Mixed;
+        double rateHz = 1000.0;   // 每秒生成的事件数
+        int durationMs = 0;       // 0 表示一直运行到 stop()
+        quint32 seed = 1;
+    };
+
+    struct Report {
+        quint64 generated = 0;
+        double elapsedSec = 0.0;
+        double generatedPerSec = 0.0;
+        quint64 droppedMouse = 0;
+        quint64 droppedKey = 0;
+        quint64 mouseHighWater = 0;
+        quint64 keyHighWater = 0;
+    };
+
+    explicit SyntheticBackend(const Config& config);
+    ~SyntheticBackend() override;
+
+    // 解析命令行形式的配置："<workload>[:<rateHz>[:<seconds>]]"，例如 "mixed:100000:10"
+    static bool parseSpec(const QString& spec, Config& out);
+
+    const char* name() const override { return "synthetic"; }
+    bool supportsRelativeMotion() const override { return true; }
+    bool start(CaptureEngine& engine) override;
+    void stop() override;
+
+    bool isFinished() const { return finished_.load(); }
+    Report report() const;
+
+private:
+    void generateLoop();
+    void idleLoop();
+
+private:
+    Config config_;
+    CaptureEngine* engine_ = nullptr;
+    std::thread thread_;
+    std::atomic<bool> stopRequested_{false};
+    std::mutex idleMutex_;                // Idle 负载的等待，stop() 持锁置位后通知
+    std::condition_variable idleCv_;
+    std::atomic<bool> finished_{false};
+    std::atomic<quint64> generated_{0};
+    std::atomic<qint64> startNs_{0};
+    std::atomic<qint64> endNs_{0};
+};
+
+#endif // SYNTHETICBACKEND_H
@@ -0,0 +1,225 @@
+#include "winhookbackend.h"
+#include "captureengine.h"
+#include "inputcodes.h"
+#include <QDebug>
+
+#pragma comment(lib, "user32.lib")
+
+// 旧版 SDK 没有定义 RI_MOUSE_HWHEEL
+#ifdef RI_MOUSE_HWHEEL
+static constexpr USHORT kRawMouseHWheel = RI_MOUSE_HWHEEL;
+#else
+static constexpr USHORT kRawMouseHWheel = 0x0800;
+#endif
+
+// 注入标志：低完整性级别进程注入的事件另有一位，两位都算（旧版 SDK 没有定义 *_LOWER_IL_INJECTED）
+static constexpr DWORD kMouseInjectedFlags = LLMHF_INJECTED | 0x00000002;   // LLMHF_LOWER_IL_INJECTED
+static constexpr DWORD kKeyInjectedFlags = LLKHF_INJECTED | 0x00000002;     // LLKHF_LOWER_IL_INJECTED
+
+// 低层钩子回调必须是静态函数，拿不到 this；同一时刻只有一个钩子后端在运行，
+// 用文件内静态指针把回调转发给当前实例
+static WinHookBackend* s_activeBackend = nullptr;
+
+WinHookBackend::~WinHookBackend()
+{
+    stop();
+}
+
+// ======================== 启动与停止 ========================
+bool WinHookBackend::start(CaptureEngine& engine)
+{
+    if (thread_.joinable()) return true;
+
+    engine_ = &engine;
+    s_activeBackend = this;
+    hooksInstalled_ = false;
+
+    // 等捕获线程报告钩子是否安装成功，start() 的返回值才有意义
+    readyEvent_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    thread_ = std::thread(&WinHookBackend::hookThread, this);
+    WaitForSingleObject(readyEvent_, INFINITE);
+    CloseHandle(readyEvent_);
+    readyEvent_ = nullptr;
+
+    if (!hooksInstalled_) {
+        qWarning() << "Failed to install hooks!";
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void WinHookBackend::stop()
+{
+    // 让捕获线程退出消息循环，由它自己卸载钩子（UnhookWindowsHookEx）并将钩子句柄置空
+    if (thread_.joinable()) {
+        PostThreadMessage(threadId_, WM_QUIT, 0, 0);
+        thread_.join();
+    }
+    threadId_ = 0;
+
+    if (s_activeBackend == this)
+        s_activeBackend = nullptr;
+    engine_ = nullptr;
+}
+
+// ======================== 捕获线程 ========================
+void WinHookBackend::hookThread()
+{
+    applyThreadConfig();
+
+    // 先调用一次 PeekMessage 让系统为本线程创建消息队列，之后 stop() 的 PostThreadMessage 才不会丢失
+    MSG msg;
+    PeekMessage(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+    threadId_ = GetCurrentThreadId();
+
+    HINSTANCE hInst = GetModuleHandle(nullptr);
+    mouseHook_ = SetWindowsHookEx(WH_MOUSE_LL, mouseProc, hInst, 0);
+    keyboardHook_ = SetWindowsHookEx(WH_KEYBOARD_LL, keyboardProc, hInst, 0);
+    hooksInstalled_ = mouseHook_ && keyboardHook_ && (!relativeMotion() || registerRawInput());
+    SetEvent(readyEvent_);
+
+    // 低层钩子的回调在本线程取消息时被调用；除此之外这个线程没有别的工作
+    if (hooksInstalled_) {
+        while (GetMessage(&msg, nullptr, 0, 0) > 0) {
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+    }
+
+    unregisterRawInput();
+    if (mouseHook_)
+        UnhookWindowsHookEx(mouseHook_);
+    if (keyboardHook_)
+        UnhookWindowsHookEx(keyboardHook_);
+    mouseHook_ = nullptr;
+    keyboardHook_ = nullptr;
+}
+
+// ======================== Raw Input（相对运动模式） ========================
+static const wchar_t kRawInputWindowClass[] = L"MouseKeyboardCaptureRawInput";
+
+bool WinHookBackend::registerRawInput()
+{
+    HINSTANCE hInst = GetModuleHandle(nullptr);
+    WNDCLASSEXW wc{};
+    wc.cbSize = sizeof(wc);
+    wc.lpfnWndProc = rawInputWndProc;
+    wc.hInstance = hInst;
+    wc.lpszClassName = kRawInputWindowClass;
+    RegisterClassExW(&wc);   // 重复注册会失败，但已存在的类照样可用
+
+    rawInputWindow_ = CreateWindowExW(0, kRawInputWindowClass, L"", 0, 0, 0, 0, 0,
+                                      HWND_MESSAGE, nullptr, hInst, nullptr);
+    if (!rawInputWindow_) {
+        qWarning() << "WinHookBackend: cannot create raw input window:" << GetLastError();
+        return false;
+    }
+
+    // 通用桌面控件页（0x01）的鼠标（0x02）；INPUTSINK 让窗口在后台也能收到 WM_INPUT
+    RAWINPUTDEVICE rid{};
+    rid.usUsagePage = 0x01;
+    rid.usUsage = 0x02;
+    rid.dwFlags = RIDEV_INPUTSINK;
+    rid.hwndTarget = rawInputWindow_;
+    if (!RegisterRawInputDevices(&rid, 1, sizeof(rid))) {
+        qWarning() << "WinHookBackend: RegisterRawInputDevices failed:" << GetLastError();
+        DestroyWindow(rawInputWindow_);
+        rawInputWindow_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void WinHookBackend::unregisterRawInput()
+{
+    if (!rawInputWindow_)
+        return;
+    RAWINPUTDEVICE rid{};
+    rid.usUsagePage = 0x01;
+    rid.usUsage = 0x02;
+    rid.dwFlags = RIDEV_REMOVE;
+    rid.hwndTarget = nullptr;
+    RegisterRawInputDevices(&rid, 1, sizeof(rid));
+    DestroyWindow(rawInputWindow_);
+    rawInputWindow_ = nullptr;
+}
+
+LRESULT CALLBACK WinHookBackend::rawInputWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    WinHookBackend* self = s_activeBackend;
+    if (msg == WM_INPUT && self)
+        self->handleRawInput(reinterpret_cast<HRAWINPUT>(lParam));
+    // WM_INPUT 也必须交给 DefWindowProc，系统才会释放这条原始输入
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+void WinHookBackend::handleRawInput(HRAWINPUT handle)
+{
+    RAWINPUT raw;
+    UINT size = sizeof(raw);
+    if (GetRawInputData(handle, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1)
+            || raw.header.dwType != RIM_TYPEMOUSE)
+        return;
+
+    const RAWMOUSE& m = raw.data.mouse;
+    const qint64 ts = captureTimestampNs();
+    // SendInput 注入的鼠标输入没有来源设备，hDevice 为空
+    const EventFlags flags = raw.header.hDevice ? 0 : EventFlag::Injected;
+
+    if (m.usFlags & MOUSE_MOVE_ABSOLUTE) {
+        // 数位板、远程桌面等绝对坐标设备没有原始位移，记录当前光标位置
+        POINT pt;
+        if (GetCursorPos(&pt))
+            engine_->enqueueMouseEvent(MouseEventData{ static_cast<qint32>(pt.x), static_cast<qint32>(pt.y), InputCode::MouseMove, flags, 0, ts });
+    } else if (m.lLastX != 0 || m.lLastY != 0) {
+        engine_->enqueueMouseEvent(MouseEventData{ static_cast<qint32>(m.lLastX), static_cast<qint32>(m.lLastY),
+                                                        InputCode::RawMotion, flags, 0, ts });
+    }
+
+    // usButtonData 是有符号的滚动量，单位与 WHEEL_DELTA 相同
+    const qint32 wheel = static_cast<SHORT>(m.usButtonData);
+    if (m.usButtonFlags & RI_MOUSE_WHEEL)
+        engine_->enqueueMouseEvent(MouseEventData{ wheel, 0, InputCode::RawWheel, flags, 0, ts });
+    if (m.usButtonFlags & kRawMouseHWheel)
+        engine_->enqueueMouseEvent(MouseEventData{ wheel, 0, InputCode::RawHWheel, flags, 0, ts });
+}
+
+// ======================== 鼠标回调 ========================
+// 钩子线程只负责“最快地”把事件塞进队列；
+LRESULT CALLBACK WinHookBackend::mouseProc(int nCode, WPARAM wParam, LPARAM lParam)
+{
+    WinHookBackend* self = s_activeBackend;
+    // 相对运动模式下移动和滚轮由 Raw Input 记录，钩子只记录按钮
+    const bool fromRawInput = self && self->rawInputWindow_
+            && (wParam == WM_MOUSEMOVE || wParam == WM_MOUSEWHEEL || wParam == WM_MOUSEHWHEEL);
+    if (nCode >= 0 && lParam && self && !fromRawInput) {
+        MSLLHOOKSTRUCT* pMouse = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
+
+        // 捕获时刻立即打时间戳（单调时钟，纳秒），之后的排队延迟不会计入录制时序。
+        // 这里不做任何节流：WM_MOUSEMOVE 的精简由工作线程中的 MousePathSimplifier 完成。
+        // 低层钩子不携带设备信息，deviceId 固定为 0；SendInput 等注入的事件由系统置 LLMHF_INJECTED
+        const EventFlags flags = (pMouse->flags & kMouseInjectedFlags) ? EventFlag::Injected : 0;
+        MouseEventData data{ static_cast<qint32>(pMouse->pt.x), static_cast<qint32>(pMouse->pt.y),
+                             static_cast<quint32>(wParam), flags, 0, captureTimestampNs() };
+        self->engine_->enqueueMouseEvent(data);
+    }
+
+    return CallNextHookEx(nullptr, nCode, wParam, lParam);
+}
+
+// ======================== 键盘回调 ========================
+LRESULT CALLBACK WinHookBackend::keyboardProc(int nCode, WPARAM wParam, LPARAM lParam)
+{
+    WinHookBackend* self = s_activeBackend;
+    if (nCode >= 0 && lParam && self) {
+        KBDLLHOOKSTRUCT* pKey = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
+
+        bool isDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+        const EventFlags flags = (pKey->flags & kKeyInjectedFlags) ? EventFlag::Injected : 0;
+        KeyEventData data{ static_cast<quint32>(pKey->vkCode), isDown, flags, 0, captureTimestampNs() };
+        self->engine_->enqueueKeyEvent(data);
+    }
+
+    return CallNextHookEx(nullptr, nCode, wParam, lParam);
+}
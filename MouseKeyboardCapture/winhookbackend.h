@@ -0,0 +1,52 @@
+#ifndef WINHOOKBACKEND_H
+#define WINHOOKBACKEND_H
+
+#include <Windows.h>
+#include <atomic>
+#include <thread>
+#include "capturebackend.h"
+
+/**
+ * @brief Windows 低层钩子捕获后端（WH_MOUSE_LL / WH_KEYBOARD_LL）
+ * 钩子回调运行在安装钩子的线程上，回调里只打时间戳、入队，不做其它事情。
+ *
+ * 钩子安装在后端自己的捕获线程上，由该线程的 GetMessage 循环分发回调；
+ * 这样 GUI 线程忙于刷新日志或弹出对话框时，不会拖慢整个系统的输入分发。
+ *
+ * 相对运动模式下，同一线程再创建一个 message-only 窗口注册 Raw Input（RIDEV_INPUTSINK），
+ * 鼠标位移和滚轮取自 WM_INPUT 中设备上报的原始值；钩子只负责按钮和键盘，不再记录移动和滚轮。
+ */
+class WinHookBackend : public CaptureBackend
+{
+public:
+    WinHookBackend() = default;
+    ~WinHookBackend() override;
+
+    const char* name() const override { return "winhook"; }
+    bool supportsRelativeMotion() const override { return true; }
+    bool start(CaptureEngine& engine) override;
+    void stop() override;
+
+private:
+    void hookThread();   // 捕获线程：安装钩子、运行消息循环，收到 WM_QUIT 后卸载钩子
+    bool registerRawInput();
+    void unregisterRawInput();
+    void handleRawInput(HRAWINPUT handle);
+
+    static LRESULT CALLBACK mouseProc(int nCode, WPARAM wParam, LPARAM lParam);
+    static LRESULT CALLBACK keyboardProc(int nCode, WPARAM wParam, LPARAM lParam);
+    static LRESULT CALLBACK rawInputWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+private:
+    HHOOK mouseHook_ = nullptr;
+    HHOOK keyboardHook_ = nullptr;
+    CaptureEngine* engine_ = nullptr;
+    HWND rawInputWindow_ = nullptr;   // 仅相对运动模式下创建
+
+    std::thread thread_;
+    DWORD threadId_ = 0;
+    HANDLE readyEvent_ = nullptr;         // 捕获线程装好（或装失败）钩子后置位
+    std::atomic<bool> hooksInstalled_{false};
+};
+
+#endif // WINHOOKBACKEND_H